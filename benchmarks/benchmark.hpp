@@ -0,0 +1,272 @@
+#ifndef DCGP_BENCHMARK_H
+#define DCGP_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <dcgp/config.hpp>
+
+namespace dcgp_benchmarks
+{
+
+/// Parameters of a benchmark, as (name, value) pairs in a fixed order
+using parameters = std::vector<std::pair<std::string, std::string>>;
+
+/// The \p q quantile (0 <= q <= 1) of \p values, interpolating linearly between them (NaN if there are none)
+inline double quantile(std::vector<double> values, double q)
+{
+    if (values.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::sort(values.begin(), values.end());
+    const auto pos = q * static_cast<double>(values.size() - 1u);
+    const auto lower = static_cast<std::size_t>(std::floor(pos));
+    const auto upper = std::min(lower + 1u, values.size() - 1u);
+    return values[lower] + (pos - static_cast<double>(lower)) * (values[upper] - values[lower]);
+}
+
+/// Timings of a benchmark
+struct result {
+    /// The benchmark name (e.g. "evaluate")
+    std::string name;
+    /// The benchmark parameters
+    parameters params;
+    /// Number of evaluations (points, mutations, ...) performed in each repetition
+    std::size_t evaluations;
+    /// Wall clock time of each repetition, in seconds
+    std::vector<double> times;
+
+    /// Unique identifier of the benchmark: its name followed by its parameters
+    std::string id() const
+    {
+        std::string retval = name;
+        for (const auto &p : params) {
+            retval += " " + p.first + "=" + p.second;
+        }
+        return retval;
+    }
+
+    /// The \p q quantile (0 <= q <= 1) of the times
+    double quantile(double q) const
+    {
+        return dcgp_benchmarks::quantile(times, q);
+    }
+
+    /// Evaluations per second, from the median time
+    double throughput() const
+    {
+        return static_cast<double>(evaluations) / quantile(0.5);
+    }
+};
+
+/// Options of a benchmark run
+struct options {
+    /// Untimed runs before the repetitions (caches, branch predictors, allocations)
+    unsigned warmup = 3u;
+    /// Timed runs
+    unsigned repetitions = 15u;
+    /// Only the benchmarks whose id contains this string are run
+    std::string filter;
+};
+
+// Escapes a string for JSON
+inline std::string json_string(const std::string &s)
+{
+    std::string retval = "\"";
+    for (auto c : s) {
+        if (c == '"' || c == '\\') {
+            retval += '\\';
+        }
+        retval += c;
+    }
+    return retval + "\"";
+}
+
+// The current date and time (UTC) in ISO 8601 format
+inline std::string utc_date()
+{
+    const auto now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return date;
+}
+
+/// Reads the throughputs of a benchmark run
+/**
+ * @param[in] filename a JSON file written by dcgp_benchmarks::suite::write_json()
+ *
+ * @return the evaluations per second of each benchmark, by id
+ *
+ * @throw std::runtime_error if the file cannot be read or is not in the expected format
+ */
+inline std::map<std::string, double> read_throughputs(const std::string &filename)
+{
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Could not open the file " + filename);
+    }
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::map<std::string, double> retval;
+    const std::string id_key = "\"id\": \"", throughput_key = "\"evaluations_per_second\": ";
+    for (auto pos = content.find(id_key); pos != std::string::npos; pos = content.find(id_key, pos)) {
+        std::string id;
+        for (pos += id_key.size(); pos < content.size() && content[pos] != '"'; ++pos) {
+            if (content[pos] == '\\') {
+                ++pos;
+            }
+            id += content[pos];
+        }
+        pos = content.find(throughput_key, pos);
+        if (pos == std::string::npos) {
+            throw std::runtime_error("The benchmark " + id + " in " + filename + " has no throughput");
+        }
+        pos += throughput_key.size();
+        retval[id] = std::strtod(content.c_str() + pos, nullptr);
+    }
+    if (retval.empty()) {
+        throw std::runtime_error("No benchmarks found in " + filename);
+    }
+    return retval;
+}
+
+/// A collection of benchmarks
+/**
+ * Each benchmark is a callable performing a fixed amount of work (a number of evaluations). It is run
+ * some times without timing (warmup), then timed over a number of repetitions. The statistics of the
+ * timings (median and percentiles, which are robust to the outliers of a busy machine) are printed as
+ * they are collected and can be written in JSON to track performance across versions.
+ */
+class suite
+{
+public:
+    /// Constructor
+    explicit suite(const options &opts) : m_options(opts)
+    {
+        if (opts.repetitions == 0u) {
+            throw std::invalid_argument("At least one repetition is needed");
+        }
+    }
+
+    /// Runs a benchmark
+    /**
+     * @param[in] name the benchmark name
+     * @param[in] params the benchmark parameters
+     * @param[in] evaluations the number of evaluations performed by each call to \p f
+     * @param[in] f callable with prototype void() doing the work to be timed. Any setup must be done
+     * before, as everything in \p f is timed.
+     */
+    template <typename F>
+    void run(const std::string &name, const parameters &params, std::size_t evaluations, const F &f)
+    {
+        result r{name, params, evaluations, {}};
+        if (r.id().find(m_options.filter) == std::string::npos) {
+            return;
+        }
+        for (auto i = 0u; i < m_options.warmup; ++i) {
+            f();
+        }
+        for (auto i = 0u; i < m_options.repetitions; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const auto stop = std::chrono::steady_clock::now();
+            r.times.push_back(std::chrono::duration<double>(stop - start).count());
+        }
+        std::cout << std::left << std::setw(90) << r.id() << std::right << std::scientific << std::setprecision(3)
+                  << " median " << r.quantile(0.5) << " s, p10 " << r.quantile(0.1) << " s, p90 "
+                  << r.quantile(0.9) << " s, " << r.throughput() << " evals/s" << std::endl;
+        m_results.push_back(std::move(r));
+    }
+
+    /// Gets the results
+    const std::vector<result> &get_results() const
+    {
+        return m_results;
+    }
+
+    /// Compares the results with a baseline
+    /**
+     * A benchmark regressed if its throughput is less than (1 - \p tolerance) times the one in the baseline.
+     * The throughputs are computed from the median timings, so that a few repetitions disturbed by other
+     * processes do not trigger a regression. Benchmarks missing in the baseline are reported but not
+     * compared.
+     *
+     * @param[in] baseline the throughputs of the baseline, by id (see dcgp_benchmarks::read_throughputs())
+     * @param[in] tolerance the slowdown accepted as noise (e.g. 0.25 for 25%)
+     * @param[in] os the stream where the comparison is reported
+     *
+     * @return the number of benchmarks that regressed
+     */
+    unsigned compare(const std::map<std::string, double> &baseline, double tolerance, std::ostream &os) const
+    {
+        unsigned regressions = 0u;
+        os << std::fixed << std::setprecision(2);
+        for (const auto &r : m_results) {
+            const auto it = baseline.find(r.id());
+            if (it == baseline.end()) {
+                os << "NOT IN BASELINE " << r.id() << std::endl;
+                continue;
+            }
+            const auto ratio = r.throughput() / it->second;
+            const bool regressed = ratio < 1. - tolerance;
+            regressions += regressed;
+            os << (regressed ? "REGRESSION      " : "ok              ") << r.id() << ": " << ratio
+               << "x the baseline throughput" << std::endl;
+        }
+        os << regressions << " regressions (tolerance " << tolerance << ")" << std::endl;
+        return regressions;
+    }
+
+    /// Writes the results in JSON
+    void write_json(std::ostream &os) const
+    {
+        os << std::setprecision(17);
+        os << "{\n  \"dcgp_version\": " << json_string(DCGP_VERSION_STRING) << ",\n";
+        os << "  \"date\": " << json_string(utc_date()) << ",\n";
+        os << "  \"warmup\": " << m_options.warmup << ",\n";
+        os << "  \"repetitions\": " << m_options.repetitions << ",\n";
+        os << "  \"benchmarks\": [";
+        for (decltype(m_results.size()) i = 0u; i < m_results.size(); ++i) {
+            const auto &r = m_results[i];
+            os << (i ? ",\n" : "\n") << "    {\n      \"id\": " << json_string(r.id()) << ",\n";
+            os << "      \"name\": " << json_string(r.name) << ",\n      \"params\": {";
+            for (decltype(r.params.size()) j = 0u; j < r.params.size(); ++j) {
+                os << (j ? ", " : "") << json_string(r.params[j].first) << ": " << json_string(r.params[j].second);
+            }
+            os << "},\n      \"evaluations\": " << r.evaluations << ",\n";
+            os << "      \"median_s\": " << r.quantile(0.5) << ",\n";
+            os << "      \"p10_s\": " << r.quantile(0.1) << ",\n";
+            os << "      \"p90_s\": " << r.quantile(0.9) << ",\n";
+            os << "      \"min_s\": " << r.quantile(0.) << ",\n";
+            os << "      \"max_s\": " << r.quantile(1.) << ",\n";
+            os << "      \"mean_s\": "
+               << std::accumulate(r.times.begin(), r.times.end(), 0.) / static_cast<double>(r.times.size())
+               << ",\n";
+            os << "      \"evaluations_per_second\": " << r.throughput() << "\n    }";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+private:
+    options m_options;
+    std::vector<result> m_results;
+};
+
+} // namespace dcgp_benchmarks
+
+#endif // DCGP_BENCHMARK_H
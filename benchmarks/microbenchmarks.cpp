@@ -0,0 +1,348 @@
+// Microbenchmarks of the basic dCGP operations (evaluation, differentiation, mutation, fitness) over
+// sweeps of the expression parameters, the kernel sets, the value types and the dataset sizes.
+//
+// Usage: microbenchmarks [--output results.json] [--warmup K] [--repetitions K] [--filter text]
+//                        [--compare baseline.json] [--tolerance 0.25]
+//
+// With --compare the throughputs are compared with those in a previous output, and the program fails
+// if some benchmark regressed beyond the tolerance.
+#include <audi/audi.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dcgp/dcgp.hpp>
+
+#include "benchmark.hpp"
+
+using namespace dcgp_benchmarks;
+
+namespace
+{
+
+// Keeps the compiler from optimizing away the benchmarked computations
+volatile double sink;
+
+struct shape {
+    unsigned n, m, r, c, l, arity;
+};
+
+const std::vector<shape> shapes = {{2u, 4u, 2u, 3u, 4u, 2u},    {2u, 4u, 10u, 10u, 11u, 2u}, {2u, 4u, 20u, 20u, 21u, 2u},
+                                   {1u, 1u, 1u, 100u, 101u, 2u}, {1u, 1u, 3u, 100u, 101u, 2u}, {3u, 1u, 2u, 30u, 31u, 3u}};
+
+const std::vector<std::vector<std::string>> kernel_sets
+    = {{"sum", "diff", "mul", "div"}, {"sum", "mul", "sig"}, {"sum", "diff", "mul", "pdiv", "sin", "cos", "exp", "log"}};
+
+std::string join(const std::vector<std::string> &names)
+{
+    std::string retval;
+    for (const auto &name : names) {
+        retval += (retval.empty() ? "" : ",") + name;
+    }
+    return retval;
+}
+
+parameters shape_parameters(const shape &s, const std::vector<std::string> &kernels)
+{
+    return {{"n", std::to_string(s.n)}, {"m", std::to_string(s.m)},         {"r", std::to_string(s.r)},
+            {"c", std::to_string(s.c)}, {"l", std::to_string(s.l)},         {"arity", std::to_string(s.arity)},
+            {"kernels", join(kernels)}};
+}
+
+// Uniform random points in [-1, 1], as columns
+std::vector<std::vector<double>> random_columns(unsigned n, std::size_t N, std::default_random_engine &re)
+{
+    std::vector<std::vector<double>> retval(n, std::vector<double>(N));
+    for (auto &column : retval) {
+        for (auto &value : column) {
+            value = std::uniform_real_distribution<double>(-1., 1.)(re);
+        }
+    }
+    return retval;
+}
+
+void evaluation_benchmarks(suite &s)
+{
+    std::default_random_engine re(123u);
+    for (const auto &kernels : kernel_sets) {
+        dcgp::kernel_set<double> ks(kernels);
+        for (const auto &sh : shapes) {
+            dcgp::expression<double> ex(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks(), 123u);
+            // One point at a time
+            const std::size_t N = 10000u;
+            auto columns = random_columns(sh.n, N, re);
+            std::vector<std::vector<double>> points(N, std::vector<double>(sh.n));
+            for (std::size_t k = 0u; k < N; ++k) {
+                for (auto i = 0u; i < sh.n; ++i) {
+                    points[k][i] = columns[i][k];
+                }
+            }
+            auto params = shape_parameters(sh, kernels);
+            params.emplace_back("type", "double");
+            params.emplace_back("mode", "point");
+            params.emplace_back("points", std::to_string(N));
+            s.run("evaluate", params, N, [&ex, &points]() {
+                for (const auto &point : points) {
+                    sink = ex(point)[0];
+                }
+            });
+            // Batches, for increasing dataset sizes
+            for (std::size_t points_batch : {1000u, 100000u}) {
+                auto in = random_columns(sh.n, points_batch, re);
+                std::vector<std::vector<double>> out(sh.m, std::vector<double>(points_batch));
+                std::vector<const double *> in_ptr;
+                std::vector<double *> out_ptr;
+                for (const auto &column : in) {
+                    in_ptr.push_back(column.data());
+                }
+                for (auto &column : out) {
+                    out_ptr.push_back(column.data());
+                }
+                params[params.size() - 2u].second = "batch";
+                params.back().second = std::to_string(points_batch);
+                s.run("evaluate", params, points_batch, [&ex, &in_ptr, &out_ptr, points_batch]() {
+                    ex(in_ptr, out_ptr, points_batch);
+                    sink = out_ptr[0][0];
+                });
+            }
+        }
+    }
+}
+
+void differentiation_benchmarks(suite &s)
+{
+    std::default_random_engine re(123u);
+    for (const auto &kernels : kernel_sets) {
+        dcgp::kernel_set<audi::gdual_d> ks(kernels);
+        for (const auto &sh : shapes) {
+            dcgp::expression<audi::gdual_d> ex(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks(), 123u);
+            for (unsigned order : {1u, 2u}) {
+                const std::size_t N = 1000u;
+                std::vector<std::vector<audi::gdual_d>> points(N);
+                for (auto &point : points) {
+                    for (auto i = 0u; i < sh.n; ++i) {
+                        point.emplace_back(std::uniform_real_distribution<double>(-1., 1.)(re),
+                                           "x" + std::to_string(i), order);
+                    }
+                }
+                auto params = shape_parameters(sh, kernels);
+                params.emplace_back("type", "gdual_d");
+                params.emplace_back("order", std::to_string(order));
+                params.emplace_back("points", std::to_string(N));
+                s.run("evaluate", params, N, [&ex, &points]() {
+                    for (const auto &point : points) {
+                        sink = ex(point)[0].constant_cf();
+                    }
+                });
+            }
+        }
+    }
+    // The same points, evaluated at once with vectorized gduals
+    re.seed(123u);
+    for (const auto &kernels : kernel_sets) {
+        dcgp::kernel_set<audi::gdual_v> ks(kernels);
+        for (const auto &sh : shapes) {
+            dcgp::expression<audi::gdual_v> ex(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks(), 123u);
+            for (unsigned order : {1u, 2u}) {
+                const std::size_t N = 1000u;
+                std::vector<std::string> symbols;
+                for (auto i = 0u; i < sh.n; ++i) {
+                    symbols.push_back("x" + std::to_string(i));
+                }
+                const auto grid = dcgp::grid_inputs(random_columns(sh.n, N, re), symbols, order);
+                auto params = shape_parameters(sh, kernels);
+                params.emplace_back("type", "gdual_v");
+                params.emplace_back("order", std::to_string(order));
+                params.emplace_back("points", std::to_string(N));
+                s.run("evaluate", params, N, [&ex, &grid]() { sink = ex(grid)[0].constant_cf()[0]; });
+            }
+        }
+    }
+}
+
+// The transcendental kernels alone, exact and fast, on batches of points
+void kernel_benchmarks(suite &s)
+{
+    std::default_random_engine re(123u);
+    const std::size_t N = 100000u;
+    // Arguments in [-10, 10] for the exponential, the sigmoid sums both inputs
+    auto in = random_columns(2u, N, re);
+    for (auto &value : in[0]) {
+        value *= 10.;
+    }
+    std::vector<double> out(N);
+    for (const std::string name : {"sig", "fast_sig", "exp", "fast_exp"}) {
+        auto k = dcgp::kernel_set<double>({name})[0];
+        std::vector<const double *> in_ptr = {in[0].data(), in[1].data()};
+        parameters params = {{"kernel", name}, {"type", "double"}, {"points", std::to_string(N)}};
+        s.run("kernel", params, N, [&k, &in_ptr, &out, N]() {
+            k(in_ptr, out.data(), N);
+            sink = out[0];
+        });
+    }
+}
+
+void mutation_benchmarks(suite &s)
+{
+    for (const auto &kernels : kernel_sets) {
+        dcgp::kernel_set<double> ks(kernels);
+        for (const auto &sh : shapes) {
+            dcgp::expression<double> ex(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks(), 123u);
+            const std::size_t N = 10000u;
+            s.run("mutate_active", shape_parameters(sh, kernels), N, [&ex, N]() {
+                for (std::size_t i = 0u; i < N; ++i) {
+                    ex.mutate_active();
+                }
+            });
+        }
+    }
+}
+
+void fitness_benchmarks(suite &s)
+{
+    std::default_random_engine re(123u);
+    // NOTE: a kernel set without divisions, as non finite values would end the evaluation early
+    dcgp::kernel_set<double> ks(kernel_sets[1]);
+    for (const auto &sh : {shapes[1], shapes[3]}) {
+        dcgp::expression<double> ex(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks(), 123u);
+        for (std::size_t N : {1000u, 10000u, 100000u, 1000000u}) {
+            auto in = random_columns(sh.n, N, re);
+            auto out = random_columns(sh.m, N, re);
+            std::vector<std::vector<double>> in_rows(N, std::vector<double>(sh.n)), out_rows(N, std::vector<double>(sh.m));
+            for (std::size_t k = 0u; k < N; ++k) {
+                for (auto i = 0u; i < sh.n; ++i) {
+                    in_rows[k][i] = in[i][k];
+                }
+                for (auto i = 0u; i < sh.m; ++i) {
+                    out_rows[k][i] = out[i][k];
+                }
+            }
+            dcgp::dataset data(in_rows, out_rows);
+            auto params = shape_parameters(sh, kernel_sets[1]);
+            params.emplace_back("points", std::to_string(N));
+            s.run("quadratic_error", params, N, [&ex, &data]() { sink = dcgp::quadratic_error(ex, data); });
+        }
+    }
+}
+
+// The fitness of an ODE solver, y' = (2x - y) / x (Tsoulos and Lagaris ODE1), computed point by point with
+// gdual_d (extracting the derivatives by name or with a dcgp::derivative_index) and on the whole grid at once
+// with gdual_v
+void differential_fitness_benchmarks(suite &s)
+{
+    const std::vector<std::string> kernels = {"sum", "diff", "mul", "div", "exp"};
+    dcgp::kernel_set<audi::gdual_d> ks_d(kernels);
+    dcgp::kernel_set<audi::gdual_v> ks_v(kernels);
+    for (const auto &sh : {shape{1u, 1u, 1u, 15u, 16u, 2u}, shape{1u, 1u, 1u, 100u, 101u, 2u}}) {
+        dcgp::expression<audi::gdual_d> ex_d(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks_d(), 123u);
+        dcgp::expression<audi::gdual_v> ex_v(sh.n, sh.m, sh.r, sh.c, sh.l, sh.arity, ks_v(), 123u);
+        for (std::size_t N : {10u, 100u, 1000u}) {
+            std::vector<double> x(N);
+            for (std::size_t k = 0u; k < N; ++k) {
+                x[k] = 0.1 + 0.9 * static_cast<double>(k) / static_cast<double>(N);
+            }
+            auto params = shape_parameters(sh, kernels);
+            params.emplace_back("type", "gdual_d");
+            params.emplace_back("points", std::to_string(N));
+            std::vector<std::vector<audi::gdual_d>> points;
+            for (auto value : x) {
+                points.push_back({audi::gdual_d(value, "x", 1u)});
+            }
+            s.run("differential_error", params, N, [&ex_d, &points, &x]() {
+                double retval = 0.;
+                for (decltype(points.size()) k = 0u; k < points.size(); ++k) {
+                    auto T = ex_d(points[k]);
+                    const double err = T[0].get_derivative({{"dx", 1u}}) - (2. * x[k] - T[0].constant_cf()) / x[k];
+                    retval += err * err;
+                }
+                sink = retval / static_cast<double>(points.size());
+            });
+            // The same loop, with the derivatives extracted by position
+            const dcgp::derivative_index idx({"x"}, {{0u, {}}, {0u, {{"dx", 1u}}}});
+            auto index_params = params;
+            index_params.emplace_back("extraction", "index");
+            s.run("differential_error", index_params, N, [&ex_d, &points, &x, &idx]() {
+                double retval = 0.;
+                double d[2];
+                for (decltype(points.size()) k = 0u; k < points.size(); ++k) {
+                    idx(ex_d(points[k]), d);
+                    const double err = d[1] - (2. * x[k] - d[0]) / x[k];
+                    retval += err * err;
+                }
+                sink = retval / static_cast<double>(points.size());
+            });
+            params[params.size() - 2u].second = "gdual_v";
+            const auto grid = dcgp::grid_inputs({x}, {"x"}, 1u);
+            s.run("differential_error", params, N, [&ex_v, &grid, &x]() {
+                sink = dcgp::differential_error(ex_v, grid, {{0u, {}}, {0u, {{"dx", 1u}}}},
+                                                [&x](std::size_t k, const std::vector<double> &d) {
+                                                    return d[1] - (2. * x[k] - d[0]) / x[k];
+                                                });
+            });
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    options opts;
+    std::string output, baseline;
+    double tolerance = 0.25;
+    // Options come in (name, value) pairs
+    bool valid = (argc % 2 == 1);
+    for (int i = 1; valid && i + 1 < argc; i += 2) {
+        const std::string arg(argv[i]), value(argv[i + 1]);
+        if (arg == "--output") {
+            output = value;
+        } else if (arg == "--warmup") {
+            opts.warmup = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--repetitions") {
+            opts.repetitions = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--filter") {
+            opts.filter = value;
+        } else if (arg == "--compare") {
+            baseline = value;
+        } else if (arg == "--tolerance") {
+            tolerance = std::stod(value);
+            valid = (tolerance >= 0. && tolerance < 1.);
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid) {
+        std::cerr << "Usage: " << argv[0] << " [--output results.json] [--warmup K] [--repetitions K] [--filter text]"
+                  << " [--compare baseline.json] [--tolerance 0.25]" << std::endl;
+        return 1;
+    }
+    // The baseline is read first, not to run the benchmarks for nothing if it is invalid
+    std::map<std::string, double> baseline_throughputs;
+    if (!baseline.empty()) {
+        baseline_throughputs = read_throughputs(baseline);
+    }
+    suite s(opts);
+    evaluation_benchmarks(s);
+    differentiation_benchmarks(s);
+    kernel_benchmarks(s);
+    mutation_benchmarks(s);
+    fitness_benchmarks(s);
+    differential_fitness_benchmarks(s);
+    if (!output.empty()) {
+        std::ofstream file(output);
+        s.write_json(file);
+        if (!file) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    if (!baseline.empty()) {
+        return s.compare(baseline_throughputs, tolerance, std::cout) == 0u ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,412 @@
+// Time to solution of a (1 + 4)-ES on standard problems: symbolic regression (the Koza quintic, the
+// symbolic.data and pressure.data datasets), differential equations (Tsoulos ODE1 and NLODE3) and first
+// integrals of Hamiltonian systems (mass spring and Kepler). Each problem is solved in many independent
+// trials, seeded from a base seed and run in parallel, and the success rate and the distributions of the
+// generations and of the wall clock time to reach the target are reported.
+//
+// Usage: time_to_solution [--trials K] [--threads K] [--seed K] [--filter text] [--data-dir path]
+//                         [--output results.json] [--trace trace.json]
+//
+// With --trace the trials, the generations and the fitness evaluations of each thread are written in the
+// Chrome trace-event format (only if dcgp is built with DCGP_ENABLE_TRACE, see dcgp::trace_scope).
+//
+// NOTE: trials running in parallel compete for the memory bandwidth, use --threads 1 for timings
+// comparable to those of a single run.
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <audi/audi.hpp>
+
+#include <dcgp/dcgp.hpp>
+
+#include "benchmark.hpp"
+
+using namespace dcgp_benchmarks;
+using audi::gdual_d;
+
+namespace
+{
+
+// The outcome of a trial
+struct trial {
+    bool success;
+    unsigned generations;
+    double seconds;
+};
+
+// A problem: its name, the fitness to reach, the maximum number of generations and a function
+// running one trial from a seed
+struct problem {
+    std::string name;
+    double target;
+    unsigned max_gen;
+    std::function<trial(const problem &, unsigned)> run;
+};
+
+// (1 + lambda)-ES as in the examples. offspring(ex, cutoff) mutates ex, which is set to the parent, and returns
+// its fitness (or anything worse than cutoff if it is worse than the parent)
+template <typename T, typename F>
+trial evolve(dcgp::expression<T> ex, const F &offspring, const problem &p)
+{
+    const unsigned lambda = 4u;
+    const auto start = std::chrono::steady_clock::now();
+    double best_fit = 1e32;
+    auto best_chromosome = ex.get();
+    std::vector<unsigned> chromosome;
+    unsigned gen = 0u;
+    while (best_fit > p.target && gen < p.max_gen) {
+        dcgp::trace_scope scope("generation", "es");
+        ++gen;
+        const auto parent_fit = best_fit;
+        bool accepted = false;
+        for (auto i = 0u; i < lambda; ++i) {
+            ex.set(best_chromosome);
+            const auto fit = offspring(ex, parent_fit);
+            if (fit <= best_fit) {
+                best_fit = fit;
+                chromosome = ex.get();
+                accepted = true;
+            }
+        }
+        if (accepted) {
+            best_chromosome = chromosome;
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return {best_fit <= p.target, gen, std::chrono::duration<double>(stop - start).count()};
+}
+
+problem supervised(const std::string &name, const dcgp::dataset &data, unsigned r, unsigned c, unsigned l)
+{
+    return {name, 1e-3, 10000u, [data, r, c, l](const problem &p, unsigned seed) {
+                dcgp::kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+                dcgp::expression<double> ex(data.get_n(), data.get_m(), r, c, l, 2u, basic_set(), seed);
+                auto offspring = [&data](dcgp::expression<double> &child, double cutoff) {
+                    child.mutate_active(2u);
+                    return dcgp::quadratic_error(child, data, cutoff);
+                };
+                return evolve(ex, offspring, p);
+            }};
+}
+
+// The Koza quintic x^5 - 2x^3 + x sampled in 10 points, as in the supervised_learning_koza_quintic example
+dcgp::dataset koza_quintic()
+{
+    std::default_random_engine re(12u);
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 10u; ++i) {
+        const auto x = std::uniform_real_distribution<double>(-1., 1.)(re);
+        in.push_back({x});
+        out.push_back({x * x * x * x * x - 2. * x * x * x + x});
+    }
+    return dcgp::dataset(in, out);
+}
+
+// ODE1 of Tsoulos and Lagaris: dy = (2x - y) / x, y(1) = 3, as in the tsoulos_ode1 example
+problem tsoulos_ode1()
+{
+    return {"tsoulos_ode1", 1e-3, 3000u, [](const problem &p, unsigned seed) {
+                dcgp::kernel_set<gdual_d> basic_set({"sum", "diff", "mul", "div", "exp", "log", "sin", "cos"});
+                dcgp::expression<gdual_d> ex(1u, 1u, 1u, 15u, 16u, 2u, basic_set(), seed);
+                std::vector<std::vector<gdual_d>> in(10u);
+                for (auto i = 0u; i < in.size(); ++i) {
+                    in[i].emplace_back(0.1 + 0.9 / static_cast<double>(in.size() - 1u) * i, "x", 1u);
+                }
+                auto offspring = [&in](dcgp::expression<gdual_d> &child, double) {
+                    child.mutate_active(2u);
+                    double retval = 0.;
+                    for (const auto &point : in) {
+                        const auto T = child(point);
+                        const auto y = T[0].get_derivative(std::vector<unsigned>{0u});
+                        const auto dy = T[0].get_derivative(std::vector<unsigned>{1u});
+                        const auto x = point[0].constant_cf();
+                        const auto ode = (2. * x - y) / x;
+                        retval += (ode - dy) * (ode - dy);
+                    }
+                    const auto ic = child(std::vector<gdual_d>{gdual_d(1.)})[0].constant_cf() - 3.;
+                    return retval + ic * ic;
+                };
+                return evolve(ex, offspring, p);
+            }};
+}
+
+// NLODE3 of Tsoulos and Lagaris: d^2y dy = -4 / x^3, as in the tsoulos_nlode3 example
+problem tsoulos_nlode3()
+{
+    return {"tsoulos_nlode3", 1e-3, 10000u, [](const problem &p, unsigned seed) {
+                dcgp::kernel_set<gdual_d> basic_set({"sum", "diff", "mul", "div", "log"});
+                dcgp::expression<gdual_d> ex(1u, 1u, 1u, 15u, 16u, 2u, basic_set(), seed);
+                std::vector<std::vector<gdual_d>> in(10u);
+                for (auto i = 0u; i < in.size(); ++i) {
+                    in[i].emplace_back(1. + 1. / static_cast<double>(in.size() - 1u) * i, "x", 2u);
+                }
+                auto offspring = [&in](dcgp::expression<gdual_d> &child, double) {
+                    child.mutate_active(2u);
+                    double retval = 0.;
+                    for (const auto &point : in) {
+                        const auto T = child(point);
+                        const auto dy = T[0].get_derivative(std::vector<unsigned>{1u});
+                        const auto ddy = T[0].get_derivative(std::vector<unsigned>{2u});
+                        const auto x = point[0].constant_cf();
+                        const auto ode = -4. / x / x / x;
+                        retval += (ode - ddy * dy) * (ode - ddy * dy);
+                    }
+                    const auto ic = child(std::vector<gdual_d>{gdual_d(1.)})[0].constant_cf();
+                    return retval + ic * ic;
+                };
+                return evolve(ex, offspring, p);
+            }};
+}
+
+// Offspring of the "mutation suppression" method of the hamiltonian examples: the child is mutated until
+// it is not a constant or an ignorable variable (check >= 1e-3). fitness(ex, check) computes the fitness
+// and the check. After too many attempts the child is discarded.
+template <typename F>
+double suppressed_offspring(dcgp::expression<gdual_d> &child, unsigned n_mutations, const F &fitness)
+{
+    for (auto attempt = 0u; attempt < 1000u; ++attempt) {
+        child.mutate_active(n_mutations);
+        double check = 0.;
+        const auto retval = fitness(child, check);
+        if (check >= 1e-3) {
+            return retval;
+        }
+    }
+    return std::numeric_limits<double>::infinity();
+}
+
+// First integral of the mass spring system H = 1/2 p^2 + 1/2 q^2, as in the hamiltonian_spring_mass example
+problem hamiltonian_spring_mass()
+{
+    return {"hamiltonian_spring_mass", 1e-12, 10000u, [](const problem &p, unsigned seed) {
+                dcgp::kernel_set<gdual_d> basic_set({"sum", "diff", "mul", "div"});
+                dcgp::expression<gdual_d> ex(2u, 1u, 1u, 15u, 16u, 2u, basic_set(), seed);
+                std::vector<std::vector<gdual_d>> in(10u);
+                for (auto i = 0u; i < in.size(); ++i) {
+                    in[i] = {gdual_d(0.12 + 0.9 / static_cast<double>(in.size() - 1u) * i, "p", 1u),
+                             gdual_d(1. - 0.143 / static_cast<double>(in.size() - 1u) * i, "q", 1u)};
+                }
+                auto fitness = [&in](const dcgp::expression<gdual_d> &child, double &check) {
+                    double retval = 0.;
+                    for (const auto &point : in) {
+                        const auto T = child(point);
+                        const auto dFp = T[0].get_derivative({{"dp", 1u}});
+                        const auto dFq = T[0].get_derivative({{"dq", 1u}});
+                        const auto err = -dFp * point[1].constant_cf() + dFq * point[0].constant_cf();
+                        retval += std::log(1. + std::abs(err));
+                        check += dFp * dFp + dFq * dFq;
+                    }
+                    return retval;
+                };
+                auto offspring = [&fitness](dcgp::expression<gdual_d> &child, double) {
+                    return suppressed_offspring(child, 6u, fitness);
+                };
+                return evolve(ex, offspring, p);
+            }};
+}
+
+// First integrals of the Kepler problem, as in the hamiltonian_kepler example
+problem hamiltonian_kepler()
+{
+    return {"hamiltonian_kepler", 1e-12, 10000u, [](const problem &p, unsigned seed) {
+                dcgp::kernel_set<gdual_d> basic_set({"sum", "diff", "mul", "div"});
+                dcgp::expression<gdual_d> ex(6u, 1u, 1u, 100u, 50u, 2u, basic_set(), seed);
+                const std::vector<std::string> symbols{"pr", "pt", "r", "th", "m", "mu"};
+                std::vector<std::vector<gdual_d>> in(50u);
+                for (auto i = 0u; i < in.size(); ++i) {
+                    const auto step = 20. / static_cast<double>(in.size() - 1u) * i;
+                    for (auto j = 0u; j < symbols.size(); ++j) {
+                        in[i].emplace_back((j % 2u ? 1. : 0.12) + step, symbols[j], 1u);
+                    }
+                }
+                auto fitness = [&in, &symbols](const dcgp::expression<gdual_d> &child, double &check) {
+                    double retval = 0.;
+                    for (const auto &point : in) {
+                        auto T = child(point);
+                        for (const auto &symbol : symbols) {
+                            T[0] += gdual_d(0., symbol, 0u);
+                        }
+                        const auto dFpr = T[0].get_derivative({{"dpr", 1u}});
+                        const auto dFqr = T[0].get_derivative({{"dr", 1u}});
+                        const auto dFqt = T[0].get_derivative({{"dth", 1u}});
+                        const auto pr = point[0].constant_cf(), pt = point[1].constant_cf();
+                        const auto qr = point[2].constant_cf(), m = point[4].constant_cf();
+                        const auto mu = point[5].constant_cf();
+                        const auto err = dFpr * (pt * pt / m / qr / qr / qr - mu / qr / qr) + dFqr * (pr / m)
+                                         + dFqt * (pt / qr / qr / m);
+                        retval += err * err;
+                        check += dFpr * dFpr + dFqr * dFqr + dFqt * dFqt;
+                    }
+                    return retval;
+                };
+                auto offspring = [&fitness](dcgp::expression<gdual_d> &child, double) {
+                    return suppressed_offspring(child, 6u, fitness);
+                };
+                return evolve(ex, offspring, p);
+            }};
+}
+
+// Runs the trials of a problem on n_threads threads. The seeds of the trials are drawn from a generator
+// seeded with seed, so that the trials are independent and reproducible
+std::vector<trial> run_trials(const problem &p, unsigned n_trials, unsigned n_threads, unsigned seed)
+{
+    std::vector<trial> retval(n_trials);
+    // NOTE: not seed + i, as the default random engine gives the same sequence for the seeds 0 and 1
+    std::mt19937 seeder(seed);
+    std::vector<unsigned> seeds(n_trials);
+    for (auto &s : seeds) {
+        s = static_cast<unsigned>(seeder());
+    }
+    std::atomic<unsigned> next(0u);
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < n_threads; ++t) {
+        threads.emplace_back([&]() {
+            for (auto i = next++; i < n_trials; i = next++) {
+                dcgp::trace_scope scope("trial", "benchmark");
+                retval[i] = p.run(p, seeds[i]);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    return retval;
+}
+
+// Writes the median and percentiles of values in JSON (null if there are no values)
+void write_distribution(std::ostream &os, const std::vector<double> &values)
+{
+    if (values.empty()) {
+        os << "null";
+    } else {
+        os << "{\"median\": " << quantile(values, 0.5) << ", \"p10\": " << quantile(values, 0.1)
+           << ", \"p90\": " << quantile(values, 0.9) << "}";
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    unsigned n_trials = 100u, n_threads = std::max(1u, std::thread::hardware_concurrency()), seed = 0u;
+    std::string filter, output, trace, data_dir = DCGP_BENCHMARK_DATA_DIR;
+    bool valid = (argc % 2 == 1);
+    for (int i = 1; valid && i + 1 < argc; i += 2) {
+        const std::string arg(argv[i]), value(argv[i + 1]);
+        if (arg == "--trials") {
+            n_trials = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--threads") {
+            n_threads = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--seed") {
+            seed = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--filter") {
+            filter = value;
+        } else if (arg == "--data-dir") {
+            data_dir = value;
+        } else if (arg == "--output") {
+            output = value;
+        } else if (arg == "--trace") {
+            trace = value;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || n_threads == 0u) {
+        std::cerr << "Usage: " << argv[0] << " [--trials K] [--threads K] [--seed K] [--filter text] [--data-dir path]"
+                  << " [--output results.json] [--trace trace.json]" << std::endl;
+        return 1;
+    }
+
+    std::vector<problem> problems;
+    problems.push_back(supervised("koza_quintic", koza_quintic(), 1u, 15u, 16u));
+    for (const std::string name : {"symbolic", "pressure"}) {
+        if (name.find(filter) != std::string::npos) {
+            problems.push_back(supervised(name, dcgp::dataset::read_csv(data_dir + "/" + name + ".data"), 1u, 15u, 16u));
+        }
+    }
+    problems.push_back(tsoulos_ode1());
+    problems.push_back(tsoulos_nlode3());
+    problems.push_back(hamiltonian_spring_mass());
+    problems.push_back(hamiltonian_kepler());
+
+    std::ostringstream json;
+    json << std::setprecision(17) << "{\n  \"dcgp_version\": " << json_string(DCGP_VERSION_STRING) << ",\n";
+    json << "  \"date\": " << json_string(utc_date()) << ",\n";
+    json << "  \"trials\": " << n_trials << ",\n  \"threads\": " << n_threads << ",\n  \"seed\": " << seed << ",\n";
+    json << "  \"problems\": [";
+    bool first = true;
+    for (const auto &p : problems) {
+        if (p.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        const auto trials = run_trials(p, n_trials, n_threads, seed);
+        std::vector<double> generations, seconds;
+        double total_seconds = 0.;
+        for (const auto &t : trials) {
+            total_seconds += t.seconds;
+            if (t.success) {
+                generations.push_back(t.generations);
+                seconds.push_back(t.seconds);
+            }
+        }
+        // Expected run time: the time spent in all the trials per success, i.e. the expected time to a
+        // solution when restarting failed trials
+        const auto ert = generations.empty() ? std::numeric_limits<double>::infinity()
+                                             : total_seconds / static_cast<double>(generations.size());
+        const auto success_rate = static_cast<double>(generations.size()) / static_cast<double>(n_trials);
+        std::cout << std::left << std::setw(25) << p.name << std::right << std::fixed << std::setprecision(2)
+                  << " success " << std::setw(6) << 100. * success_rate << "%, generations median "
+                  << quantile(generations, 0.5) << " [p10 " << quantile(generations, 0.1) << ", p90 "
+                  << quantile(generations, 0.9) << "]" << std::scientific << ", seconds median "
+                  << quantile(seconds, 0.5) << " [p10 " << quantile(seconds, 0.1) << ", p90 " << quantile(seconds, 0.9)
+                  << "], expected run time " << ert << " s" << std::endl;
+
+        json << (first ? "\n" : ",\n") << "    {\n      \"name\": " << json_string(p.name) << ",\n";
+        json << "      \"target\": " << p.target << ",\n      \"max_generations\": " << p.max_gen << ",\n";
+        json << "      \"successes\": " << generations.size() << ",\n      \"success_rate\": " << success_rate << ",\n";
+        json << "      \"generations\": ";
+        write_distribution(json, generations);
+        json << ",\n      \"seconds\": ";
+        write_distribution(json, seconds);
+        // NOTE: infinity is not valid JSON
+        json << ",\n      \"expected_run_time_s\": ";
+        if (std::isinf(ert)) {
+            json << "null";
+        } else {
+            json << ert;
+        }
+        json << ",\n      \"runs\": [";
+        for (decltype(trials.size()) i = 0u; i < trials.size(); ++i) {
+            json << (i ? ", " : "") << "[" << trials[i].success << ", " << trials[i].generations << ", "
+                 << trials[i].seconds << "]";
+        }
+        json << "]\n    }";
+        first = false;
+    }
+    json << "\n  ]\n}\n";
+    if (!output.empty()) {
+        std::ofstream file(output);
+        file << json.str();
+        if (!file) {
+            std::cerr << "Could not write " << output << std::endl;
+            return 1;
+        }
+    }
+    if (!trace.empty()) {
+        if (!dcgp::trace_enabled()) {
+            std::cerr << "The trace is empty: dcgp was built without DCGP_ENABLE_TRACE" << std::endl;
+        }
+        dcgp::save_trace(trace);
+    }
+    return 0;
+}
@@ -51,12 +51,12 @@ def _graphviz_visualize(self, in_sym = [], draw_inactive = True, draw_weights =
     c = self.get_cols()
     f = self.get_f()
     arity = self.get_arity()
-    active_nodes = self.get_active_nodes()
+    graph = self.get_graph()
 
-    # bool vector of active nodes
-    is_active = [False] * (n + r * c)
-    for i in range(len(active_nodes)):
-        is_active[active_nodes[i]] = True
+    # position of the active function nodes in the graph
+    active = {}
+    for i, node in enumerate(graph["nodes"]):
+        active[int(node)] = i
 
     G = pgv.AGraph(strict = False, directed = True, rankdir = 'LR')
 
@@ -94,21 +94,27 @@ def _graphviz_visualize(self, in_sym = [], draw_inactive = True, draw_weights =
             xlabel = '<x<sub>' + str(i) + '</sub>>'
         G.add_node('n' + str(i), label = xlabel, shape = 'circle', style = 'bold')
 
-    # function nodes and connections
+    # function nodes and connections: the active ones from the graph, the inactive ones from the chromosome
     for i in range(r * c):
-        if is_active[n + i]:
+        if n + i in active:
             nstyle = 'solid'
             estyle = 'solid'
             col = 'black'
-        elif draw_inactive:
-            nstyle = 'dashed'
-            estyle = 'dotted'
-            col = 'grey70'
+            kernel = graph["kernels"][active[n + i]]
+            node_inputs = graph["inputs"][active[n + i]]
+            node_arity = graph["arities"][active[n + i]]
         else:
-            nstyle = 'invis'
-            estyle = 'invis'
-            col = 'black'
-        op = str(f[x[i * (arity + 1)]])
+            if draw_inactive:
+                nstyle = 'dashed'
+                estyle = 'dotted'
+                col = 'grey70'
+            else:
+                nstyle = 'invis'
+                estyle = 'invis'
+                col = 'black'
+            kernel = x[i * (arity + 1)]
+            node_inputs = x[i * (arity + 1) + 1:(i + 1) * (arity + 1)]
+        op = str(f[kernel])
         if op == 'sum':
             op = '+'
         elif op == 'diff':
@@ -129,12 +135,19 @@ def _graphviz_visualize(self, in_sym = [], draw_inactive = True, draw_weights =
                 elabel = '<w<sub>' + str(n + i) + ',' + str(j) + '</sub>>'
             else:
                 elabel = ''
-            G.add_edge('n' + str(x[i * (arity + 1) + j + 1]), 'n' + str(n + i), label = elabel, arrowhead = ah, style = estyle, color = col, fontcolor = col)
+            # the inputs the kernel does not read are inactive connections
+            if j < node_arity or n + i not in active:
+                jstyle, jcol = estyle, col
+            elif draw_inactive:
+                jstyle, jcol = 'dotted', 'grey70'
+            else:
+                jstyle, jcol = 'invis', col
+            G.add_edge('n' + str(node_inputs[j]), 'n' + str(n + i), label = elabel, arrowhead = ah, style = jstyle, color = jcol, fontcolor = jcol)
 
     # output nodes
     for i in range(m):
         G.add_node('n' + str(n + r * c + i), label = '<o<sub>' + str(i) + '</sub>>', shape = 'circle', style = 'bold')
-        G.add_edge('n' + str(x[len(x) - m + i]), 'n' + str(n + r * c + i))
+        G.add_edge('n' + str(graph["outputs"][i]), 'n' + str(n + r * c + i))
 
     # generate the graph and display it
     G.draw(file_name, prog = 'dot')
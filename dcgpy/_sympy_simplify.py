@@ -7,7 +7,8 @@ def _sympy_simplify(self, in_sym, subs_weights = False, erc = []):
     Returns the simplified d-CGP expression for each output
 
     Note:
-        This method requires ``sympy`` and ``pyaudi`` modules installed in your Python system
+        This method requires the ``sympy`` module installed in your Python system. The expressions are built from
+        the active graph (see :func:`get_graph()`), in a time linear in its size
 
     Args:
         in_sym (a ``List[str]``): input symbols (its length must match the number of inputs)
@@ -20,7 +21,7 @@ def _sympy_simplify(self, in_sym, subs_weights = False, erc = []):
     Raises:
         ValueError: if the length of in_sym does not match the number of inputs
         ValueError: if the length of erc is larger than the number of inputs
-        ImportError: if modules sympy or pyaudi are not installed in your Python system
+        ImportError: if the module sympy is not installed in your Python system
 
     Examples:
         >>> ex = dcgpy.expression_weighted_gdual_double(3,2,3,3,2,2,dcgpy.kernel_set_gdual_double(["sum","diff"])(),0)
@@ -43,46 +44,50 @@ def _sympy_simplify(self, in_sym, subs_weights = False, erc = []):
         print("Failed to import the required module sympy")
         raise
 
-    try:
-        import pyaudi
-    except ImportError:
-        print("Failed to import the required module pyaudi")
-        raise
+    graph = self.get_graph()
+    f = self.get_f()
+    a = self.get_arity()
 
-    # define symbols
-    pe = []
-    exv = self(in_sym)
+    # define symbols, the ephemeral random constants are substituted with their values
     ns = {}
     for i in range(n):
         ns[in_sym[i]] = sympy.Symbol(in_sym[i], real = True)
-    if subs_weights:
-        r = self.get_rows()
-        c = self.get_cols()
-        a = self.get_arity()
-        for i in range(r * c):
+    values = {}
+    for i in range(n):
+        values[i] = ns[in_sym[i]]
+    for j in range(len(erc)):
+        values[n - len(erc) + j] = sympy.sympify(erc[j])
+    weighted = graph["weights"] is not None
+    if weighted:
+        for node in graph["nodes"]:
             for j in range(a):
-                ws = 'w' + str(n + i) + '_' + str(j)
+                ws = 'w' + str(node) + '_' + str(j)
                 ns[ws] = sympy.Symbol(ws, real = True)
 
-    # create Sympy expressions from strings
-    for i in range(m):
-        pe.append(sympy.sympify(exv[i], locals = ns))
-
-    # substitute the weights symbols with their values
-    if subs_weights:
-        wl = self.get_weights()
-        if type(wl[0]) == pyaudi._core.gdual_vdouble:
-            wl = [w.constant_cf[0] for w in wl]
-        for i in range(m):
-            for j in range(r * c):
-                for k in range(a):
-                    pe[i] = pe[i].subs(ns['w' + str(n + j) + '_' + str(k)], wl[a * j + k])
-
-    # substitute the ephemeral random constants symbols with their values
-    if len(erc) > 0:
-        for i in range(m):
-            for j in range(len(erc)):
-                pe[i] = pe[i].subs(ns[in_sym[n - len(erc) + j]],erc[j])
+    # the symbolic form of each kernel, as a function of placeholder symbols
+    placeholders = [sympy.Symbol('_dcgp_in' + str(j)) for j in range(a)]
+    names = {str(p): p for p in placeholders}
+    kernels = {}
+
+    # build the Sympy expression of each active node, from the inputs to the outputs (the kernels only read
+    # the first arities[k] inputs of the node)
+    for k, node in enumerate(graph["nodes"]):
+        kernel = int(graph["kernels"][k])
+        arity = int(graph["arities"][k])
+        if kernel not in kernels:
+            kernels[kernel] = sympy.sympify(f[kernel](list(names.keys())[:arity]), locals = names)
+        args = {}
+        for j in range(arity):
+            arg = values[int(graph["inputs"][k][j])]
+            if weighted:
+                if subs_weights:
+                    w = float(graph["weights"][k][j])
+                    arg = (sympy.Integer(int(w)) if w.is_integer() else sympy.Float(w)) * arg
+                else:
+                    arg = ns['w' + str(node) + '_' + str(j)] * arg
+            args[placeholders[j]] = arg
+        values[int(node)] = kernels[kernel].xreplace(args)
+    pe = [values[int(o)] for o in graph["outputs"]]
 
     # simplifications
     simplex = []
@@ -3,6 +3,10 @@
 
 #include <boost/python.hpp>
 #include <boost/python/stl_iterator.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
 
 
 
@@ -17,6 +21,120 @@ throw
 namespace bp = boost::python;
 
 namespace dcgpy{
+// Releases the GIL in its scope, so that other Python threads run while C++ computes
+class gil_release
+{
+public:
+    gil_release() : m_state(PyEval_SaveThread()) {}
+    ~gil_release()
+    {
+        PyEval_RestoreThread(m_state);
+    }
+    gil_release(const gil_release &) = delete;
+    gil_release &operator=(const gil_release &) = delete;
+
+private:
+    PyThreadState *m_state;
+};
+
+// Acquires the GIL in its scope (e.g. to call back into Python from code run with the GIL released)
+class gil_acquire
+{
+public:
+    gil_acquire() : m_state(PyGILState_Ensure()) {}
+    ~gil_acquire()
+    {
+        PyGILState_Release(m_state);
+    }
+    gil_acquire(const gil_acquire &) = delete;
+    gil_acquire &operator=(const gil_acquire &) = delete;
+
+private:
+    PyGILState_STATE m_state;
+};
+
+// Shares a Python object (e.g. the callable of a kernel) among C++ copies, which can then be made and destroyed
+// without the GIL (e.g. the offspring of dcgpy.evolve()). The GIL is acquired to release the object
+inline std::shared_ptr<bp::object> share_object(const bp::object &obj)
+{
+    return std::shared_ptr<bp::object>(new bp::object(obj), [](bp::object *p) {
+        gil_acquire gil;
+        delete p;
+    });
+}
+
+// A view on the memory of an object supporting the buffer protocol (e.g. a NumPy array), which must hold
+// doubles. The memory is not copied, and the object cannot be resized while the view exists.
+class double_buffer
+{
+public:
+    double_buffer(const bp::object &obj, bool writable)
+    {
+        if (PyObject_GetBuffer(obj.ptr(), &m_buffer, PyBUF_STRIDES | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0))
+            != 0) {
+            bp::throw_error_already_set();
+        }
+        const std::string format(m_buffer.format ? m_buffer.format : "B");
+        if (m_buffer.itemsize != sizeof(double) || (format != "d" && format != "@d" && format != "=d")) {
+            PyBuffer_Release(&m_buffer);
+            dcgpy_throw(PyExc_ValueError, "The array must contain float64 values");
+        }
+        for (int i = 0; i < m_buffer.ndim; ++i) {
+            if (m_buffer.strides[i] % static_cast<Py_ssize_t>(sizeof(double)) != 0) {
+                PyBuffer_Release(&m_buffer);
+                dcgpy_throw(PyExc_ValueError, "The values of the array must be aligned");
+            }
+        }
+    }
+    ~double_buffer()
+    {
+        PyBuffer_Release(&m_buffer);
+    }
+    double_buffer(const double_buffer &) = delete;
+    double_buffer &operator=(const double_buffer &) = delete;
+
+    int ndim() const
+    {
+        return m_buffer.ndim;
+    }
+    std::size_t shape(int i) const
+    {
+        return static_cast<std::size_t>(m_buffer.shape[i]);
+    }
+    // Stride, in doubles
+    std::ptrdiff_t stride(int i) const
+    {
+        return m_buffer.strides[i] / static_cast<std::ptrdiff_t>(sizeof(double));
+    }
+    double *data() const
+    {
+        return static_cast<double *>(m_buffer.buf);
+    }
+
+private:
+    Py_buffer m_buffer;
+};
+
+
+// Wraps N doubles in a read-only NumPy array, without copying them. The array must not be used once the
+// memory is released
+inline bp::object numpy_view(const double *data, std::size_t N)
+{
+    bp::object view(bp::handle<>(PyMemoryView_FromMemory(reinterpret_cast<char *>(const_cast<double *>(data)),
+                                                         static_cast<Py_ssize_t>(N * sizeof(double)), PyBUF_READ)));
+    return bp::import("numpy").attr("frombuffer")(view, "float64");
+}
+
+// Copies a vector to a new NumPy array of type dtype (e.g. "uintc" for unsigned, "float64" for double) and
+// the given shape
+template <typename T>
+inline bp::object to_numpy(const std::vector<T> &vector, const char *dtype, const bp::tuple &shape)
+{
+    bp::object bytes(bp::handle<>(PyByteArray_FromStringAndSize(reinterpret_cast<const char *>(vector.data()),
+                                                                static_cast<Py_ssize_t>(vector.size() * sizeof(T)))));
+    return bp::import("numpy").attr("frombuffer")(bytes, dtype).attr("reshape")(shape);
+}
+
 // Converts a C++ vector to a python list
 template <typename T>
 inline bp::list v_to_l(std::vector<T> vector) {
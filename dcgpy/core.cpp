@@ -1,14 +1,30 @@
 #include <audi/audi.hpp>
 #include <boost/python.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <functional> //std::function
+#include <memory>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <dcgp/dataset.hpp>
+#include <dcgp/evolve.hpp>
+#include <dcgp/exact_kernels.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/expression_weighted.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/graph.hpp>
+#include <dcgp/instrumentation.hpp>
 #include <dcgp/kernel.hpp>
 #include <dcgp/kernel_set.hpp>
+#include <dcgp/serialization.hpp>
+#include <dcgp/trace.hpp>
 
 #include "common_utils.hpp"
 #include "docstrings.hpp"
@@ -18,23 +34,327 @@ using namespace dcgpy;
 using namespace audi;
 namespace bp = boost::python;
 
+// Converts the instrumentation counters to python dicts
+bp::dict counters_to_dict(const kernel_counters &c)
+{
+    bp::dict retval;
+    retval["calls"] = c.calls;
+    retval["seconds"] = static_cast<double>(c.nanoseconds) * 1e-9;
+    retval["non_finite"] = c.non_finite;
+    return retval;
+}
+
+template <typename T>
+bp::dict counters_to_dict(const expression<T> &ex)
+{
+    const auto c = ex.get_counters();
+    bp::dict retval, kernels;
+    retval["evaluations"] = c.evaluations;
+    retval["mutations"] = c.mutations;
+    retval["update_active"] = c.update_active;
+    retval["mean_active_nodes"]
+        = c.update_active ? static_cast<double>(c.active_nodes) / static_cast<double>(c.update_active) : 0.;
+    retval["max_active_nodes"] = c.max_active_nodes;
+    for (const auto &f : ex.get_f()) {
+        kernels[f.get_name()] = counters_to_dict(f.get_counters());
+    }
+    retval["kernels"] = kernels;
+    return retval;
+}
+
+// Evaluates an expression on the columns of a 2-D float64 array (the rows of shape (n, N)), writing the
+// outputs in the rows of out (shape (m, N)), allocated if None. The arrays are not copied, unless the
+// input rows are not contiguous, and the GIL is released during the evaluation
+template <typename Expr>
+bp::object evaluate_buffer(const Expr &ex, const bp::object &inputs, bp::object out)
+{
+    const auto n = ex.get_n(), m = ex.get_m();
+    double_buffer in_buffer(inputs, false);
+    // A 1-D array is accepted for a single input
+    if (!(in_buffer.ndim() == 2 && in_buffer.shape(0) == n) && !(in_buffer.ndim() == 1 && n == 1u)) {
+        dcgpy_throw(PyExc_ValueError, ("The inputs must have shape (" + std::to_string(n) + ", N)").c_str());
+    }
+    const auto N = in_buffer.shape(in_buffer.ndim() - 1);
+    if (out.is_none()) {
+        out = bp::import("numpy").attr("empty")(bp::make_tuple(m, N));
+    }
+    double_buffer out_buffer(out, true);
+    if (!(out_buffer.ndim() == 2 && out_buffer.shape(0) == m && out_buffer.shape(1) == N)
+        && !(out_buffer.ndim() == 1 && m == 1u && out_buffer.shape(0) == N)) {
+        dcgpy_throw(PyExc_ValueError, ("The outputs must have shape (" + std::to_string(m) + ", " + std::to_string(N)
+                                       + ")").c_str());
+    }
+    if (N > 1u && out_buffer.stride(out_buffer.ndim() - 1) != 1) {
+        dcgpy_throw(PyExc_ValueError, "The rows of the outputs must be contiguous");
+    }
+    std::vector<const double *> in_ptr(n);
+    std::vector<double *> out_ptr(m);
+    std::vector<std::vector<double>> in_copies;
+    in_copies.reserve(n);
+    {
+        gil_release release;
+        const auto in_stride = in_buffer.stride(in_buffer.ndim() - 1);
+        for (auto j = 0u; j < n; ++j) {
+            const double *row = in_buffer.data() + (in_buffer.ndim() == 2 ? in_buffer.stride(0) * j : 0);
+            if (N > 1u && in_stride != 1) {
+                in_copies.emplace_back(N);
+                for (std::size_t k = 0u; k < N; ++k) {
+                    in_copies.back()[k] = row[in_stride * static_cast<std::ptrdiff_t>(k)];
+                }
+                row = in_copies.back().data();
+            }
+            in_ptr[j] = row;
+        }
+        for (auto i = 0u; i < m; ++i) {
+            out_ptr[i] = out_buffer.data() + (out_buffer.ndim() == 2 ? out_buffer.stride(0) * i : 0);
+        }
+        ex(in_ptr, out_ptr, N);
+    }
+    return out;
+}
+
+// The evaluation on arrays is only exposed for doubles
+template <typename Expr, typename Class>
+void expose_evaluate(Class &cl, std::true_type)
+{
+    cl.def("evaluate", &evaluate_buffer<Expr>, expression_evaluate_doc().c_str(),
+           (bp::arg("inputs"), bp::arg("out") = bp::object()));
+}
+
+template <typename Expr, typename Class>
+void expose_evaluate(Class &, std::false_type)
+{
+}
+
+// The symbolic representation of the kernels defined in Python. It also keeps the arguments the kernel was
+// constructed with, so that the kernel can be pickled (the callables are pickled by reference)
+struct python_printer {
+    std::string operator()(const std::vector<std::string> &x) const
+    {
+        gil_acquire gil;
+        std::string in = bp::extract<std::string>((*callable)(v_to_l(x)));
+        return in;
+    }
+    std::shared_ptr<bp::object> callable;
+    // The arguments of the constructor, or of from_c_function() if c_function is true
+    std::shared_ptr<bp::object> args;
+    bool c_function;
+};
+
+// Constructs a kernel from a Python callable evaluating it on whole columns of points (NumPy arrays), and
+// optionally from one evaluating it point by point (if None, the points are passed to the former as columns
+// of one value)
+kernel<double> *make_batch_kernel(const bp::object &obj1, const bp::object &obj2, const std::string &name,
+                                  const bp::object &obj3)
+{
+    // NOTE: the kernels may be called with the GIL released (see evaluate_buffer)
+    std::function<void(const std::vector<const double *> &, double *, std::size_t)> my_batch_function
+        = [f3 = share_object(obj3)](const std::vector<const double *> &in, double *out, std::size_t N) {
+              if (N == 0u) {
+                  return;
+              }
+              gil_acquire gil;
+              bp::list columns;
+              for (auto column : in) {
+                  columns.append(numpy_view(column, N));
+              }
+              auto numpy = bp::import("numpy");
+              // A scalar is accepted for all the points
+              bp::object values = numpy.attr("broadcast_to")(numpy.attr("asarray")((*f3)(columns), "float64"), N);
+              double_buffer buffer(values, false);
+              for (std::size_t k = 0u; k < N; ++k) {
+                  out[k] = buffer.data()[buffer.stride(0) * static_cast<std::ptrdiff_t>(k)];
+              }
+          };
+    std::function<double(const std::vector<double> &)> my_function;
+    if (obj1.is_none()) {
+        my_function = [my_batch_function](const std::vector<double> &x) {
+            std::vector<const double *> in(x.size());
+            for (decltype(x.size()) j = 0u; j < x.size(); ++j) {
+                in[j] = &x[j];
+            }
+            double retval;
+            my_batch_function(in, &retval, 1u);
+            return retval;
+        };
+    } else {
+        my_function = [f1 = share_object(obj1)](const std::vector<double> &x) {
+            gil_acquire gil;
+            double in = bp::extract<double>((*f1)(v_to_l(x)));
+            return in;
+        };
+    }
+    python_printer my_print_function{share_object(obj2), share_object(bp::make_tuple(obj1, obj2, name, obj3)), false};
+    return ::new kernel<double>(my_function, my_print_function, name, my_batch_function);
+}
+
+// The address of a compiled function: an int, a ctypes function or an object with an address attribute
+// (e.g. a numba cfunc). None gives 0
+std::uintptr_t function_address(const bp::object &f)
+{
+    if (f.is_none()) {
+        return 0u;
+    }
+    if (PyObject_HasAttrString(f.ptr(), "address")) {
+        return bp::extract<std::uintptr_t>(bp::object(f.attr("address")));
+    }
+    bp::extract<std::uintptr_t> address(f);
+    if (address.check()) {
+        return address();
+    }
+    auto ctypes = bp::import("ctypes");
+    bp::object value(ctypes.attr("cast")(f, bp::object(ctypes.attr("c_void_p"))).attr("value"));
+    return value.is_none() ? 0u : bp::extract<std::uintptr_t>(value)();
+}
+
+// Constructs a kernel from compiled C functions. They are called directly, without the GIL
+kernel<double> make_c_kernel(const bp::object &f, const bp::object &obj2, const std::string &name,
+                              const bp::object &batch_f)
+{
+    using c_function = double (*)(const double *, std::size_t);
+    using c_batch_function = void (*)(const double *const *, std::size_t, double *, std::size_t);
+    const auto f_address = function_address(f), batch_address = function_address(batch_f);
+    if (f_address == 0u && batch_address == 0u) {
+        dcgpy_throw(PyExc_ValueError, "At least one of the function addresses must be given");
+    }
+    const auto cf = reinterpret_cast<c_function>(f_address);
+    const auto cbf = reinterpret_cast<c_batch_function>(batch_address);
+    std::function<void(const std::vector<const double *> &, double *, std::size_t)> my_batch_function;
+    if (cbf) {
+        my_batch_function = [cbf](const std::vector<const double *> &in, double *out, std::size_t N) {
+            cbf(in.data(), in.size(), out, N);
+        };
+    } else {
+        my_batch_function = [cf](const std::vector<const double *> &in, double *out, std::size_t N) {
+            std::vector<double> point(in.size());
+            for (std::size_t k = 0u; k < N; ++k) {
+                for (decltype(in.size()) j = 0u; j < in.size(); ++j) {
+                    point[j] = in[j][k];
+                }
+                out[k] = cf(point.data(), point.size());
+            }
+        };
+    }
+    std::function<double(const std::vector<double> &)> my_function;
+    if (cf) {
+        my_function = [cf](const std::vector<double> &x) { return cf(x.data(), x.size()); };
+    } else {
+        my_function = [cbf](const std::vector<double> &x) {
+            std::vector<const double *> in(x.size());
+            for (decltype(x.size()) j = 0u; j < x.size(); ++j) {
+                in[j] = &x[j];
+            }
+            double retval;
+            cbf(in.data(), in.size(), &retval, 1u);
+            return retval;
+        };
+    }
+    python_printer my_print_function{share_object(obj2), share_object(bp::make_tuple(f, obj2, name, batch_f)), true};
+    return kernel<double>(my_function, my_print_function, name, my_batch_function);
+}
+
+// The kernels evaluated on NumPy arrays or by compiled functions are only exposed for doubles
+template <typename Class>
+void expose_batch_kernel(Class &cl, std::true_type)
+{
+    cl.def("__init__",
+           bp::make_constructor(&make_batch_kernel, bp::default_call_policies(),
+                                (bp::arg("callable_f"), bp::arg("callable_s"), bp::arg("name"),
+                                 bp::arg("callable_batch"))),
+           kernel_init_batch_doc().c_str());
+    cl.def("from_c_function", &make_c_kernel, kernel_from_c_function_doc().c_str(),
+           (bp::arg("f"), bp::arg("callable_s"), bp::arg("name"), bp::arg("batch_f") = bp::object()));
+    cl.staticmethod("from_c_function");
+}
+
+template <typename Class>
+void expose_batch_kernel(Class &, std::false_type)
+{
+}
+
+// Calls f(*args)
+bp::object call_with(const bp::object &f, const bp::object &args)
+{
+    return bp::object(bp::handle<>(PyObject_CallObject(f.ptr(), args.ptr())));
+}
+
+// Pickles a kernel: those defined in Python via the arguments they were constructed with, the others by name
+// (as kernel_set_T([name])[0])
+template <typename T>
+bp::tuple kernel_reduce(const bp::object &self)
+{
+    const kernel<T> &k = bp::extract<const kernel<T> &>(self);
+    const bp::object cls(self.attr("__class__"));
+    const bp::object methodcaller(bp::import("operator").attr("methodcaller"));
+    const auto printer = k.get_print_function().template target<python_printer>();
+    if (!printer) {
+        const std::string class_name = bp::extract<std::string>(bp::object(cls.attr("__name__")));
+        const bp::object ks_cls(bp::import(bp::str(cls.attr("__module__")))
+                                    .attr(("kernel_set_" + class_name.substr(std::string("kernel_").size())).c_str()));
+        bp::list names;
+        names.append(k.get_name());
+        return bp::make_tuple(methodcaller("__getitem__", 0), bp::make_tuple(ks_cls(names)));
+    }
+    if (printer->c_function) {
+        // A raw address would pickle fine, but would be dangling in another process
+        for (auto i : {0, 3}) {
+            if (PyLong_Check(bp::object((*printer->args)[i]).ptr())) {
+                dcgpy_throw(PyExc_TypeError, "Kernels constructed from the integer address of a C function cannot "
+                                             "be pickled: the address is meaningless in another process");
+            }
+        }
+        return bp::make_tuple(call_with(methodcaller, bp::make_tuple("from_c_function") + *printer->args),
+                              bp::make_tuple(cls));
+    }
+    return bp::make_tuple(cls, *printer->args);
+}
+
+// Pickles a kernel set as the list of its kernels: the names of those implemented in C++, the others themselves
+template <typename T>
+bp::tuple kernel_set_reduce(const bp::object &self)
+{
+    const kernel_set<T> &ks = bp::extract<const kernel_set<T> &>(self);
+    bp::list state;
+    for (const auto &k : ks()) {
+        if (k.get_print_function().template target<python_printer>()) {
+            state.append(k);
+        } else {
+            state.append(k.get_name());
+        }
+    }
+    return bp::make_tuple(self.attr("__class__"), bp::make_tuple(bp::list()), state);
+}
+
+template <typename T>
+void kernel_set_setstate(kernel_set<T> &ks, const bp::object &state)
+{
+    for (bp::stl_input_iterator<bp::object> it(state), end; it != end; ++it) {
+        bp::extract<std::string> name(*it);
+        if (name.check()) {
+            ks.push_back(name());
+        } else {
+            ks.push_back(bp::extract<const kernel<T> &>(*it)());
+        }
+    }
+}
+
 template <typename T>
 void expose_kernel(const std::string &type)
 {
     std::string class_name = "kernel_" + type;
-    bp::class_<kernel<T>>(class_name.c_str(), "The function defining the generic CGP node", bp::no_init)
-        .def("__init__",
+    bp::class_<kernel<T>> cl(class_name.c_str(), "The function defining the generic CGP node", bp::no_init);
+    cl.def("__init__",
              bp::make_constructor(
                  +[](const bp::object &obj1, const bp::object &obj2, const std::string &name) {
-                     std::function<T(const std::vector<T> &)> my_function = [obj1](const std::vector<T> &x) {
-                         T in = bp::extract<T>(obj1(v_to_l(x)));
-                         return in;
-                     };
-                     std::function<std::string(const std::vector<std::string> &)> my_print_function
-                         = [obj2](const std::vector<std::string> &x) {
-                               std::string in = bp::extract<std::string>(obj2(v_to_l(x)));
+                     // NOTE: the kernels may be called with the GIL released (see evaluate_buffer)
+                     std::function<T(const std::vector<T> &)> my_function
+                         = [f1 = share_object(obj1)](const std::vector<T> &x) {
+                               gil_acquire gil;
+                               T in = bp::extract<T>((*f1)(v_to_l(x)));
                                return in;
                            };
+                     python_printer my_print_function{share_object(obj2),
+                                                      share_object(bp::make_tuple(obj1, obj2, name)), false};
                      return ::new kernel<T>(my_function, my_print_function, name);
                  },
                  bp::default_call_policies(), (bp::arg("callable_f"), bp::arg("callable_s"), bp::arg("name"))),
@@ -50,12 +370,19 @@ void expose_kernel(const std::string &type)
                      return bp::object(instance(v));
                  }
              })
-        .def("__repr__", +[](const kernel<T> &instance) -> std::string {
-            std::ostringstream oss;
-            oss << instance;
-            return oss.str();
-        });
-    ;
+        .def("__repr__",
+             +[](const kernel<T> &instance) -> std::string {
+                 std::ostringstream oss;
+                 oss << instance;
+                 return oss.str();
+             })
+        .def("get_counters", +[](const kernel<T> &instance) { return counters_to_dict(instance.get_counters()); },
+             kernel_get_counters_doc().c_str())
+        .def("reset_counters", &kernel<T>::reset_counters, "Resets the instrumentation counters")
+        .def("__copy__", +[](const kernel<T> &instance) { return kernel<T>(instance); })
+        .def("__deepcopy__", +[](const kernel<T> &instance, const bp::object &) { return kernel<T>(instance); })
+        .def("__reduce__", &kernel_reduce<T>);
+    expose_batch_kernel(cl, std::is_same<T, double>{});
 }
 
 template <typename T>
@@ -89,15 +416,88 @@ void expose_kernel_set(std::string type)
              kernel_set_push_back_str_doc().c_str(), bp::arg("kernel_name"))
         .def("push_back", (void (kernel_set<T>::*)(const kernel<T> &)) & kernel_set<T>::push_back,
              kernel_set_push_back_ker_doc(type).c_str(), bp::arg("kernel"))
-        .def("__getitem__", &wrap_operator<T>);
+        .def("__getitem__", &wrap_operator<T>)
+        .def("__reduce__", &kernel_set_reduce<T>)
+        .def("__setstate__", &kernel_set_setstate<T>);
+}
+
+// Pickles the expressions via the archive format (see dcgp::to_archive()), which also stores the state of the
+// random engine. The kernels are pickled with the arguments of the constructor
+template <typename Expr>
+struct expression_pickle_suite : bp::pickle_suite {
+    static bp::tuple getinitargs(const Expr &ex)
+    {
+        return bp::make_tuple(ex.get_n(), ex.get_m(), ex.get_rows(), ex.get_cols(), ex.get_levels_back(),
+                              ex.get_arity(), v_to_l(ex.get_f()), 0u);
+    }
+    static bp::object getstate(const Expr &ex)
+    {
+        const auto buffer = to_archive(std::vector<Expr>{ex});
+        return bp::object(
+            bp::handle<>(PyBytes_FromStringAndSize(buffer.data(), static_cast<Py_ssize_t>(buffer.size()))));
+    }
+    static void setstate(Expr &ex, const bp::object &state)
+    {
+        char *data;
+        Py_ssize_t size;
+        if (PyBytes_AsStringAndSize(state.ptr(), &data, &size) != 0) {
+            bp::throw_error_already_set();
+        }
+        // NOTE: the archive is copied, as it must be aligned to 8 bytes
+        std::vector<std::uint64_t> buffer(static_cast<std::size_t>(size) / 8u + 1u);
+        std::memcpy(buffer.data(), data, static_cast<std::size_t>(size));
+        const expression_archive archive(reinterpret_cast<const char *>(buffer.data()), static_cast<std::size_t>(size));
+        if (archive.size() != 1u) {
+            throw std::invalid_argument("The state of a dCGP expression must store one expression");
+        }
+        ex = from_archive<Expr>(archive[0], ex.get_f());
+    }
+};
+
+// Converts the active graph to a dict of NumPy arrays (the weights are None for unweighted expressions)
+bp::dict graph_to_dict(const expression_graph &graph, bool weighted)
+{
+    const auto k = graph.nodes.size();
+    bp::dict retval;
+    retval["nodes"] = to_numpy(graph.nodes, "uintc", bp::make_tuple(k));
+    retval["kernels"] = to_numpy(graph.kernels, "uintc", bp::make_tuple(k));
+    retval["arities"] = to_numpy(graph.arities, "uintc", bp::make_tuple(k));
+    retval["inputs"] = to_numpy(graph.inputs, "uintc", bp::make_tuple(k, graph.arity));
+    retval["weights"] = weighted ? to_numpy(graph.weights, "float64", bp::make_tuple(k, graph.arity)) : bp::object();
+    retval["outputs"] = to_numpy(graph.outputs, "uintc", bp::make_tuple(graph.outputs.size()));
+    return retval;
+}
+
+// The copies share the kernels and have the same random engine (they mutate as the original)
+template <typename Expr, typename Class>
+void expose_copy(Class &cl)
+{
+    cl.def("__copy__", +[](const Expr &ex) { return Expr(ex); });
+    cl.def("__deepcopy__", +[](const Expr &ex, const bp::object &) { return Expr(ex); });
+}
+
+// The archive stores the weights as doubles: the weighted expressions are only pickled for doubles
+template <typename Expr, typename Class>
+void expose_pickle(Class &cl, std::true_type)
+{
+    cl.def_pickle(expression_pickle_suite<Expr>());
+}
+
+template <typename Expr, typename Class>
+void expose_pickle(Class &cl, std::false_type)
+{
+    cl.def("__reduce__", +[](const bp::object &self) -> bp::object {
+        const std::string class_name = bp::extract<std::string>(bp::object(self.attr("__class__").attr("__name__")));
+        dcgpy_throw(PyExc_TypeError, ("Instances of " + class_name + " cannot be pickled").c_str());
+    });
 }
 
 template <typename T>
 void expose_expression(std::string type)
 {
     std::string class_name = "expression_" + type;
-    bp::class_<expression<T>>(class_name.c_str(), "A CGP expression", bp::no_init)
-        .def("__init__",
+    bp::class_<expression<T>> cl(class_name.c_str(), "A CGP expression", bp::no_init);
+    cl.def("__init__",
              bp::make_constructor(
                  +[](unsigned int in, unsigned int out, unsigned int rows, unsigned int cols, unsigned int levelsback,
                      unsigned int arity, const bp::object &kernels, unsigned int seed) {
@@ -158,15 +558,26 @@ void expose_expression(std::string type)
         .def("mutate_ogene", &expression<T>::mutate_ogene,
              "Mutates exactly one randomly selected output genes within its allowed bounds")
         .def("mutate_active_fgene", &expression<T>::mutate_active_fgene,
-             "Mutates exactly one randomly selected active function genes within its allowed bounds");
+             "Mutates exactly one randomly selected active function genes within its allowed bounds")
+        .def("get_graph", +[](const expression<T> &instance) { return graph_to_dict(active_graph(instance), false); },
+             expression_get_graph_doc().c_str())
+        .def("with_exact_kernels", +[](const expression<T> &instance) { return with_exact_kernels(instance); },
+             expression_with_exact_kernels_doc().c_str())
+        .def("get_counters", +[](const expression<T> &instance) { return counters_to_dict(instance); },
+             expression_get_counters_doc().c_str())
+        .def("reset_counters", &expression<T>::reset_counters,
+             "Resets the instrumentation counters of the expression (those of the kernels excluded)");
+    expose_evaluate<expression<T>>(cl, std::is_same<T, double>{});
+    expose_copy<expression<T>>(cl);
+    expose_pickle<expression<T>>(cl, std::true_type{});
 }
 
 template <typename T>
 void expose_expression_weighted(std::string type)
 {
     std::string class_name = "expression_weighted_" + type;
-    bp::class_<expression_weighted<T>, bp::bases<expression<T>>>(class_name.c_str(), bp::no_init)
-        .def("__init__",
+    bp::class_<expression_weighted<T>, bp::bases<expression<T>>> cl(class_name.c_str(), bp::no_init);
+    cl.def("__init__",
              bp::make_constructor(
                  +[](unsigned int in, unsigned int out, unsigned int rows, unsigned int cols, unsigned int levelsback,
                      unsigned int arity, const bp::object &kernels, unsigned int seed) {
@@ -204,7 +615,130 @@ void expose_expression_weighted(std::string type)
         .def("get_weight", &expression_weighted<T>::get_weight, expression_weighted_get_weight_doc().c_str(),
              (bp::arg("node_id"), bp::arg("input_id")))
         .def("get_weights", +[](expression_weighted<T> &instance) { return v_to_l(instance.get_weights()); },
-             "Gets all weights");
+             "Gets all weights")
+        .def("get_graph",
+             +[](const expression_weighted<T> &instance) { return graph_to_dict(active_graph(instance), true); },
+             expression_get_graph_doc().c_str())
+        .def("with_exact_kernels",
+             +[](const expression_weighted<T> &instance) { return with_exact_kernels(instance); },
+             expression_with_exact_kernels_doc().c_str());
+    // NOTE: exposed again, as the evaluation of the base class ignores the weights
+    expose_evaluate<expression_weighted<T>>(cl, std::is_same<T, double>{});
+    expose_copy<expression_weighted<T>>(cl);
+    expose_pickle<expression_weighted<T>>(cl, std::is_same<T, double>{});
+}
+
+// Copies array-likes of shape (n, N) and (m, N) (1-D for a single input or output) to a dataset
+dataset make_dataset(const bp::object &inputs, const bp::object &outputs, unsigned n, unsigned m)
+{
+    auto numpy = bp::import("numpy");
+    const auto in_array = numpy.attr("ascontiguousarray")(inputs, "float64");
+    const auto out_array = numpy.attr("ascontiguousarray")(outputs, "float64");
+    double_buffer in_buffer(in_array, false), out_buffer(out_array, false);
+    if (!(in_buffer.ndim() == 2 && in_buffer.shape(0) == n) && !(in_buffer.ndim() == 1 && n == 1u)) {
+        dcgpy_throw(PyExc_ValueError, ("The inputs must have shape (" + std::to_string(n) + ", N)").c_str());
+    }
+    const auto N = in_buffer.shape(in_buffer.ndim() - 1);
+    if (!(out_buffer.ndim() == 2 && out_buffer.shape(0) == m && out_buffer.shape(1) == N)
+        && !(out_buffer.ndim() == 1 && m == 1u && out_buffer.shape(0) == N)) {
+        dcgpy_throw(PyExc_ValueError, ("The outputs must have shape (" + std::to_string(m) + ", " + std::to_string(N)
+                                       + ")").c_str());
+    }
+    std::vector<const double *> in(n), out(m);
+    for (auto j = 0u; j < n; ++j) {
+        in[j] = in_buffer.data() + N * j;
+    }
+    for (auto i = 0u; i < m; ++i) {
+        out[i] = out_buffer.data() + N * i;
+    }
+    return dataset(in, out, N);
+}
+
+// Runs f with the GIL released. A Python error raised in another thread (e.g. by a Python kernel) is lost with
+// the thread state, so a RuntimeError is raised in its place
+template <typename F>
+auto without_gil(const F &f) -> decltype(f())
+{
+    try {
+        gil_release release;
+        return f();
+    } catch (const bp::error_already_set &) {
+        if (!PyErr_Occurred()) {
+            PyErr_SetString(PyExc_RuntimeError, "A Python callable raised an exception in a worker thread");
+        }
+        throw;
+    }
+}
+
+template <typename Expr>
+double quadratic_error_py(const Expr &ex, const bp::object &inputs, const bp::object &outputs, double cutoff)
+{
+    const auto data = make_dataset(inputs, outputs, ex.get_n(), ex.get_m());
+    return without_gil([&ex, &data, cutoff]() { return quadratic_error(ex, data, cutoff); });
+}
+
+// The expressions may be dcgpy.expression_double or dcgpy.expression_weighted_double: each kind is evaluated
+// with its own call of dcgp::quadratic_error()
+bp::list quadratic_errors_py(const bp::object &expressions, const bp::object &inputs, const bp::object &outputs,
+                             double cutoff, unsigned threads)
+{
+    std::vector<expression<double>> exs;
+    std::vector<expression_weighted<double>> exws;
+    std::vector<std::pair<bool, std::size_t>> where;
+    for (bp::stl_input_iterator<bp::object> it(expressions), end; it != end; ++it) {
+        bp::extract<const expression_weighted<double> &> exw(*it);
+        if (exw.check()) {
+            where.emplace_back(true, exws.size());
+            exws.push_back(exw());
+        } else {
+            where.emplace_back(false, exs.size());
+            exs.push_back(bp::extract<const expression<double> &>(*it)());
+        }
+    }
+    if (where.empty()) {
+        return bp::list();
+    }
+    const auto &first = where[0].first ? static_cast<const expression<double> &>(exws[0]) : exs[0];
+    const auto data = make_dataset(inputs, outputs, first.get_n(), first.get_m());
+    std::vector<double> errors, errors_w;
+    without_gil([&]() {
+        errors = quadratic_error(exs, data, cutoff, threads);
+        errors_w = quadratic_error(exws, data, cutoff, threads);
+    });
+    bp::list retval;
+    for (const auto &w : where) {
+        retval.append(w.first ? errors_w[w.second] : errors[w.second]);
+    }
+    return retval;
+}
+
+// The evolution runs with the GIL released, the callback is called with it between the generations
+template <typename Expr>
+bp::dict evolve_py(Expr &ex, const bp::object &inputs, const bp::object &outputs, unsigned offspring,
+                   unsigned mutations, unsigned max_generations, double target, unsigned threads,
+                   const bp::object &callback)
+{
+    const auto data = make_dataset(inputs, outputs, ex.get_n(), ex.get_m());
+    es_options opts;
+    opts.offspring = offspring;
+    opts.mutations = mutations;
+    opts.max_generations = max_generations;
+    opts.target = target;
+    opts.threads = threads;
+    const auto result = without_gil([&]() {
+        return evolve(ex, data, opts, [&callback](unsigned generation, double fitness) {
+            if (callback.is_none()) {
+                return true;
+            }
+            gil_acquire gil;
+            bp::object go_on = callback(generation, fitness);
+            return go_on.is_none() || bp::extract<bool>(go_on)();
+        });
+    });
+    bp::dict retval;
+    retval["fitness"] = result.fitness;
+    retval["generations"] = result.generations;
+    return retval;
 }
 
 BOOST_PYTHON_MODULE(core)
@@ -227,6 +761,29 @@ BOOST_PYTHON_MODULE(core)
     expose_expression<gdual_v>("gdual_vdouble");
     expose_expression_weighted<gdual_v>("gdual_vdouble");
 
+    bp::def("instrumentation_enabled", &instrumentation_enabled, instrumentation_enabled_doc().c_str());
+    bp::def("trace_enabled", &trace_enabled, trace_enabled_doc().c_str());
+    bp::def("save_trace", &save_trace, save_trace_doc().c_str(), bp::arg("filename"));
+    bp::def("clear_trace", &clear_trace, clear_trace_doc().c_str(), bp::arg("capacity") = 65536u);
+
+    const auto inf = std::numeric_limits<double>::infinity();
+    // NOTE: the overloads are tried in reverse order, the weighted expressions must come last
+    bp::def("quadratic_error", &quadratic_error_py<expression<double>>, quadratic_error_doc().c_str(),
+            (bp::arg("expression"), bp::arg("inputs"), bp::arg("outputs"), bp::arg("cutoff") = inf));
+    bp::def("quadratic_error", &quadratic_error_py<expression_weighted<double>>,
+            (bp::arg("expression"), bp::arg("inputs"), bp::arg("outputs"), bp::arg("cutoff") = inf));
+    bp::def("quadratic_errors", &quadratic_errors_py, quadratic_errors_doc().c_str(),
+            (bp::arg("expressions"), bp::arg("inputs"), bp::arg("outputs"), bp::arg("cutoff") = inf,
+             bp::arg("threads") = 0u));
+    bp::def("evolve", &evolve_py<expression<double>>, evolve_doc().c_str(),
+            (bp::arg("expression"), bp::arg("inputs"), bp::arg("outputs"), bp::arg("offspring") = 4u,
+             bp::arg("mutations") = 2u, bp::arg("max_generations") = 1000u, bp::arg("target") = 0.,
+             bp::arg("threads") = 1u, bp::arg("callback") = bp::object()));
+    bp::def("evolve", &evolve_py<expression_weighted<double>>,
+            (bp::arg("expression"), bp::arg("inputs"), bp::arg("outputs"), bp::arg("offspring") = 4u,
+             bp::arg("mutations") = 2u, bp::arg("max_generations") = 1000u, bp::arg("target") = 0.,
+             bp::arg("threads") = 1u, bp::arg("callback") = bp::object()));
+
     // Define a cleanup functor to be run when the module is unloaded.
     struct dcgp_cleanup_functor {
         void operator()() const
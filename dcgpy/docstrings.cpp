@@ -28,6 +28,76 @@ Examples:
     )";
 }
 
+std::string kernel_init_batch_doc()
+{
+    return R"(__init__(callable_f, callable_s, name, callable_batch)
+
+Constructs a kernel function from callables, one of which evaluates it on many points at once.
+
+When an expression is evaluated on many points (e.g. with :func:`dcgpy.expression_double.evaluate()`), *callable_batch*
+is called once per node on whole columns of inputs (in blocks of a few hundred points), rather than *callable_f* once
+per node and point: the cost of the Python calls is then amortized over the points, and kernels written with NumPy
+operations get close to the built-in ones.
+
+Args:
+    callable_f (``callable - List[double] -> double``): a callable taking a list of double as inputs and returning a double (the value of the kernel function evaluated on the inputs). If ``None``, *callable_batch* is called on columns of one point
+    callable_s (``callable - List[string] -> string``): a callable taking a list of string as inputs and returning a string (the symbolic representation of the kernel function evaluated on the input symbols)
+    name (``string``): name of the kernel
+    callable_batch (``callable - List[numpy.ndarray] -> numpy.ndarray``): a callable taking a list of 1D float64 arrays (the columns of the inputs, one per input) and returning the N values of the kernel (or a scalar, for all of them). The input arrays are read-only views on the memory of the expression: they must not be kept after the call
+
+Examples:
+
+>>> from dcgpy import *
+>>> import numpy as np
+>>> def my_sum(x):
+...     return sum(x)
+>>> def print_my_sum(x):
+...     return '(' + '+'.join(x) + ')'
+>>> def my_sum_batch(columns):
+...     return np.sum(columns, axis = 0)
+>>> my_kernel = kernel_double(my_sum, print_my_sum, "my_sum", my_sum_batch)
+    )";
+}
+
+std::string kernel_from_c_function_doc()
+{
+    return R"(from_c_function(f, callable_s, name, batch_f = None)
+
+Constructs a kernel function from compiled C functions.
+
+The functions are called directly from C++, without going through Python nor taking the GIL: the kernel is
+as fast as the built-in ones and can be used by expressions evaluated in parallel threads. The C functions must
+stay alive (and be thread safe) as long as the kernel is used. The symbolic representation is still given by a
+Python callable.
+
+The kernel can be pickled only if the functions are given as objects that pickle themselves (e.g. a numba
+``cfunc``): an integer address is meaningless in another process (e.g. a ``multiprocessing`` worker), and ctypes
+functions cannot be pickled at all.
+
+Args:
+    f: the scalar function, with C signature ``double f(const double *x, size_t n)`` returning the value of the
+      kernel in the point of *n* inputs *x*. It can be given as an address (``int``), a ctypes function or an object
+      with an ``address`` attribute (e.g. a numba ``cfunc``). If ``None``, *batch_f* is called on single points
+    callable_s (``callable - List[string] -> string``): a callable taking a list of string as inputs and returning a string (the symbolic representation of the kernel function evaluated on the input symbols)
+    name (``string``): name of the kernel
+    batch_f: the batch function (optional), with C signature ``void f(const double *const *x, size_t n, double *out, size_t N)``
+      writing in *out* the values of the kernel in *N* points, whose *n* inputs are in the columns ``x[0]``, ..., ``x[n-1]``.
+      It is given as *f*. If ``None``, *f* is called point by point
+
+Raises:
+    ValueError: if neither *f* nor *batch_f* is given
+
+Examples:
+
+>>> from dcgpy import *
+>>> from numba import cfunc, types, carray
+>>> @cfunc(types.double(types.CPointer(types.double), types.intp))
+... def my_sum(x, n):
+...     return sum(carray(x, n))
+>>> my_kernel = kernel_double.from_c_function(my_sum, lambda s: "(" + "+".join(s) + ") ", "my_sum")
+    )";
+}
+
 std::string kernel_set_init_doc(const std::string &type)
 {
     return R"(__init__(kernels)
@@ -36,7 +106,19 @@ Constructs a set of common kernel functions from their common name. The kernel
 functions can be then retrieved via the call operator.
 
 Args:
-    kernels (``List[string]``): a list of strings indicating names of kernels to use. The following are available: "sum", "diff", "mul", "div", "sig", "sin", "log", "exp"
+    kernels (``List[string]``): a list of strings indicating names of kernels to use. The following are available: "sum", "diff", "mul", "div", "pdiv", "sig", "sin", "cos", "log", "exp", "fast_sig", "fast_exp"
+
+Note:
+    "fast_sig" and "fast_exp" approximate "sig" and "exp" with a relative error below 1e-15 for doubles (the gduals are
+    computed exactly). They are faster on batches of points, if the compiler vectorizes them (e.g. with AVX2), and are
+    meant for the search: the final candidates can then be re-scored with the exact kernels via
+    :func:`~dcgpy.expression_double.with_exact_kernels()`
+
+Note:
+    "sin", "cos", "log" and "exp" only read the first input of their node, and "pdiv" the first two: the connections
+    to the other inputs are not active, hence neither evaluated nor mutated by the mutations of the active genes.
+    This changes the search dynamics (less neutral drift) with respect to versions where all the connections were
+    active. User defined kernels read all the inputs of their node
 
 Examples:
 
@@ -176,4 +258,296 @@ Raises:
     ValueError: if node_id or input_id are not valid
     )";
 }
+
+std::string instrumentation_enabled_doc()
+{
+    return R"(instrumentation_enabled()
+
+Whether the instrumentation counters are compiled in.
+
+The counters of kernels and expressions are only updated if dcgp was built with the DCGP_ENABLE_INSTRUMENTATION
+CMake option, otherwise they are always zero.
+
+Returns:
+    ``True`` if the counters are updated
+    )";
+}
+
+std::string kernel_get_counters_doc()
+{
+    return R"(get_counters()
+
+Gets the instrumentation counters of the kernel (see :func:`dcgpy.instrumentation_enabled()`).
+
+The counters are shared by the copies of the kernel, e.g. by all the expressions constructed with the kernels of
+the same kernel set.
+
+Returns:
+    A ``dict`` with the number of points where the kernel was evaluated (``calls``), the time spent in the
+    evaluations (``seconds``) and the number of non finite results (``non_finite``)
+    )";
+}
+
+std::string expression_get_counters_doc()
+{
+    return R"(get_counters()
+
+Gets the instrumentation counters of the expression (see :func:`dcgpy.instrumentation_enabled()`).
+
+The counters are shared by the copies of the expression, so that the counts of the offspring of an evolutionary
+strategy add up in the expression they were copied from.
+
+Returns:
+    A ``dict`` with the number of points where the expression was evaluated (``evaluations``), the number of genes
+    mutated (``mutations``), the number of updates of the active nodes (``update_active``), the mean and largest
+    number of active nodes (``mean_active_nodes``, ``max_active_nodes``) and, in ``kernels``, the counters of each
+    kernel by name (see :func:`dcgpy.kernel_double.get_counters()`)
+
+Examples:
+
+>>> from dcgpy import *
+>>> ex = expression_double(1, 1, 1, 10, 11, 2, kernel_set_double(["sum", "mul"])(), 32)
+>>> ex.mutate_active(2)
+>>> ex.get_counters()["mutations"] # doctest: +SKIP
+2
+    )";
+}
+
+std::string trace_enabled_doc()
+{
+    return R"(trace_enabled()
+
+Whether the trace events are compiled in.
+
+The fitness functions and the reading of the datasets only record trace events if dcgp was built with the
+DCGP_ENABLE_TRACE CMake option, otherwise the traces saved are empty.
+
+Returns:
+    ``True`` if the events are recorded
+    )";
+}
+
+std::string save_trace_doc()
+{
+    return R"(save_trace(filename)
+
+Saves the trace events in the Chrome trace-event format.
+
+The events of each thread (e.g. the evaluations of the quadratic error) are written on their own track, and
+can be looked at in chrome://tracing or https://ui.perfetto.dev.
+
+Args:
+    filename (``str``): the file name (e.g. "trace.json")
+
+Raises:
+    RuntimeError: if the file cannot be written
+    )";
+}
+
+std::string clear_trace_doc()
+{
+    return R"(clear_trace(capacity = 65536)
+
+Discards the trace events recorded so far.
+
+Args:
+    capacity (``int``): the number of events kept per thread (the most recent ones)
+
+Raises:
+    ValueError: if *capacity* is zero
+    )";
+}
+
+std::string quadratic_error_doc()
+{
+    return R"(quadratic_error(expression, inputs, outputs, cutoff = inf)
+
+Computes the quadratic error of an expression in approximating data.
+
+The error is computed in C++, on batches of points, with the GIL released. If a *cutoff* is given, the
+computation stops as soon as the error is certainly larger than it.
+
+Args:
+    expression (:class:`dcgpy.expression_double` or :class:`dcgpy.expression_weighted_double`): the expression
+    inputs (2D NumPy float array): the input points, one row per input, of shape (n, N). A 1D array of N points
+      is accepted for a single input. Any array-like is accepted (it is copied)
+    outputs (2D NumPy float array): the desired outputs, one row per output, of shape (m, N). A 1D array of N
+      points is accepted for a single output
+    cutoff (``float``): the cutoff
+
+Returns:
+    ``float``: the quadratic error (the sum over the outputs of the mean squared errors), ``inf`` if it is larger
+    than *cutoff* or ``nan`` if the expression is not finite on some point
+
+Raises:
+    ValueError: if the shapes of the arrays do not match the expression
+
+Examples:
+
+>>> from dcgpy import expression_double, kernel_set_double, quadratic_error
+>>> import numpy as np
+>>> ex = expression_double(1, 1, 1, 10, 11, 2, kernel_set_double(["sum", "mul"])(), 32)
+>>> x = np.linspace(-1, 1, 100)
+>>> error = quadratic_error(ex, x, x**3 + x)
+    )";
+}
+
+std::string quadratic_errors_doc()
+{
+    return R"(quadratic_errors(expressions, inputs, outputs, cutoff = inf, threads = 0)
+
+Computes the quadratic errors of many expressions in approximating data, in parallel.
+
+Same as :func:`dcgpy.quadratic_error()` on each expression, with the expressions distributed among
+*threads* threads. Expressions with kernels defined in Python are evaluated one at a time, as the kernels
+need the GIL.
+
+Args:
+    expressions (``list`` of :class:`dcgpy.expression_double` or :class:`dcgpy.expression_weighted_double`): the
+      expressions
+    inputs (2D NumPy float array): the input points, of shape (n, N)
+    outputs (2D NumPy float array): the desired outputs, of shape (m, N)
+    cutoff (``float``): the cutoff
+    threads (``int``): the number of threads (0 selects the number of hardware threads)
+
+Returns:
+    ``list`` of ``float``: the quadratic error of each expression
+
+Raises:
+    ValueError: if the shapes of the arrays do not match the expressions
+    )";
+}
+
+std::string evolve_doc()
+{
+    return R"(evolve(expression, inputs, outputs, offspring = 4, mutations = 2, max_generations = 1000, target = 0., threads = 1, callback = None)
+
+Evolves an expression to fit data with a (1 + lambda)-ES.
+
+At each generation *offspring* copies of the best expression found are mutated (see
+:func:`~dcgpy.expression_double.mutate_active()`) and their quadratic errors (see :func:`dcgpy.quadratic_error()`)
+computed in parallel, on *threads* threads. The best of them replaces the parent if it is not worse. The
+whole evolution runs in C++ with the GIL released, and the result does not depend on the number of threads.
+
+Args:
+    expression (:class:`dcgpy.expression_double` or :class:`dcgpy.expression_weighted_double`): the expression,
+      which is left with the best chromosome found
+    inputs (2D NumPy float array): the input points, of shape (n, N)
+    outputs (2D NumPy float array): the desired outputs, of shape (m, N)
+    offspring (``int``): the number of offspring per generation
+    mutations (``int``): the number of active genes mutated in each offspring
+    max_generations (``int``): the maximum number of generations
+    target (``float``): the evolution stops as soon as the error is not larger than this
+    threads (``int``): the number of threads (0 selects the number of hardware threads)
+    callback (``callable``): if not ``None``, called after each generation as ``callback(generation, error)``
+      with the GIL held. Returning ``False`` stops the evolution
+
+Returns:
+    ``dict``: the error of the expression evolved (``"fitness"``) and the number of generations run
+    (``"generations"``)
+
+Raises:
+    ValueError: if *offspring* is zero or the shapes of the arrays do not match the expression
+    unspecified: any exception raised by *callback* (the expression is left with the best chromosome found)
+
+Examples:
+
+>>> from dcgpy import expression_double, kernel_set_double, evolve
+>>> import numpy as np
+>>> ex = expression_double(1, 1, 1, 15, 16, 2, kernel_set_double(["sum", "diff", "mul", "div"])(), 32)
+>>> x = np.linspace(-1, 1, 100)
+>>> result = evolve(ex, x, x**3 + x, max_generations = 5000, threads = 4, target = 1e-12)
+    )";
+}
+
+std::string expression_get_graph_doc()
+{
+    return R"(get_graph()
+
+Gets the graph of the active nodes of the expression.
+
+The nodes are numbered as in the chromosome: the inputs are the nodes 0, ..., n-1, the function nodes follow.
+The function nodes are listed in increasing order, which is an order of evaluation: building another
+representation of the expression from the graph (e.g. a symbolic one, see :func:`simplify()`) takes a time
+linear in its size, while its string representation can grow exponentially with the number of columns.
+
+Returns:
+    ``dict``: NumPy arrays describing the k active function nodes:
+
+    * ``"nodes"``: their ids, shape (k,)
+    * ``"kernels"``: the indexes of their kernels in :func:`get_f()`, shape (k,)
+    * ``"arities"``: the number of inputs their kernels read (e.g. 1 for ``"sin"``), shape (k,)
+    * ``"inputs"``: the ids of the nodes connected to their inputs, shape (k, arity). Only the first
+      ``arities[i]`` inputs of the i-th node are connected, the others may lead to inactive nodes
+    * ``"weights"``: the weights of these connections (for gduals their constant coefficient), shape
+      (k, arity), or ``None`` for unweighted expressions
+    * ``"outputs"``: the ids of the nodes connected to the outputs, shape (m,)
+
+Examples:
+
+>>> from dcgpy import *
+>>> ex = expression_double(2, 1, 1, 3, 3, 2, kernel_set_double(["sum", "mul"])(), 0)
+>>> ex.set([0, 0, 1, 1, 2, 2, 0, 0, 0, 3])
+>>> graph = ex.get_graph()
+>>> graph["nodes"], graph["kernels"], graph["arities"], graph["outputs"]
+(array([2, 3], dtype=uint32), array([0, 1], dtype=uint32), array([2, 2], dtype=uint32), array([3], dtype=uint32))
+>>> graph["inputs"]
+array([[0, 1],
+       [2, 2]], dtype=uint32)
+    )";
+}
+
+std::string expression_with_exact_kernels_doc()
+{
+    return R"(with_exact_kernels()
+
+Copies the expression replacing the fast approximate kernels ("fast_sig", "fast_exp") with the exact ones
+("sig", "exp"). The chromosome, the weights and the random engine are copied, the other kernels are kept.
+
+Returns:
+    the copy of the expression, to re-score the candidates found with the fast kernels
+
+Examples:
+
+>>> from dcgpy import *
+>>> ex = expression_double(1, 1, 1, 15, 16, 2, kernel_set_double(["sum", "mul", "fast_sig"])(), 32)
+>>> ex.with_exact_kernels().get_f()
+[sum, mul, sig]
+    )";
+}
+
+std::string expression_evaluate_doc()
+{
+    return R"(evaluate(inputs, out = None)
+
+Evaluates the expression in many points at once.
+
+The arrays are accessed in place through the buffer protocol, and the evaluation runs in C++ (in batches,
+node by node) with the GIL released, so that other Python threads can run meanwhile. Kernels defined in
+Python reacquire the GIL when called.
+
+Args:
+    inputs (2D NumPy float array): the points, one row per input, of shape (n, N). A 1D array of N points is
+      accepted for a single input. The rows are not copied if they are contiguous (e.g. for a C ordered array,
+      or the transpose of a Fortran ordered array of shape (N, n))
+    out (2D NumPy float array): where the outputs are written, one row per output, of shape (m, N). Its rows must be
+      contiguous and it must not overlap *inputs*. If ``None`` a new array is allocated
+
+Returns:
+    *out*, or the new array with the outputs
+
+Raises:
+    ValueError: if the arrays do not contain float64 values or their shapes are not as above
+
+Examples:
+
+>>> from dcgpy import *
+>>> import numpy as np
+>>> ex = expression_double(2, 1, 1, 10, 11, 2, kernel_set_double(["sum", "mul"])(), 32)
+>>> x = np.random.random((2, 1000))
+>>> y = ex.evaluate(x)
+>>> np.allclose(y[:, 0], ex(list(x[:, 0])))
+True
+    )";
+}
 } // namespace
@@ -5,6 +5,8 @@
 
 namespace dcgpy {
 std::string kernel_init_doc(const std::string &);
+std::string kernel_init_batch_doc();
+std::string kernel_from_c_function_doc();
 std::string expression_init_doc(const std::string &);
 std::string kernel_set_init_doc(const std::string &);
 std::string kernel_set_push_back_str_doc();
@@ -14,6 +16,18 @@ std::string expression_mutate_doc();
 std::string expression_weighted_set_weight_doc();
 std::string expression_weighted_set_weights_doc();
 std::string expression_weighted_get_weight_doc();
+std::string instrumentation_enabled_doc();
+std::string kernel_get_counters_doc();
+std::string expression_get_counters_doc();
+std::string expression_evaluate_doc();
+std::string expression_get_graph_doc();
+std::string expression_with_exact_kernels_doc();
+std::string trace_enabled_doc();
+std::string save_trace_doc();
+std::string clear_trace_doc();
+std::string quadratic_error_doc();
+std::string quadratic_errors_doc();
+std::string evolve_doc();
 }
 
 #endif
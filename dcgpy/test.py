@@ -1,5 +1,12 @@
 import unittest as _ut
 
+# Kernels pickled by reference must be defined at module level
+def _my_sum(x):
+    return x[0] + x[1]
+
+def _print_my_sum(s):
+    return s[0] + "+" + s[1]
+
 class test_kernel(_ut.TestCase):
 
     def my_sum(self, x):
@@ -43,6 +50,71 @@ class test_kernel(_ut.TestCase):
         self.assertEqual(my_kernel([x, y, z]), x + y + z)
         self.assertEqual(my_kernel(["x", "y"]), "(x+y)")
 
+    def test_double_batch(self):
+        from dcgpy import kernel_double as kernel
+        from dcgpy import expression_double as expression
+        import numpy as np
+
+        calls = [0]
+        def my_sum_batch(columns):
+            calls[0] += 1
+            return np.sum(columns, axis = 0)
+
+        my_kernel = kernel(self.my_sum, self.print_my_sum, "my_sum_kernel", my_sum_batch)
+        self.assertEqual(my_kernel([1,2,3]), 6)
+        self.assertEqual(my_kernel(["x", "y"]), "(x+y)")
+        self.assertEqual(calls[0], 0)
+        # Without the scalar callable, the batch one is used on single points
+        my_kernel = kernel(None, self.print_my_sum, "my_sum_kernel", my_sum_batch)
+        self.assertEqual(my_kernel([1,2,3]), 6)
+        self.assertEqual(calls[0], 1)
+        # One call per node on the whole batch
+        ex = expression(2,1,1,1,2,2,[my_kernel],32)
+        ex.set([0, 0, 1, 2])
+        x = np.random.random((2, 100))
+        calls[0] = 0
+        self.assertTrue(np.allclose(ex.evaluate(x)[0], x[0] + x[1]))
+        self.assertEqual(calls[0], 1)
+        # Scalars are broadcast, wrong shapes are rejected
+        ex = expression(1,1,1,1,2,2,[kernel(None, self.print_my_sum, "two", lambda columns: 2.)],32)
+        self.assertTrue(np.all(ex.evaluate(np.zeros(10)) == 2.))
+        ex = expression(1,1,1,1,2,2,[kernel(None, self.print_my_sum, "bad", lambda columns: columns[0][:2])],32)
+        self.assertRaises(ValueError, lambda: ex.evaluate(np.zeros(10)))
+
+    def test_double_c_function(self):
+        from dcgpy import kernel_double as kernel
+        from dcgpy import expression_double as expression
+        import ctypes
+        import numpy as np
+
+        # C callbacks made with ctypes (a numba cfunc or a function of a shared library would do as well)
+        scalar_type = ctypes.CFUNCTYPE(ctypes.c_double, ctypes.POINTER(ctypes.c_double), ctypes.c_size_t)
+        batch_type = ctypes.CFUNCTYPE(None, ctypes.POINTER(ctypes.POINTER(ctypes.c_double)), ctypes.c_size_t,
+                                      ctypes.POINTER(ctypes.c_double), ctypes.c_size_t)
+        def my_sum_batch(x, n, out, N):
+            for k in range(N):
+                out[k] = sum(x[i][k] for i in range(n))
+        my_sum = scalar_type(lambda x, n: sum(x[i] for i in range(n)))
+        my_sum_batch = batch_type(my_sum_batch)
+
+        kernels = [kernel.from_c_function(my_sum, self.print_my_sum, "my_sum_kernel"),
+                   kernel.from_c_function(None, self.print_my_sum, "my_sum_kernel", my_sum_batch),
+                   kernel.from_c_function(ctypes.cast(my_sum, ctypes.c_void_p).value, self.print_my_sum,
+                                          "my_sum_kernel", my_sum_batch)]
+        x = np.random.random((2, 10))
+        for my_kernel in kernels:
+            self.assertEqual(my_kernel.__repr__(), "my_sum_kernel")
+            self.assertEqual(my_kernel([1,2,3]), 6)
+            self.assertEqual(my_kernel(["x", "y"]), "(x+y)")
+            ex = expression(2,1,1,1,2,2,[my_kernel],32)
+            ex.set([0, 0, 1, 2])
+            self.assertTrue(np.allclose(ex.evaluate(x)[0], x[0] + x[1]))
+        self.assertRaises(ValueError, lambda: kernel.from_c_function(None, self.print_my_sum, "my_sum_kernel"))
+        # Kernels made from addresses are copied, but never pickled
+        import copy, pickle
+        self.assertEqual(copy.copy(kernels[2])([1,2,3]), 6)
+        self.assertRaises(TypeError, lambda: pickle.dumps(kernels[2]))
+
 class test_kernel_set(_ut.TestCase):
     def my_sum(self, x):
         return sum(x)
@@ -111,6 +183,132 @@ class test_expression(_ut.TestCase):
         self.assertEqual(ex([-1.]), [1])
         self.assertEqual(ex([-2.]), [1])
 
+    def test_evaluate(self):
+        from dcgpy import expression_double as expression
+        from dcgpy import expression_weighted_double as expression_weighted
+        from dcgpy import kernel_set_double as kernel_set
+        from dcgpy import kernel_double as kernel
+        import numpy as np
+
+        x = np.random.random((2, 100))
+        for ex in [expression(2,2,2,10,11,2,kernel_set(["sum","mul","diff"])(), 32),
+                   expression_weighted(2,2,2,10,11,2,kernel_set(["sum","mul","diff"])(), 32)]:
+            if isinstance(ex, expression_weighted):
+                ex.set_weights([0.5] * len(ex.get_weights()))
+            expected = np.array([ex(list(point)) for point in x.T]).T
+            self.assertTrue(np.allclose(ex.evaluate(x), expected))
+            # Non contiguous rows
+            self.assertTrue(np.allclose(ex.evaluate(np.asfortranarray(x)), expected))
+            out = np.zeros((2, 100))
+            self.assertTrue(ex.evaluate(x, out) is out)
+            self.assertTrue(np.allclose(out, expected))
+            self.assertRaises(ValueError, lambda: ex.evaluate(x.astype(np.float32)))
+            self.assertRaises(ValueError, lambda: ex.evaluate(np.zeros((3, 100))))
+            self.assertRaises(ValueError, lambda: ex.evaluate(x, np.zeros((2, 99))))
+        # Kernels defined in Python
+        my_kernel = kernel(lambda v: v[0] * v[1] + 1., lambda s: "(" + s[0] + "*" + s[1] + "+1)", "my_kernel")
+        ex = expression(1,1,1,10,11,2,[my_kernel], 32)
+        x = np.linspace(0, 1, 10)
+        self.assertTrue(np.allclose(ex.evaluate(x)[0], [ex([v])[0] for v in x]))
+
+    def test_get_graph(self):
+        from dcgpy import expression_double as expression
+        from dcgpy import expression_weighted_double as expression_weighted
+        from dcgpy import kernel_set_double as kernel_set
+        import numpy as np
+
+        ex = expression(2,1,1,3,3,2,kernel_set(["sum","mul"])(), 0)
+        ex.set([0, 0, 1, 1, 2, 2, 0, 0, 0, 3])
+        graph = ex.get_graph()
+        self.assertEqual(list(graph["nodes"]), [2, 3])
+        self.assertEqual(list(graph["kernels"]), [0, 1])
+        self.assertEqual(list(graph["arities"]), [2, 2])
+        self.assertEqual(graph["inputs"].tolist(), [[0, 1], [2, 2]])
+        self.assertEqual(list(graph["outputs"]), [3])
+        self.assertTrue(graph["weights"] is None)
+        ex = expression_weighted(2,1,1,3,3,2,kernel_set(["sum","mul"])(), 0)
+        ex.set([0, 0, 1, 1, 2, 2, 0, 0, 0, 3])
+        ex.set_weight(3, 1, 0.5)
+        self.assertEqual(ex.get_graph()["weights"].tolist(), [[1., 1.], [1., 0.5]])
+        # Unary kernels only read their first input: n2 = sin(x0), whose second input n1 is inactive
+        ex = expression(1,1,1,2,2,2,kernel_set(["sum","sin"])(), 0)
+        ex.set([0, 0, 0, 1, 0, 1, 2])
+        self.assertEqual(ex.get_active_nodes(), [0, 2])
+        graph = ex.get_graph()
+        self.assertEqual(list(graph["nodes"]), [2])
+        self.assertEqual(list(graph["arities"]), [1])
+        # The graph computes the expression
+        ex = expression(3,2,2,10,11,2,kernel_set(["sum","diff","mul","sin"])(), 32)
+        graph = ex.get_graph()
+        values = {0: 0.1, 1: 0.2, 2: 0.3}
+        f = ex.get_f()
+        for node, kernel, arity, inputs in zip(graph["nodes"], graph["kernels"], graph["arities"], graph["inputs"]):
+            values[node] = f[kernel]([values[i] for i in inputs[:arity]])
+        self.assertTrue(np.allclose([values[o] for o in graph["outputs"]], ex([0.1, 0.2, 0.3])))
+
+    def test_pickle(self):
+        from dcgpy import expression_double as expression
+        from dcgpy import expression_weighted_double as expression_weighted
+        from dcgpy import expression_weighted_gdual_double as expression_weighted_gdual
+        from dcgpy import kernel_set_double as kernel_set
+        from dcgpy import kernel_set_gdual_double as kernel_set_gdual
+        from dcgpy import kernel_double as kernel
+        import pickle, copy
+
+        ks = kernel_set(["sum","mul","diff","div"])
+        ks.push_back(kernel(_my_sum, _print_my_sum, "my_sum"))
+        for ex in [expression(2,1,2,10,11,2,ks(), 32), expression_weighted(2,1,2,10,11,2,ks(), 32)]:
+            ex.mutate_active(5)
+            if isinstance(ex, expression_weighted):
+                ex.set_weights([0.1 * i for i in range(len(ex.get_weights()))])
+            for other in [pickle.loads(pickle.dumps(ex)), copy.copy(ex), copy.deepcopy(ex)]:
+                self.assertEqual(type(other), type(ex))
+                self.assertEqual(other.get(), ex.get())
+                self.assertEqual(other([0.3, 0.7]), ex([0.3, 0.7]))
+                self.assertEqual(repr(other), repr(ex))
+                if isinstance(ex, expression_weighted):
+                    self.assertEqual(other.get_weights(), ex.get_weights())
+                # The random engine is restored: the mutations are the same
+                a = copy.copy(ex)
+                for i in range(10):
+                    a.mutate_active(2)
+                    other.mutate_active(2)
+                    self.assertEqual(a.get(), other.get())
+        # The kernel sets and the kernels are pickled too
+        ks2 = pickle.loads(pickle.dumps(ks))
+        self.assertEqual([k.__repr__() for k in ks2()], [k.__repr__() for k in ks()])
+        self.assertEqual(ks2[4]([1., 2.]), 3.)
+        self.assertEqual(ks2[4](["x", "y"]), "x+y")
+        # Python kernels are pickled by reference: lambdas cannot be
+        ex = expression(1,1,1,5,6,2,[kernel(lambda x: x[0], lambda s: s[0], "id")], 32)
+        self.assertRaises(Exception, lambda: pickle.dumps(ex))
+        # Weighted expressions of gduals cannot be pickled (the archive stores the weights as doubles)
+        ex = expression_weighted_gdual(1,1,1,5,6,2,kernel_set_gdual(["sum"])(), 32)
+        self.assertRaises(TypeError, lambda: pickle.dumps(ex))
+
+    def test_with_exact_kernels(self):
+        from dcgpy import expression_double as expression
+        from dcgpy import expression_weighted_double as expression_weighted
+        from dcgpy import kernel_set_double as kernel_set
+        import numpy as np
+
+        fast = kernel_set(["sum","mul","fast_sig","fast_exp"])
+        exact = kernel_set(["sum","mul","sig","exp"])
+        for cls in [expression, expression_weighted]:
+            ex = cls(2,1,2,10,11,2,fast(), 32)
+            ex_exact = cls(2,1,2,10,11,2,exact(), 32)
+            if cls is expression_weighted:
+                ex.set_weights([0.1 * i - 1. for i in range(len(ex.get_weights()))])
+                ex_exact.set_weights(ex.get_weights())
+            other = ex.with_exact_kernels()
+            self.assertEqual(type(other), cls)
+            self.assertEqual([repr(k) for k in other.get_f()], ["sum", "mul", "sig", "exp"])
+            self.assertEqual(other.get(), ex.get())
+            self.assertEqual(other([0.3, 0.7]), ex_exact([0.3, 0.7]))
+            self.assertTrue(np.allclose(ex([0.3, 0.7]), other([0.3, 0.7]), rtol = 1e-12))
+            # The fast kernels have the same symbolic representation
+            self.assertEqual(ex(["x", "y"]), other(["x", "y"]))
+
     def test_gdual_double(self):
         from dcgpy import expression_gdual_double as expression
         from dcgpy import kernel_set_gdual_double as kernel_set
@@ -131,6 +329,75 @@ class test_expression(_ut.TestCase):
         self.assertEqual(ex([gdual([1, 2, -1, 2], "x", 2)]), [gdual([1, 1, 1, 1])])
 
 
+class test_evolve(_ut.TestCase):
+
+    def test_quadratic_error(self):
+        from dcgpy import expression_double as expression
+        from dcgpy import expression_weighted_double as expression_weighted
+        from dcgpy import kernel_set_double as kernel_set
+        from dcgpy import quadratic_error, quadratic_errors
+        import numpy as np
+
+        x = np.linspace(-1, 1, 50)
+        y = x**3 + x
+        exs = [expression(1,1,1,10,11,2,kernel_set(["sum","mul","diff"])(), seed) for seed in range(5)]
+        exs.append(expression_weighted(1,1,1,10,11,2,kernel_set(["sum","mul","diff"])(), 32))
+        for ex in exs:
+            expected = np.mean((ex.evaluate(x)[0] - y)**2)
+            self.assertTrue(np.isclose(quadratic_error(ex, x, y), expected))
+            # Any array-like is accepted
+            self.assertTrue(np.isclose(quadratic_error(ex, [list(x)], list(y)), expected))
+            if expected > 1e-3:
+                self.assertEqual(quadratic_error(ex, x, y, cutoff = expected / 2), float("inf"))
+        errors = quadratic_errors(exs, x, y, threads = 3)
+        self.assertEqual(errors, [quadratic_error(ex, x, y) for ex in exs])
+        self.assertEqual(quadratic_errors([], x, y), [])
+        self.assertRaises(ValueError, lambda: quadratic_error(exs[0], np.zeros((2, 50)), y))
+        self.assertRaises(ValueError, lambda: quadratic_error(exs[0], x, y[:-1]))
+
+    def test_evolve(self):
+        from dcgpy import expression_double as expression
+        from dcgpy import expression_weighted_double as expression_weighted
+        from dcgpy import kernel_set_double as kernel_set
+        from dcgpy import kernel_double as kernel
+        from dcgpy import evolve, quadratic_error
+        import numpy as np
+
+        x = np.linspace(-1, 1, 50)
+        y = x**3 + x
+        ks = kernel_set(["sum","mul","diff","div"])()
+        ex = expression(1,1,1,15,16,2,ks, 32)
+        initial = quadratic_error(ex, x, y)
+        result = evolve(ex, x, y, max_generations = 200, threads = 2)
+        self.assertEqual(result["generations"], 200)
+        self.assertTrue(result["fitness"] <= initial or np.isnan(initial))
+        self.assertEqual(quadratic_error(ex, x, y), result["fitness"])
+        # The evolution does not depend on the number of threads
+        chromosomes = []
+        for threads in [1, 4]:
+            ex = expression_weighted(1,1,1,15,16,2,ks, 32)
+            evolve(ex, x, y, max_generations = 100, threads = threads)
+            chromosomes.append(ex.get())
+        self.assertEqual(chromosomes[0], chromosomes[1])
+        # The callback stops the evolution
+        generations = []
+        def callback(generation, fitness):
+            generations.append(generation)
+            return generation < 3
+        result = evolve(ex, x, y, callback = callback)
+        self.assertEqual(result["generations"], 3)
+        self.assertEqual(generations, [1, 2, 3])
+        def failing(generation, fitness):
+            raise KeyError()
+        self.assertRaises(KeyError, lambda: evolve(ex, x, y, callback = failing))
+        self.assertRaises(ValueError, lambda: evolve(ex, x, y, offspring = 0))
+        # Kernels defined in Python, evaluated on many threads
+        my_sum = kernel(lambda v: v[0] + v[1], lambda s: "(" + s[0] + "+" + s[1] + ")", "my_sum")
+        ex = expression(1,1,1,10,11,2,[my_sum] + kernel_set(["mul"])(), 32)
+        result = evolve(ex, x, y, max_generations = 20, threads = 4)
+        self.assertEqual(quadratic_error(ex, x, y), result["fitness"])
+
+
 def run_test_suite():
     """Run the full test suite.
     This function will raise an exception if at least one test fails.
@@ -139,9 +406,12 @@ def run_test_suite():
     suite_kernel = _ut.TestLoader().loadTestsFromTestCase(test_kernel)
     suite_kernel_set = _ut.TestLoader().loadTestsFromTestCase(test_kernel_set)
     suite_expression = _ut.TestLoader().loadTestsFromTestCase(test_expression)
+    suite_evolve = _ut.TestLoader().loadTestsFromTestCase(test_evolve)
     print("\nRunning tests on kernel function")
     test_result = _ut.TextTestRunner(verbosity=2).run(suite_kernel)
     print("\nRunning tests on kernel_set construction")
     test_result = _ut.TextTestRunner(verbosity=2).run(suite_kernel_set)
     print("\nRunning tests on CGP expressions")
     test_result = _ut.TextTestRunner(verbosity=2).run(suite_expression)
+    print("\nRunning tests on the evolution and fitness functions")
+    test_result = _ut.TextTestRunner(verbosity=2).run(suite_evolve)
@@ -0,0 +1,24 @@
+#include <iostream>
+#include <string>
+
+#include <dcgp/dataset.hpp>
+
+// Converts a dataset from the csv format of the CGP-Library to the dcgp binary format, which
+// dcgp::dataset::load_binary maps in memory with no parsing.
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 4 || (argc == 4 && std::string(argv[3]) != "--float32")) {
+        std::cerr << "Usage: " << argv[0] << " input.csv output.dcgpd [--float32]" << std::endl;
+        return 1;
+    }
+    try {
+        auto data = dcgp::dataset::read_csv(argv[1]);
+        data.save_binary(argv[2], argc == 4);
+        std::cout << "Converted " << data.size() << " points with " << data.get_n() << " inputs and "
+                  << data.get_m() << " outputs" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,8 +1,13 @@
 #include <iostream>
+#include <memory>
 #include <random>
 #include <vector>
 
+#include <dcgp/dataset.hpp>
 #include <dcgp/expression.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/racing_fitness.hpp>
+#include <dcgp/trace.hpp>
 
 struct es_params {
     unsigned int m_childs;
@@ -10,11 +15,12 @@ struct es_params {
     unsigned int m_n;
     double m_mut_prob;
     unsigned int m_gen;
+    // If true the children are raced (see dcgp::racing_fitness) rather than evaluated on all the data
+    bool m_racing = false;
 };
 
-// Evolves the expression ex to fit the in-out supervised data
-void es(const std::vector<std::vector<double>> &in, const std::vector<std::vector<double>> &out,
-        dcgp::expression<double> &ex, const es_params &p)
+// Evolves the expression ex to fit the supervised data
+void es(const dcgp::dataset &data, dcgp::expression<double> &ex, const es_params &p)
 {
     // Random seed
     std::random_device rd;
@@ -24,25 +30,46 @@ void es(const std::vector<std::vector<double>> &in, const std::vector<std::vecto
     std::vector<double> newfits(p.m_childs, 0.);
     std::vector<std::vector<unsigned int>> newchromosomes(p.m_childs);
     std::vector<unsigned int> best_chromosome(ex.get());
+    std::vector<dcgp::expression<double>> children;
+    std::unique_ptr<dcgp::racing_fitness> racing;
+    if (p.m_racing) {
+        racing.reset(new dcgp::racing_fitness(data, 1000u, 2., rd()));
+    }
     unsigned int gen = 0;
 
     do {
         gen++;
-        for (auto i = 0u; i < newfits.size(); ++i) {
-            ex.set(best_chromosome);
-            if (p.m_mutation_type == "active") {
-                ex.mutate_active(p.m_n);
+        children.clear();
+        {
+            dcgp::trace_scope scope("mutation", "es");
+            for (auto i = 0u; i < newfits.size(); ++i) {
+                ex.set(best_chromosome);
+                if (p.m_mutation_type == "active") {
+                    ex.mutate_active(p.m_n);
+                } else {
+                    std::vector<unsigned int> tbm;
+                    for (auto j = 0u; j < best_chromosome.size(); ++j) {
+                        if (std::uniform_real_distribution<double>(0, 1)(re) < p.m_mut_prob) tbm.push_back(j);
+                    }
+                    ex.mutate(tbm);
+                }
+                children.push_back(ex);
+                newchromosomes[i] = ex.get();
+            }
+        }
+        // Children worse than the parent do not matter
+        {
+            dcgp::trace_scope scope("evaluation", "es");
+            if (racing) {
+                newfits = (*racing)(children, best_fit);
             } else {
-                std::vector<unsigned int> tbm;
-                for (auto j = 0u; j < best_chromosome.size(); ++j) {
-                    if (std::uniform_real_distribution<double>(0, 1)(re) < p.m_mut_prob) tbm.push_back(j);
+                for (auto i = 0u; i < newfits.size(); ++i) {
+                    newfits[i] = dcgp::quadratic_error(children[i], data, best_fit);
                 }
-                ex.mutate(tbm);
             }
-            newfits[i] = quadratic_error(ex, in, out);
-            newchromosomes[i] = ex.get();
         }
 
+        dcgp::trace_scope scope("selection", "es");
         for (auto i = 0u; i < newfits.size(); ++i) {
             if (newfits[i] <= best_fit) {
                 if (newfits[i] != best_fit) {
@@ -57,4 +84,8 @@ void es(const std::vector<std::vector<double>> &in, const std::vector<std::vecto
     } while (best_fit > 1e-3 && gen < p.m_gen);
     ex.set(best_chromosome);
     std::cout << "Number of generations: " << gen << std::endl;
+    if (racing) {
+        std::cout << "Point evaluations: " << racing->get_evaluations()
+                  << ", saved by racing: " << racing->get_saved_evaluations() << std::endl;
+    }
 }
@@ -1,5 +1,6 @@
 #include <iostream>
 
+#include <dcgp/differential_fitness.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/kernel_set.hpp>
 
@@ -8,18 +9,17 @@
 
 double fitness(const dcgp::expression<gdual_d> &ex, const std::vector<std::vector<gdual_d>> &in, double &check)
 {
+    // The derivatives are resolved once against the symbols, then extracted by position at every point
+    static const dcgp::derivative_index idx({"pr", "pt", "r", "th", "m", "mu"},
+                                            {{0u, {{"dpr", 1u}}}, {0u, {{"dr", 1u}}}, {0u, {{"dth", 1u}}}});
+    std::vector<double> d(idx.size());
     double retval = 0;
     check = 0;
     for (auto i = 0u; i < in.size(); ++i) {
-        auto T = ex(in[i]); // We compute all the derivatives up to order one
-        std::vector<std::string> symbol_list{"pr", "pt", "r", "th", "m", "mu"};
-        for (auto sym : symbol_list) {
-            T[0] += gdual_d(0, sym, 0); // We make sure that the symbols are all in the final expression
-        }
-        double dFpr = T[0].get_derivative({{"dpr", 1}});
-        // double dFpt= T[0].get_derivative({{"dpt", 1}});
-        double dFqr = T[0].get_derivative({{"dr", 1}});
-        double dFqt = T[0].get_derivative({{"dth", 1}});
+        idx(ex(in[i]), d.data()); // We compute all the derivatives up to order one
+        double dFpr = d[0];
+        double dFqr = d[1];
+        double dFqt = d[2];
         double pr = in[i][0].constant_cf();
         double pt = in[i][1].constant_cf();
         double qr = in[i][2].constant_cf();
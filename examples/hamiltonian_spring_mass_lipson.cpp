@@ -1,5 +1,6 @@
 #include <iostream>
 
+#include <dcgp/differential_fitness.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/kernel_set.hpp>
 
@@ -8,11 +9,14 @@
 
 double fitness(const dcgp::expression<gdual_d> &ex, const std::vector<std::vector<gdual_d>> &in)
 {
+    // The derivatives are resolved once against the symbols, then extracted by position at every point
+    static const dcgp::derivative_index idx({"p", "q"}, {{0u, {{"dp", 1u}}}, {0u, {{"dq", 1u}}}});
+    std::vector<double> d(idx.size());
     double retval = 0;
     for (auto i = 0u; i < in.size(); ++i) {
-        auto T = ex(in[i]); // We compute all the derivatives up to order one
-        double dFp = T[0].get_derivative({{"dp", 1}});
-        double dFq = T[0].get_derivative({{"dq", 1}});
+        idx(ex(in[i]), d.data()); // We compute all the derivatives up to order one
+        double dFp = d[0];
+        double dFq = d[1];
         double p = in[i][0].constant_cf();
         double q = in[i][1].constant_cf();
         double err = dFp / dFq - p / q; // Here we set (dp/dt) / (dq/dt) = dp/dq
@@ -8,12 +8,12 @@
 #include <string>
 #include <vector>
 
+#include <dcgp/dataset.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/fitness_functions.hpp>
 #include <dcgp/kernel_set.hpp>
 
 #include "detail/es.hpp"
-#include "detail/read_data.hpp"
 
 using namespace dcgp;
 
@@ -22,8 +22,7 @@ int main()
     // Random seed
     std::random_device rd;
     // We read the data from file
-    std::vector<std::vector<double>> in, out;
-    read_data(in, out, "../../examples/data/symbolic.data");
+    auto data = dcgp::dataset::read_csv("../../examples/data/symbolic.data");
 
     // Function set
     dcgp::kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
@@ -37,10 +36,10 @@ int main()
     // We use a simple ES(1+4) to evolve an expression that represents our target.
     // Mutation only mutates 2 active genes
     es_params params{4, "active", 2, 0, 1000};
-    es(in, out, ex, params);
+    es(data, ex, params);
 
     // We print out the final expression
     audi::stream(std::cout, "Final expression: ", ex(in_sym), "\n");
-    audi::stream(std::cout, "Final value: ", quadratic_error(ex, in, out), "\n");
+    audi::stream(std::cout, "Final value: ", quadratic_error(ex, data), "\n");
     return false;
 }
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <random>
 
+#include <dcgp/dataset.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/fitness_functions.hpp>
 #include <dcgp/kernel_set.hpp>
@@ -41,7 +42,7 @@ bool kq(unsigned int r, unsigned int c, unsigned int l, unsigned int a,
     // 2) we use a simple ES(1+4) to evolve an expression that represents our target.
     // Mutation only mutates 2 active genes
     es_params params{4, "active", 2, 0, 1000};
-    es(in, out, ex, params);
+    es(dcgp::dataset(in, out), ex, params);
 
     dcgp::stream(std::cout, "Final expression: ", ex(in_sym), "\n");
     return false;
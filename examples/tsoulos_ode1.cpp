@@ -1,23 +1,22 @@
 #include <iostream>
 
+#include <dcgp/differential_fitness.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/kernel_set.hpp>
 
 // Here we solve the differential equation dy = (2x - y) / x from Tsoulos paper
 // Tsoulos and Lagaris: "Solving Differential equations with genetic programming"
 
-double fitness(const dcgp::expression<gdual_d> &ex, const std::vector<std::vector<gdual_d>> &in)
+// The expression and its derivative are computed in all the points of the grid at once (vectorized gduals)
+double fitness(const dcgp::expression<gdual_v> &ex, const std::vector<gdual_v> &in, const std::vector<double> &x)
 {
-    double retval = 0;
-    for (auto i = 0u; i < in.size(); ++i) {
-        auto T = ex(in[i]); // We compute the expression and thus the derivatives
-        double y = T[0].get_derivative({0});
-        double dy = T[0].get_derivative({1});
-        double x = in[i][0].constant_cf();
-        double ode1 = (2. * x - y) / x;
-        retval += (ode1 - dy) * (ode1 - dy); // We compute the quadratic error
-    }
-    return retval;
+    // We compute the quadratic error (differential_error returns its mean over the grid)
+    return static_cast<double>(x.size())
+           * dcgp::differential_error(ex, in, {{0u, {}}, {0u, {{"dx", 1u}}}},
+                                      [&x](std::size_t k, const std::vector<double> &d) {
+                                          double ode1 = (2. * x[k] - d[0]) / x[k];
+                                          return ode1 - d[1];
+                                      });
 }
 
 int main()
@@ -26,20 +25,20 @@ int main()
     std::random_device rd;
 
     // Function set
-    dcgp::kernel_set<gdual_d> basic_set({"sum", "diff", "mul", "div", "exp", "log", "sin", "cos"});
+    dcgp::kernel_set<gdual_v> basic_set({"sum", "diff", "mul", "div", "exp", "log", "sin", "cos"});
 
     // d-CGP expression
-    dcgp::expression<gdual_d> ex(1, 1, 1, 15, 16, 2, basic_set(), rd());
+    dcgp::expression<gdual_v> ex(1, 1, 1, 15, 16, 2, basic_set(), rd());
 
     // Symbols
     std::vector<std::string> in_sym({"x"});
 
     // We create the grid over x
-    std::vector<std::vector<gdual_d>> in(10u);
-    for (auto i = 0u; i < in.size(); ++i) {
-        gdual_d point(0.1 + 0.9 / static_cast<double>((in.size() - 1)) * i, "x", 1);
-        in[i].push_back(point); // 1, .., 2
+    std::vector<double> x(10u);
+    for (auto i = 0u; i < x.size(); ++i) {
+        x[i] = 0.1 + 0.9 / static_cast<double>((x.size() - 1)) * i; // 1, .., 2
     }
+    auto in = dcgp::grid_inputs({x}, in_sym, 1u);
 
     // We run the (1-4)-ES
     auto best_fit = 1e32;
@@ -53,8 +52,9 @@ int main()
         for (auto i = 0u; i < newfits.size(); ++i) {
             ex.set(best_chromosome);
             ex.mutate_active(2);
-            auto fitness_ic = ex({gdual_d(1.)})[0] - 3.; // Penalty term to enforce the initial conditions
-            newfits[i] = fitness(ex, in) + fitness_ic.constant_cf() * fitness_ic.constant_cf(); // Total fitness
+            // Penalty term to enforce the initial conditions
+            auto fitness_ic = ex({gdual_v(1.)})[0].constant_cf()[0] - 3.;
+            newfits[i] = fitness(ex, in, x) + fitness_ic * fitness_ic; // Total fitness
             newchromosomes[i] = ex.get();
         }
 
@@ -0,0 +1,89 @@
+#ifndef DCGP_BOUNDS_H
+#define DCGP_BOUNDS_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/interval.hpp>
+#include <dcgp/kernel_set.hpp>
+
+namespace dcgp
+{
+
+namespace detail
+{
+
+// The kernels of ex, on intervals
+template <typename T>
+std::vector<kernel<interval>> interval_kernels(const expression<T> &ex)
+{
+    kernel_set<interval> kernels;
+    for (const auto &k : ex.get_f()) {
+        kernels.push_back(k.get_name());
+    }
+    return kernels();
+}
+
+inline void check_domain(unsigned n, const std::vector<interval> &domain)
+{
+    if (domain.size() != n) {
+        throw std::invalid_argument("The domain has " + std::to_string(domain.size()) + " intervals, "
+                                    + std::to_string(n) + " are needed");
+    }
+}
+
+} // namespace detail
+
+/// Bounds the outputs of a dCGP expression over a domain
+/**
+ * Evaluates the dCGP expression \p ex in interval arithmetic (see dcgp::interval): the result contains the
+ * value of each output for every input in \p domain. Expressions whose bounds are infinite or empty may divide
+ * by zero, take the logarithm of non positive numbers or overflow somewhere in the domain, and can be rejected
+ * or penalized at the cost of a single evaluation.
+ *
+ * @param[in] ex the dCGP expression
+ * @param[in] domain the range of each input
+ *
+ * @return the bounds of each output
+ *
+ * @throw std::invalid_argument if the size of \p domain is not the number of inputs, or if \p ex uses kernels
+ * with no interval version (e.g. user-defined kernels)
+ */
+template <typename T>
+std::vector<interval> output_bounds(const expression<T> &ex, const std::vector<interval> &domain)
+{
+    detail::check_domain(ex.get_n(), domain);
+    expression<interval> ex_i(ex.get_n(), ex.get_m(), ex.get_rows(), ex.get_cols(), ex.get_levels_back(),
+                              ex.get_arity(), detail::interval_kernels(ex), 0u);
+    ex_i.set(ex.get());
+    return ex_i(domain);
+}
+
+/// Bounds the outputs of a weighted dCGP expression over a domain
+/**
+ * Same as the overload for dcgp::expression, with the current values of the weights.
+ *
+ * @param[in] ex the weighted dCGP expression
+ * @param[in] domain the range of each input
+ *
+ * @return the bounds of each output
+ *
+ * @throw std::invalid_argument if the size of \p domain is not the number of inputs, or if \p ex uses kernels
+ * with no interval version (e.g. user-defined kernels)
+ */
+inline std::vector<interval> output_bounds(const expression_weighted<double> &ex, const std::vector<interval> &domain)
+{
+    detail::check_domain(ex.get_n(), domain);
+    expression_weighted<interval> ex_i(ex.get_n(), ex.get_m(), ex.get_rows(), ex.get_cols(), ex.get_levels_back(),
+                                       ex.get_arity(), detail::interval_kernels(ex), 0u);
+    ex_i.set(ex.get());
+    ex_i.set_weights(std::vector<interval>(ex.get_weights().begin(), ex.get_weights().end()));
+    return ex_i(domain);
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_BOUNDS_H
@@ -0,0 +1,210 @@
+#ifndef DCGP_CODE_GENERATOR_H
+#define DCGP_CODE_GENERATOR_H
+
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+
+namespace dcgp
+{
+
+namespace detail
+{
+
+// Checks that name is a valid C identifier
+inline bool is_c_identifier(const std::string &name)
+{
+    if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    for (auto c : name) {
+        if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Prints a double as a C literal that round-trips exactly
+inline std::string c_literal(double value)
+{
+    if (std::isnan(value)) {
+        return "NAN";
+    }
+    if (std::isinf(value)) {
+        return value > 0 ? "INFINITY" : "(-INFINITY)";
+    }
+    std::ostringstream oss;
+    oss.imbue(std::locale::classic());
+    oss << std::setprecision(std::numeric_limits<double>::max_digits10) << value;
+    auto retval = oss.str();
+    if (retval.find_first_of(".eE") == std::string::npos) {
+        retval += ".";
+    }
+    return value < 0 ? "(" + retval + ")" : retval;
+}
+
+// Joins the arguments with a binary C operator
+inline std::string c_join(const std::vector<std::string> &in, const std::string &op)
+{
+    std::string retval(in[0]);
+    for (auto i = 1u; i < in.size(); ++i) {
+        retval += " " + op + " " + in[i];
+    }
+    return retval;
+}
+
+// Returns the C code computing the kernel called name on the arguments in
+inline std::string c_kernel_code(const std::string &name, const std::vector<std::string> &in)
+{
+    if (name == "sum") {
+        return c_join(in, "+");
+    } else if (name == "diff") {
+        return c_join(in, "-");
+    } else if (name == "mul") {
+        return c_join(in, "*");
+    } else if (name == "div") {
+        return c_join(in, "/");
+    } else if (name == "pdiv") {
+        // A conditional move, not a branch, on all the compilers we care about
+        return "(" + in[0] + " == " + in[1] + ") ? 1. : " + in[0] + " / " + in[1];
+    } else if (name == "sig" || name == "fast_sig") {
+        return "1. / (1. + exp(-(" + c_join(in, "+") + ")))";
+    } else if (name == "sin") {
+        return "sin(" + in[0] + ")";
+    } else if (name == "cos") {
+        return "cos(" + in[0] + ")";
+    } else if (name == "log") {
+        return "log(" + in[0] + ")";
+    } else if (name == "exp" || name == "fast_exp") {
+        return "exp(" + in[0] + ")";
+    }
+    throw std::invalid_argument("The kernel " + name + " has no C counterpart: code cannot be generated");
+}
+
+// Writes the body of the generated function: one constant per active node, then the outputs.
+// x and y are the C expressions used to access the i-th input and output (the placeholder $ is
+// replaced by the index). weights may be empty (unweighted expression).
+template <typename T>
+void c_function_body(std::ostream &os, const expression<T> &ex, const std::vector<double> &weights,
+                     const std::string &x, const std::string &y, const std::string &indent)
+{
+    auto subs = [](const std::string &pattern, unsigned idx) {
+        auto retval = pattern;
+        retval.replace(retval.find('$'), 1u, std::to_string(idx));
+        return retval;
+    };
+    auto node_name = [&ex, &x, &subs](unsigned node_id) {
+        return node_id < ex.get_n() ? subs(x, node_id) : "n" + std::to_string(node_id);
+    };
+    const auto &chromosome = ex.get();
+    const auto arity = ex.get_arity();
+    std::vector<std::string> function_in;
+    for (auto node_id : ex.get_active_nodes()) {
+        if (node_id < ex.get_n()) {
+            continue;
+        }
+        unsigned idx = (node_id - ex.get_n()) * (arity + 1u);
+        function_in.resize(ex.get_node_arity(node_id));
+        for (decltype(function_in.size()) j = 0u; j < function_in.size(); ++j) {
+            function_in[j] = node_name(chromosome[idx + j + 1u]);
+            if (weights.size()) {
+                function_in[j] = "(" + c_literal(weights[(node_id - ex.get_n()) * arity + j]) + " * " + function_in[j]
+                                 + ")";
+            }
+        }
+        os << indent << "const double " << node_name(node_id) << " = "
+           << c_kernel_code(ex.get_f()[chromosome[idx]].get_name(), function_in) << ";\n";
+    }
+    for (auto i = 0u; i < ex.get_m(); ++i) {
+        os << indent << subs(y, i) << " = "
+           << node_name(chromosome[ex.get_rows() * ex.get_cols() * (arity + 1u) + i]) << ";\n";
+    }
+}
+
+template <typename T>
+std::string c_source(const expression<T> &ex, const std::vector<double> &weights, const std::string &name)
+{
+    if (!is_c_identifier(name)) {
+        throw std::invalid_argument("The function name " + name + " is not a valid C identifier");
+    }
+    std::ostringstream os;
+    os << "/* Generated by dcgp: d-CGP expression with " << ex.get_n() << " inputs and " << ex.get_m()
+       << " outputs. */\n";
+    os << "#include <math.h>\n#include <stddef.h>\n\n";
+    os << "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n";
+    os << "/* Evaluates the expression in the point x (size " << ex.get_n() << ") writing y (size " << ex.get_m()
+       << "). */\n";
+    os << "void " << name << "(const double *x, double *y)\n{\n";
+    c_function_body(os, ex, weights, "x[$]", "y[$]", "    ");
+    os << "}\n\n";
+    os << "/* Evaluates the expression in N points. x[j] and y[i] point to the N values of the j-th input\n"
+          " * and of the i-th output. */\n";
+    os << "void " << name << "_batch(const double *const *x, double *const *y, size_t N)\n{\n";
+    os << "    size_t k;\n";
+    os << "    for (k = 0; k < N; ++k) {\n";
+    c_function_body(os, ex, weights, "x[$][k]", "y[$][k]", "        ");
+    os << "    }\n}\n\n";
+    os << "#ifdef __cplusplus\n}\n#endif\n";
+    return os.str();
+}
+
+} // namespace detail
+
+/// Generates standalone C source code for a dCGP expression
+/**
+ * Generates the source code of two C functions that compute the dCGP expression \p ex using only its active
+ * nodes. The code depends only on the C standard library (math.h) and compiles both as C and as C++:
+ *
+ * @code
+ * void name(const double *x, double *y);
+ * void name_batch(const double *const *x, double *const *y, size_t N);
+ * @endcode
+ *
+ * The first evaluates the expression in one point, the second in \p N points stored by column (x[j][k] is the
+ * j-th input of the k-th point). Both are straight-line code, with no dispatch on the kernels.
+ *
+ * @param[in] ex the dCGP expression
+ * @param[in] name the name of the generated function
+ *
+ * @return a string containing the C source code
+ *
+ * @throw std::invalid_argument if \p name is not a valid C identifier or if the active nodes use a kernel with
+ * no C counterpart (e.g. a user-defined kernel)
+ */
+template <typename T>
+std::string generate_c_source(const expression<T> &ex, const std::string &name)
+{
+    return detail::c_source(ex, {}, name);
+}
+
+/// Generates standalone C source code for a weighted dCGP expression
+/**
+ * Same as the overload for dcgp::expression, the current values of the weights are hard-coded in the
+ * generated code.
+ *
+ * @param[in] ex the weighted dCGP expression
+ * @param[in] name the name of the generated function
+ *
+ * @return a string containing the C source code
+ *
+ * @throw std::invalid_argument if \p name is not a valid C identifier or if the active nodes use a kernel with
+ * no C counterpart (e.g. a user-defined kernel)
+ */
+inline std::string generate_c_source(const expression_weighted<double> &ex, const std::string &name)
+{
+    return detail::c_source(ex, ex.get_weights(), name);
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_CODE_GENERATOR_H
@@ -0,0 +1,598 @@
+#ifndef DCGP_DATASET_H
+#define DCGP_DATASET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dcgp/mapped_file.hpp>
+#include <dcgp/trace.hpp>
+
+namespace dcgp
+{
+
+namespace detail
+{
+
+inline bool is_csv_separator(char c)
+{
+    return c == ',' || c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Parses the double in [first, last). The common case (at most 19 significant digits and a small exponent)
+// is computed exactly with one floating point operation (Clinger's fast path), the rest goes through strtod.
+inline double parse_double(const char *first, const char *last)
+{
+    static const double powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *p = first;
+    const bool negative = (p != last && *p == '-');
+    if (p != last && (*p == '-' || *p == '+')) {
+        ++p;
+    }
+    std::uint64_t mantissa = 0u;
+    int digits = 0, exponent = 0;
+    bool any_digit = false, exact = true;
+    for (; p != last && *p >= '0' && *p <= '9'; ++p) {
+        any_digit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10u + static_cast<unsigned>(*p - '0');
+            digits += (mantissa != 0u);
+        } else {
+            ++exponent;
+            exact = exact && (*p == '0');
+        }
+    }
+    if (p != last && *p == '.') {
+        for (++p; p != last && *p >= '0' && *p <= '9'; ++p) {
+            any_digit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10u + static_cast<unsigned>(*p - '0');
+                digits += (mantissa != 0u);
+                --exponent;
+            } else {
+                exact = exact && (*p == '0');
+            }
+        }
+    }
+    if (any_digit && p != last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        const bool negative_exponent = (p != last && *p == '-');
+        if (p != last && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+        int e = 0;
+        bool any_exponent_digit = false;
+        for (; p != last && *p >= '0' && *p <= '9'; ++p) {
+            any_exponent_digit = true;
+            e = std::min(e * 10 + (*p - '0'), 100000);
+        }
+        exact = exact && any_exponent_digit;
+        exponent += negative_exponent ? -e : e;
+    }
+    if (any_digit && exact && p == last && mantissa <= (std::uint64_t(1) << 53)) {
+        if (mantissa == 0u) {
+            return negative ? -0. : 0.;
+        }
+        if (exponent >= -22 && exponent <= 22) {
+            auto value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+            return negative ? -value : value;
+        }
+    }
+    // Slow path: many digits, large exponents, inf, nan, ...
+    const std::string token(first, last);
+    char *end;
+    const double value = std::strtod(token.c_str(), &end);
+    if (token.empty() || end != token.c_str() + token.size()) {
+        throw std::invalid_argument("Could not parse the number '" + token + "'");
+    }
+    return value;
+}
+
+/*--------------------------------------------------------------------------
+ * Binary dataset format (native byte order, checked through a marker):
+ *
+ * header:  char[8] magic "DCGP-DAT", uint32 byte order marker, uint32 version,
+ *          uint32 n, uint32 m, uint64 N, uint32 bytes per value (8: float64, 4: float32),
+ *          uint32 reserved, uint64 stride, zero padding up to 64 bytes
+ * columns: the n inputs and then the m outputs, each made of stride values (N values
+ *          followed by zeros). stride is such that every column starts at a multiple of 64 bytes.
+ *
+ * float64 columns are used in place from the memory-mapped file.
+ *------------------------------------------------------------------------**/
+
+constexpr char dataset_magic[8] = {'D', 'C', 'G', 'P', '-', 'D', 'A', 'T'};
+constexpr std::uint32_t dataset_byte_order = 0x01020304u;
+constexpr std::uint32_t dataset_version = 1u;
+constexpr std::size_t dataset_header_size = 64u;
+
+struct dataset_header {
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t n;
+    std::uint32_t m;
+    std::uint64_t N;
+    std::uint32_t value_size;
+    std::uint32_t reserved;
+    std::uint64_t stride;
+};
+
+// Reads and validates the header of a binary dataset. size is the size of the whole file,
+// of which at least the first dataset_header_size bytes must be in data
+inline dataset_header read_dataset_header(const char *data, std::uint64_t size, const std::string &filename)
+{
+    dataset_header header;
+    if (size < dataset_header_size) {
+        throw std::invalid_argument("The file " + filename + " is not a dcgp binary dataset");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, dataset_magic, sizeof(header.magic)) != 0) {
+        throw std::invalid_argument("The file " + filename + " is not a dcgp binary dataset");
+    }
+    if (header.byte_order != dataset_byte_order) {
+        throw std::invalid_argument("The dataset " + filename + " was written with a different byte order");
+    }
+    if (header.version != dataset_version) {
+        throw std::invalid_argument("The dataset " + filename + " has the unsupported version "
+                                    + std::to_string(header.version));
+    }
+    if ((header.value_size != 8u && header.value_size != 4u) || header.stride < header.N
+        || header.stride > (std::uint64_t(1) << 56) || (header.stride * header.value_size) % 64u != 0u) {
+        throw std::invalid_argument("The dataset " + filename + " has a corrupted header");
+    }
+    const auto n_columns = static_cast<std::uint64_t>(header.n) + header.m;
+    const auto column_size = header.stride * header.value_size;
+    if (column_size && (size - dataset_header_size) / column_size < n_columns) {
+        throw std::invalid_argument("The dataset " + filename + " is truncated");
+    }
+    return header;
+}
+
+} // namespace detail
+
+class streamed_dataset;
+
+/// A dataset
+/**
+ * This class stores \p N input-output pairs for the supervised learning of dCGP expressions with \p n inputs
+ * and \p m outputs. The data are stored by column: each input and each output is a contiguous array of
+ * \p N doubles aligned to 64 bytes (a cache line), which is the layout the batch evaluation of
+ * dcgp::expression and the fitness functions work on directly.
+ *
+ * The data are read from CSV files (dcgp::dataset::read_csv()) or, with no parsing at all, from the
+ * dcgp binary format (dcgp::dataset::load_binary()). Copies are cheap and share the (immutable) data.
+ */
+class dataset
+{
+public:
+    /// Default constructor
+    /**
+     * Constructs an empty dataset
+     */
+    dataset() : m_n(0u), m_m(0u), m_N(0u) {}
+
+    /// Constructor
+    /**
+     * Constructs a dataset from the points stored by row, as used by dcgp::quadratic_error()
+     *
+     * @param[in] in the inputs: \p N vectors of size \p n
+     * @param[in] out the outputs: \p N vectors of size \p m
+     *
+     * @throw std::invalid_argument if the sizes are inconsistent
+     */
+    dataset(const std::vector<std::vector<double>> &in, const std::vector<std::vector<double>> &out)
+    {
+        if (in.size() != out.size()) {
+            throw std::invalid_argument("Size of the input vector must be the size of the output vector");
+        }
+        allocate(in.size() ? static_cast<unsigned>(in[0].size()) : 0u,
+                 out.size() ? static_cast<unsigned>(out[0].size()) : 0u, in.size());
+        for (decltype(in.size()) k = 0u; k < in.size(); ++k) {
+            if (in[k].size() != m_n || out[k].size() != m_m) {
+                throw std::invalid_argument("All the points of a dataset must have the same number of inputs and "
+                                            "outputs");
+            }
+            for (auto j = 0u; j < m_n; ++j) {
+                column(j)[k] = in[k][j];
+            }
+            for (auto i = 0u; i < m_m; ++i) {
+                column(m_n + i)[k] = out[k][i];
+            }
+        }
+    }
+
+    /// Constructor
+    /**
+     * Constructs a dataset copying the data stored by column (e.g. the rows of NumPy arrays)
+     *
+     * @param[in] in the inputs: \p n arrays of \p N doubles
+     * @param[in] out the outputs: \p m arrays of \p N doubles
+     * @param[in] N the number of points
+     */
+    dataset(const std::vector<const double *> &in, const std::vector<const double *> &out, std::size_t N)
+    {
+        allocate(static_cast<unsigned>(in.size()), static_cast<unsigned>(out.size()), N);
+        for (auto j = 0u; j < m_n; ++j) {
+            std::copy(in[j], in[j] + N, column(j));
+        }
+        for (auto i = 0u; i < m_m; ++i) {
+            std::copy(out[i], out[i] + N, column(m_n + i));
+        }
+    }
+
+    /// Reads a dataset in the CSV format of the CGP-Library
+    /**
+     * Reads the file \p filename in the format specified by Andrew James Turner in his CGP-Library:
+     * the values "n,m,N," followed by the \p N rows "x_0,...,x_n-1,y_0,...,y_m-1,", each on its own line.
+     * Commas and blanks are both accepted as separators.
+     *
+     * The file is memory-mapped and split in chunks that are parsed in parallel.
+     *
+     * @param[in] filename the file name
+     * @param[in] n_threads the number of threads to use (0 selects the number of hardware threads)
+     *
+     * @return the dataset
+     *
+     * @throw std::runtime_error if the file cannot be read
+     * @throw std::invalid_argument if the file is not in the expected format (e.g. a row does not have
+     * n + m values, or the file does not have N rows)
+     */
+    static dataset read_csv(const std::string &filename, unsigned n_threads = 0u)
+    {
+        trace_scope scope("read_csv", "io");
+        mapped_file file(filename);
+        const char *first = file.data();
+        const char *last = first + file.size();
+
+        // Whether the separators after a token end its line (or the file)
+        auto ends_line = [last](const char *token_end) {
+            const char *next = std::find_if(token_end, last, [](char c) { return !detail::is_csv_separator(c); });
+            return next == last || std::find(token_end, next, '\n') != next;
+        };
+
+        // The header
+        unsigned header[3];
+        for (auto &value : header) {
+            first = std::find_if(first, last, [](char c) { return !detail::is_csv_separator(c); });
+            const char *token_end = std::find_if(first, last, detail::is_csv_separator);
+            const auto parsed = (first == token_end) ? -1. : detail::parse_double(first, token_end);
+            // NOTE: the range is checked before the conversion, which is undefined for out of range values
+            if (!(parsed >= 0. && parsed <= std::numeric_limits<unsigned>::max() && parsed == std::floor(parsed))) {
+                throw std::invalid_argument("The file " + filename + " does not start with the header n,m,N");
+            }
+            value = static_cast<unsigned>(parsed);
+            first = token_end;
+        }
+        if (!ends_line(first)) {
+            throw std::invalid_argument("The header of the file " + filename + " has more than the values n,m,N");
+        }
+        const auto n_columns = static_cast<std::size_t>(header[0]) + header[1];
+        const std::size_t N = header[2];
+        if (N != 0u && (n_columns == 0u || n_columns > std::numeric_limits<std::size_t>::max() / N)) {
+            throw std::invalid_argument("The header of the file " + filename + " gives an invalid number of values");
+        }
+        const auto n_values = n_columns * N;
+
+        // We split the data in chunks starting at separators, small files are parsed serially
+        if (n_threads == 0u) {
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const auto n_chunks = std::min<std::size_t>(n_threads, static_cast<std::size_t>(last - first) / 65536u + 1u);
+        std::vector<const char *> bounds(n_chunks + 1u, last);
+        bounds[0] = first;
+        for (std::size_t t = 1u; t < n_chunks; ++t) {
+            bounds[t] = std::find_if(std::max(bounds[t - 1u], first + (last - first) * static_cast<std::ptrdiff_t>(t)
+                                                                       / static_cast<std::ptrdiff_t>(n_chunks)),
+                                     last, detail::is_csv_separator);
+        }
+        auto for_each_token = [&bounds](std::size_t t, const std::function<void(const char *, const char *)> &f) {
+            const char *p = bounds[t];
+            while (true) {
+                p = std::find_if(p, bounds[t + 1u], [](char c) { return !detail::is_csv_separator(c); });
+                if (p == bounds[t + 1u]) {
+                    break;
+                }
+                const char *token_end = std::find_if(p, bounds[t + 1u], detail::is_csv_separator);
+                f(p, token_end);
+                p = token_end;
+            }
+        };
+        auto parallel_for = [n_chunks](const std::function<void(std::size_t)> &f) {
+            std::vector<std::exception_ptr> errors(n_chunks);
+            std::vector<std::thread> threads;
+            for (std::size_t t = 1u; t < n_chunks; ++t) {
+                threads.emplace_back([&f, &errors, t]() {
+                    try {
+                        f(t);
+                    } catch (...) {
+                        errors[t] = std::current_exception();
+                    }
+                });
+            }
+            try {
+                f(0u);
+            } catch (...) {
+                errors[0] = std::current_exception();
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            for (auto &error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+        // First pass: we count the values in each chunk to know where each chunk starts in the dataset
+        std::vector<std::size_t> first_value(n_chunks + 1u, 0u);
+        parallel_for([&](std::size_t t) {
+            trace_scope chunk_scope("count_csv_values", "io");
+            std::size_t count = 0u;
+            for_each_token(t, [&count](const char *, const char *) { ++count; });
+            first_value[t + 1u] = count;
+        });
+        for (std::size_t t = 0u; t < n_chunks; ++t) {
+            first_value[t + 1u] += first_value[t];
+        }
+        if (first_value[n_chunks] != n_values) {
+            throw std::invalid_argument("The file " + filename + " contains " + std::to_string(first_value[n_chunks])
+                                        + " values, " + std::to_string(n_values) + " were expected");
+        }
+
+        // Second pass: we parse, checking that each row is on its own line. The counts are validated,
+        // hence the memory allocated is bounded by the size of the file
+        dataset retval;
+        retval.allocate(header[0], header[1], N);
+        parallel_for([&](std::size_t t) {
+            trace_scope chunk_scope("parse_csv_values", "io");
+            auto idx = first_value[t];
+            for_each_token(t, [&](const char *token_first, const char *token_last) {
+                const auto column = idx % n_columns;
+                if (ends_line(token_last) != (column == n_columns - 1u)) {
+                    throw std::invalid_argument("The row " + std::to_string(idx / n_columns + 1u) + " of the file "
+                                                + filename + " does not contain " + std::to_string(n_columns)
+                                                + " values");
+                }
+                retval.column(static_cast<unsigned>(column))[idx / n_columns]
+                    = detail::parse_double(token_first, token_last);
+                ++idx;
+            });
+        });
+        return retval;
+    }
+
+    /// Loads a dataset in the dcgp binary format
+    /**
+     * Loads a dataset written by dcgp::dataset::save_binary(). The file is memory-mapped and nothing is
+     * parsed: double precision columns are used in place, so that the data are shared (through the
+     * page cache) with all the processes loading the same file. Single precision columns are converted
+     * to double precision.
+     *
+     * @param[in] filename the file name
+     *
+     * @return the dataset, which keeps the file mapped as long as it (or any copy) lives
+     *
+     * @throw std::runtime_error if the file cannot be read
+     * @throw std::invalid_argument if the file is not a valid dcgp binary dataset
+     */
+    static dataset load_binary(const std::string &filename)
+    {
+        auto file = std::make_shared<mapped_file>(filename);
+        const auto header = detail::read_dataset_header(file->data(), file->size(), filename);
+        const auto n_columns = static_cast<std::uint64_t>(header.n) + header.m;
+        const auto column_size = static_cast<std::size_t>(header.stride * header.value_size);
+        const char *columns = file->data() + detail::dataset_header_size;
+        dataset retval;
+        if (header.value_size == 8u) {
+            retval.m_n = header.n;
+            retval.m_m = header.m;
+            retval.m_N = static_cast<std::size_t>(header.N);
+            for (std::uint64_t c = 0u; c < n_columns; ++c) {
+                retval.m_columns.push_back(reinterpret_cast<const double *>(columns + c * column_size));
+            }
+            retval.m_storage = file;
+        } else {
+            retval.allocate(header.n, header.m, static_cast<std::size_t>(header.N));
+            for (auto c = 0u; c < n_columns; ++c) {
+                auto src = reinterpret_cast<const float *>(columns + c * column_size);
+                std::copy(src, src + retval.m_N, retval.column(c));
+            }
+        }
+        return retval;
+    }
+
+    /// Saves the dataset in the dcgp binary format
+    /**
+     * Writes the dataset in a columnar binary file that dcgp::dataset::load_binary() maps in memory with no
+     * parsing. Single precision halves the file size at the cost of rounding the data.
+     *
+     * @param[in] filename the file name
+     * @param[in] single_precision whether to store the values as float32 rather than float64
+     *
+     * @throw std::runtime_error if the file cannot be written
+     */
+    void save_binary(const std::string &filename, bool single_precision = false) const
+    {
+        const std::uint32_t value_size = single_precision ? 4u : 8u;
+        const std::uint64_t values_per_line = 64u / value_size;
+        detail::dataset_header header;
+        std::memcpy(header.magic, detail::dataset_magic, sizeof(header.magic));
+        header.byte_order = detail::dataset_byte_order;
+        header.version = detail::dataset_version;
+        header.n = m_n;
+        header.m = m_m;
+        header.N = m_N;
+        header.value_size = value_size;
+        header.reserved = 0u;
+        header.stride = (m_N + values_per_line - 1u) / values_per_line * values_per_line;
+
+        std::ofstream file(filename, std::ios::binary);
+        std::string buffer(detail::dataset_header_size, '\0');
+        std::memcpy(&buffer[0], &header, sizeof(header));
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.assign(static_cast<std::size_t>(header.stride * value_size), '\0');
+        for (auto column : m_columns) {
+            if (single_precision) {
+                for (std::size_t k = 0u; k < m_N; ++k) {
+                    const auto value = static_cast<float>(column[k]);
+                    std::memcpy(&buffer[k * sizeof(float)], &value, sizeof(float));
+                }
+            } else if (m_N) {
+                std::memcpy(&buffer[0], column, m_N * sizeof(double));
+            }
+            file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+        if (!file) {
+            throw std::runtime_error("Could not write the file " + filename);
+        }
+    }
+
+    /// Extracts some points
+    /**
+     * @param[in] indices the indices of the points to extract, in the order they will have in the new dataset
+     * (repetitions are allowed)
+     *
+     * @return a new dataset with the points \p indices
+     *
+     * @throw std::out_of_range if any index is not smaller than \p N
+     */
+    dataset subset(const std::vector<std::size_t> &indices) const
+    {
+        for (auto k : indices) {
+            if (k >= m_N) {
+                throw std::out_of_range("Point index out of range");
+            }
+        }
+        dataset retval;
+        retval.allocate(m_n, m_m, indices.size());
+        for (auto c = 0u; c < m_n + m_m; ++c) {
+            auto dest = retval.column(c);
+            for (decltype(indices.size()) k = 0u; k < indices.size(); ++k) {
+                dest[k] = m_columns[c][indices[k]];
+            }
+        }
+        return retval;
+    }
+
+    /// Gets the number of inputs
+    unsigned get_n() const
+    {
+        return m_n;
+    }
+
+    /// Gets the number of outputs
+    unsigned get_m() const
+    {
+        return m_m;
+    }
+
+    /// Gets the number of points
+    std::size_t size() const
+    {
+        return m_N;
+    }
+
+    /// Gets an input
+    /**
+     * @param[in] j the index of the input
+     *
+     * @return a pointer to the \p N values of the \p j -th input
+     *
+     * @throw std::out_of_range if \p j is not smaller than \p n
+     */
+    const double *get_input(unsigned j) const
+    {
+        if (j >= m_n) {
+            throw std::out_of_range("Input index out of range");
+        }
+        return m_columns[j];
+    }
+
+    /// Gets an output
+    /**
+     * @param[in] i the index of the output
+     *
+     * @return a pointer to the \p N values of the \p i -th output
+     *
+     * @throw std::out_of_range if \p i is not smaller than \p m
+     */
+    const double *get_output(unsigned i) const
+    {
+        if (i >= m_m) {
+            throw std::out_of_range("Output index out of range");
+        }
+        return m_columns[m_n + i];
+    }
+
+    /// Gets all inputs
+    /**
+     * @return an std::vector with the \p n pointers to the values of each input, as accepted by the batch
+     * evaluation of dcgp::expression
+     */
+    std::vector<const double *> get_inputs() const
+    {
+        return std::vector<const double *>(m_columns.begin(), m_columns.begin() + m_n);
+    }
+
+    /// Gets all outputs
+    /**
+     * @return an std::vector with the \p m pointers to the values of each output
+     */
+    std::vector<const double *> get_outputs() const
+    {
+        return std::vector<const double *>(m_columns.begin() + m_n, m_columns.end());
+    }
+
+private:
+    // Allocates zeroed columns, each aligned to 64 bytes
+    void allocate(unsigned n, unsigned m, std::size_t N)
+    {
+        m_n = n;
+        m_m = m;
+        m_N = N;
+        const std::size_t stride = (N + 7u) / 8u * 8u;
+        const std::size_t n_doubles = stride * (n + m);
+        std::shared_ptr<double> storage(new double[n_doubles + 8u](), std::default_delete<double[]>());
+        auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        double *aligned = storage.get() + ((64u - address % 64u) % 64u) / sizeof(double);
+        m_columns.clear();
+        for (auto c = 0u; c < n + m; ++c) {
+            m_columns.push_back(aligned + c * stride);
+        }
+        m_storage = storage;
+    }
+
+    double *column(unsigned c)
+    {
+        return const_cast<double *>(m_columns[c]);
+    }
+
+    // The chunks of a streamed dataset are datasets filled in place
+    friend class streamed_dataset;
+
+    unsigned m_n;
+    unsigned m_m;
+    std::size_t m_N;
+    // Owns the memory the columns point to
+    std::shared_ptr<const void> m_storage;
+    std::vector<const double *> m_columns;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_DATASET_H
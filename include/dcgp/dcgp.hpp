@@ -1,8 +1,20 @@
 #ifndef DCGP_H
 #define DCGP_H
 
+#include <dcgp/bounds.hpp>
+#include <dcgp/code_generator.hpp>
+#include <dcgp/dataset.hpp>
+#include <dcgp/differential_fitness.hpp>
+#include <dcgp/evolve.hpp>
+#include <dcgp/exact_kernels.hpp>
 #include <dcgp/expression.hpp>
 #include <dcgp/fitness_functions.hpp>
+#include <dcgp/graph.hpp>
+#include <dcgp/instrumentation.hpp>
 #include <dcgp/kernel_set.hpp>
+#include <dcgp/racing_fitness.hpp>
+#include <dcgp/serialization.hpp>
+#include <dcgp/streamed_dataset.hpp>
+#include <dcgp/trace.hpp>
 
 #endif // DCGP_H
@@ -0,0 +1,348 @@
+#ifndef DCGP_DIFFERENTIAL_FITNESS_H
+#define DCGP_DIFFERENTIAL_FITNESS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <audi/audi.hpp>
+
+#include <dcgp/expression.hpp>
+
+namespace dcgp
+{
+
+namespace detail
+{
+
+// The name of a symbol of a gdual, whether the symbol set holds strings or piranha symbols
+inline const std::string &symbol_name(const std::string &s)
+{
+    return s;
+}
+
+template <typename Symbol>
+auto symbol_name(const Symbol &s) -> decltype(s.get_name())
+{
+    return s.get_name();
+}
+
+} // namespace detail
+
+/// A derivative of an output of a dCGP expression
+struct derivative {
+    /// Index of the output
+    unsigned output;
+    /// Orders of the derivative, as in audi::gdual::get_derivative() (e.g. {{"dx", 1}}, empty for the value)
+    std::unordered_map<std::string, unsigned> orders;
+};
+
+/// Makes the inputs of a dCGP expression evaluating a grid of points at once
+/**
+ * Each input is a vectorized gdual holding the values of one variable in all the points, so that a
+ * dcgp::expression<gdual_v> computes its outputs and their derivatives in the whole grid with a single
+ * evaluation, instead of one evaluation per point with gdual_d.
+ *
+ * @param[in] grid the values of each variable in the \p N points (one std::vector per variable)
+ * @param[in] symbols the names of the variables (e.g. "x", the derivatives are then w.r.t. "dx")
+ * @param[in] order the highest order of the derivatives to be computed
+ *
+ * @return the inputs of the expression
+ *
+ * @throw std::invalid_argument if \p grid and \p symbols have different sizes, or if the variables do not
+ * have the same (non zero) number of points
+ */
+inline std::vector<gdual_v> grid_inputs(const std::vector<std::vector<double>> &grid,
+                                        const std::vector<std::string> &symbols, unsigned order)
+{
+    if (grid.size() != symbols.size()) {
+        throw std::invalid_argument("The grid has " + std::to_string(grid.size()) + " variables, but "
+                                    + std::to_string(symbols.size()) + " symbols were given");
+    }
+    if (grid.empty() || grid[0].empty()) {
+        throw std::invalid_argument("The grid has no points");
+    }
+    std::vector<gdual_v> retval;
+    for (decltype(grid.size()) i = 0u; i < grid.size(); ++i) {
+        if (grid[i].size() != grid[0].size()) {
+            throw std::invalid_argument("All the variables of the grid must have the same number of points");
+        }
+        retval.emplace_back(grid[i], symbols[i], order);
+    }
+    return retval;
+}
+
+/// Gets the values of a derivative of a vectorized gdual in all the points
+/**
+ * audi stores the coefficients that are the same in all the points (e.g. the derivatives of a linear
+ * expression) as a single value, which is then repeated \p N times.
+ *
+ * @param[in] g the vectorized gdual, e.g. an output of a dcgp::expression<gdual_v>
+ * @param[in] orders the orders of the derivative, as in audi::gdual::get_derivative() (e.g. {{"dx", 1}})
+ * @param[in] N the number of points
+ *
+ * @return the \p N values of the derivative
+ *
+ * @throw std::invalid_argument if the coefficient has neither 1 nor \p N values
+ */
+inline std::vector<double> derivative_values(const gdual_v &g, const std::unordered_map<std::string, unsigned> &orders,
+                                             std::size_t N)
+{
+    const auto cf = orders.empty() ? g.constant_cf() : g.get_derivative(orders);
+    if (cf.size() == 1u) {
+        return std::vector<double>(N, cf[0]);
+    }
+    if (cf.size() != N) {
+        throw std::invalid_argument("The derivative has " + std::to_string(cf.size()) + " values, expected "
+                                    + std::to_string(N));
+    }
+    std::vector<double> retval(N);
+    for (std::size_t k = 0u; k < N; ++k) {
+        retval[k] = cf[k];
+    }
+    return retval;
+}
+
+/// Derivatives of the outputs of dCGP expressions, extracted without symbol lookups
+/**
+ * audi::gdual::get_derivative() parses the names of the symbols and looks them up at every call, which
+ * dominates the fitness of the first integrals searches and ODE solvers evaluating gdual_d point by point.
+ * A derivative_index resolves the requested derivatives once against the symbols of the inputs, then
+ * extracts their values from the outputs of each evaluation by precomputed positions:
+ *
+ * @code
+ * dcgp::derivative_index idx({"p", "q"}, {{0u, {{"dp", 1u}}}, {0u, {{"dq", 1u}}}});
+ * std::vector<double> d(idx.size());
+ * for (const auto &point : in) {
+ *     idx(ex(point), d.data());
+ *     // d[0] and d[1] are the derivatives w.r.t. p and q in the point
+ * }
+ * @endcode
+ *
+ * The symbols of each output are checked once per call. The outputs not depending on some of the inputs
+ * lack their symbols: the positions are then mapped to the symbols the output has, without copying it, and
+ * the derivatives w.r.t. the missing symbols are zero. There is thus no need to add zero gduals to the outputs.
+ */
+class derivative_index
+{
+public:
+    /// Constructor
+    /**
+     * @param[in] symbols the names of the inputs of the expressions (e.g. "x", the derivatives are then
+     * w.r.t. "dx"), as passed to the gdual constructor
+     * @param[in] derivatives the derivatives to be extracted
+     *
+     * @throw std::invalid_argument if the symbols are repeated or if a derivative is w.r.t. an unknown symbol
+     */
+    derivative_index(const std::vector<std::string> &symbols, const std::vector<derivative> &derivatives)
+    {
+        for (const auto &symbol : symbols) {
+            m_symbols.push_back("d" + symbol);
+        }
+        // NOTE: audi sorts the symbols, the exponents of the monomials follow their order
+        std::sort(m_symbols.begin(), m_symbols.end());
+        if (std::adjacent_find(m_symbols.begin(), m_symbols.end()) != m_symbols.end()) {
+            throw std::invalid_argument("The symbols of a derivative index must be unique");
+        }
+        for (const auto &d : derivatives) {
+            std::vector<unsigned> exponents(m_symbols.size(), 0u);
+            double factor = 1.;
+            for (const auto &o : d.orders) {
+                const auto it = std::lower_bound(m_symbols.begin(), m_symbols.end(), o.first);
+                if (it == m_symbols.end() || *it != o.first) {
+                    throw std::invalid_argument("A derivative w.r.t. " + o.first
+                                                + " was requested, but the symbol is not in the index");
+                }
+                exponents[static_cast<std::size_t>(it - m_symbols.begin())] = o.second;
+                // The coefficients of the Taylor expansion are the derivatives divided by the factorials
+                for (auto k = 2u; k <= o.second; ++k) {
+                    factor *= k;
+                }
+            }
+            auto by_output = std::find_if(m_by_output.begin(), m_by_output.end(),
+                                          [&d](const std::pair<unsigned, std::vector<std::size_t>> &p) {
+                                              return p.first == d.output;
+                                          });
+            if (by_output == m_by_output.end()) {
+                m_by_output.emplace_back(d.output, std::vector<std::size_t>{});
+                by_output = m_by_output.end() - 1;
+            }
+            by_output->second.push_back(m_outputs.size());
+            m_outputs.push_back(d.output);
+            m_orders.push_back(std::accumulate(exponents.begin(), exponents.end(), 0u));
+            m_exponents.push_back(std::move(exponents));
+            m_factors.push_back(factor);
+        }
+    }
+
+    /// Number of derivatives
+    std::size_t size() const
+    {
+        return m_outputs.size();
+    }
+
+    /// Extracts the derivatives
+    /**
+     * @param[in] outputs the outputs of a dCGP expression, e.g. of a dcgp::expression<gdual_d> (or gdual_v)
+     * @param[out] out where the dcgp::derivative_index::size() derivatives are written, in the order
+     * they were given to the constructor
+     *
+     * @throw std::invalid_argument if a derivative refers to a missing output, or if the outputs have
+     * symbols that are not in the index
+     */
+    template <typename Cf>
+    void operator()(const std::vector<audi::gdual<Cf>> &outputs, Cf *out) const
+    {
+        // For an output lacking some symbols, the position in the index of each of its symbols
+        std::vector<std::size_t> positions;
+        std::vector<unsigned> exponents;
+        for (const auto &by_output : m_by_output) {
+            if (by_output.first >= outputs.size()) {
+                throw std::invalid_argument("The derivative of the output " + std::to_string(by_output.first)
+                                            + " was requested, but there are " + std::to_string(outputs.size())
+                                            + " outputs");
+            }
+            const auto &g = outputs[by_output.first];
+            const bool same_symbols = has_symbols(g);
+            if (!same_symbols) {
+                map_symbols(g, positions);
+            }
+            for (auto i : by_output.second) {
+                if (m_orders[i] == 0u) {
+                    out[i] = g.constant_cf();
+                    continue;
+                }
+                if (same_symbols) {
+                    out[i] = g.find_cf(m_exponents[i]);
+                } else {
+                    exponents.resize(positions.size());
+                    unsigned order = 0u;
+                    for (decltype(positions.size()) k = 0u; k < positions.size(); ++k) {
+                        exponents[k] = m_exponents[i][positions[k]];
+                        order += exponents[k];
+                    }
+                    // A derivative w.r.t. a symbol the output lacks is zero
+                    out[i] = (order == m_orders[i]) ? g.find_cf(exponents) : Cf(0.);
+                }
+                if (m_factors[i] != 1.) {
+                    out[i] *= m_factors[i];
+                }
+            }
+        }
+    }
+
+private:
+    // Whether the symbols of g are those of the index, so that the exponents can be used as they are
+    template <typename Cf>
+    bool has_symbols(const audi::gdual<Cf> &g) const
+    {
+        if (g.get_symbol_set_size() != m_symbols.size()) {
+            return false;
+        }
+        auto it = m_symbols.begin();
+        for (const auto &symbol : g.get_symbol_set()) {
+            if (detail::symbol_name(symbol) != *it++) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Writes in positions the position in the index of each symbol of g
+    template <typename Cf>
+    void map_symbols(const audi::gdual<Cf> &g, std::vector<std::size_t> &positions) const
+    {
+        positions.clear();
+        for (const auto &symbol : g.get_symbol_set()) {
+            const auto &name = detail::symbol_name(symbol);
+            const auto it = std::lower_bound(m_symbols.begin(), m_symbols.end(), name);
+            if (it == m_symbols.end() || *it != name) {
+                throw std::invalid_argument("The gduals have symbols that are not in the derivative index");
+            }
+            positions.push_back(static_cast<std::size_t>(it - m_symbols.begin()));
+        }
+    }
+
+    // The symbols, sorted as in audi (e.g. "dx")
+    std::vector<std::string> m_symbols;
+    // For each derivative, the output, the exponents of the monomial and the factor turning its coefficient
+    // into the derivative
+    std::vector<unsigned> m_outputs;
+    std::vector<std::vector<unsigned>> m_exponents;
+    std::vector<double> m_factors;
+    // The total order of each derivative (0 for the value)
+    std::vector<unsigned> m_orders;
+    // The derivatives of each output, so that the symbols of each output are checked once
+    std::vector<std::pair<unsigned, std::vector<std::size_t>>> m_by_output;
+};
+
+/// Computes the mean squared residual of a differential equation
+/**
+ * Evaluates \p ex once in all the points of \p in (see dcgp::grid_inputs()), extracts the values of the
+ * \p derivatives and computes the mean of the squared residuals. This is the fitness of the dCGP
+ * expressions solving differential equations (e.g. Tsoulos and Lagaris ODEs) or looking for first
+ * integrals, computed on the whole grid at once.
+ *
+ * As an example, the residual of \f$y' = (2x - y) / x\f$ on the points \p x is computed by:
+ * @code
+ * auto in = dcgp::grid_inputs({x}, {"x"}, 1u);
+ * auto err = dcgp::differential_error(ex, in, {{0u, {}}, {0u, {{"dx", 1u}}}},
+ *                                     [&x](std::size_t k, const std::vector<double> &d) {
+ *                                         return d[1] - (2. * x[k] - d[0]) / x[k];
+ *                                     });
+ * @endcode
+ *
+ * @param[in] ex the dCGP expression
+ * @param[in] in the inputs of the expression, as returned by dcgp::grid_inputs()
+ * @param[in] derivatives the derivatives the residual depends on
+ * @param[in] residual any callable with prototype double(std::size_t k, const std::vector<double> &d)
+ * returning the residual in the k-th point, where d[i] is the value there of the i-th derivative in
+ * \p derivatives
+ *
+ * @return the mean squared residual (not finite if some residual is not finite)
+ *
+ * @throw std::invalid_argument if \p in is empty or if a derivative refers to an output \p ex does not have
+ */
+template <typename Residual>
+double differential_error(const expression<gdual_v> &ex, const std::vector<gdual_v> &in,
+                          const std::vector<derivative> &derivatives, const Residual &residual)
+{
+    if (in.empty()) {
+        throw std::invalid_argument("The inputs of the expression are empty");
+    }
+    std::size_t N = 0u;
+    for (const auto &x : in) {
+        N = std::max(N, static_cast<std::size_t>(x.constant_cf().size()));
+    }
+    for (const auto &d : derivatives) {
+        if (d.output >= ex.get_m()) {
+            throw std::invalid_argument("The derivative of the output " + std::to_string(d.output)
+                                        + " was requested, but the expression has "
+                                        + std::to_string(ex.get_m()) + " outputs");
+        }
+    }
+    const auto out = ex(in);
+    std::vector<std::vector<double>> values;
+    for (const auto &d : derivatives) {
+        values.push_back(derivative_values(out[d.output], d.orders, N));
+    }
+    double retval = 0.;
+    std::vector<double> point(derivatives.size());
+    for (std::size_t k = 0u; k < N; ++k) {
+        for (decltype(values.size()) i = 0u; i < values.size(); ++i) {
+            point[i] = values[i][k];
+        }
+        const double err = residual(k, point);
+        retval += err * err;
+    }
+    return retval / static_cast<double>(N);
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_DIFFERENTIAL_FITNESS_H
@@ -0,0 +1,152 @@
+#ifndef DCGP_EVOLVE_H
+#define DCGP_EVOLVE_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <dcgp/dataset.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/trace.hpp>
+#include <dcgp/worker_pool.hpp>
+
+namespace dcgp
+{
+
+/// Options of dcgp::evolve()
+struct es_options {
+    /// Number of offspring per generation (the lambda of the (1 + lambda)-ES)
+    unsigned offspring = 4u;
+    /// Number of active genes mutated in each offspring
+    unsigned mutations = 2u;
+    /// Maximum number of generations
+    unsigned max_generations = 1000u;
+    /// The evolution stops as soon as the fitness is not larger than this
+    double target = 0.;
+    /// Number of threads evaluating the offspring (0 selects the number of hardware threads)
+    unsigned threads = 1u;
+};
+
+/// Result of dcgp::evolve()
+struct es_result {
+    /// Fitness of the expression evolved
+    double fitness;
+    /// Number of generations run
+    unsigned generations;
+};
+
+/// Evolves a dCGP expression with a (1 + lambda)-ES
+/**
+ * At each generation \p opts.offspring copies of the best expression found are mutated (see
+ * dcgp::expression::mutate_active()) and evaluated, in parallel on \p opts.threads threads, and the best
+ * of them replaces the parent if it is not worse (neutral mutations are accepted, as they let the
+ * inactive genes drift). The fitness of the offspring is computed with the fitness of the parent as
+ * cutoff: an offspring worse than the cutoff can be abandoned early (see dcgp::quadratic_error()).
+ *
+ * The offspring are mutated by the calling thread with the random engine of \p ex, and selected in
+ * order, so that the evolution is the same whatever the number of threads.
+ *
+ * @param[in,out] ex the expression to evolve (dcgp::expression<double>, dcgp::expression_weighted<double>, ...).
+ * On return it has the best chromosome found.
+ * @param[in] fitness a callable with prototype double(const Expr &ex, double cutoff) returning the fitness
+ * (to be minimized) of \p ex, or any value larger than \p cutoff if it is larger than \p cutoff. NaN fitnesses
+ * are never accepted. It is called concurrently on different expressions if \p opts.threads is not 1.
+ * @param[in] opts the options
+ * @param[in] callback a callable with prototype bool(unsigned generation, double fitness) called after each
+ * generation with the best fitness so far, from the calling thread. Returning false stops the evolution.
+ *
+ * @return the fitness of the expression evolved and the number of generations run
+ *
+ * @throw std::invalid_argument if \p opts.offspring is zero
+ */
+template <typename Expr, typename Fitness, typename Callback>
+es_result evolve(Expr &ex, const Fitness &fitness, const es_options &opts, const Callback &callback)
+{
+    if (opts.offspring == 0u) {
+        throw std::invalid_argument("At least one offspring per generation is needed");
+    }
+    detail::worker_pool pool(opts.threads);
+    std::vector<Expr> children(opts.offspring, ex);
+    std::vector<double> fits(opts.offspring);
+    auto best_chromosome = ex.get();
+    es_result retval{fitness(ex, std::numeric_limits<double>::infinity()), 0u};
+    // On errors (e.g. in the fitness) the expression is left with the best chromosome found
+    try {
+        while (!(retval.fitness <= opts.target) && retval.generations < opts.max_generations) {
+            ++retval.generations;
+            {
+                trace_scope scope("mutation", "es");
+                for (auto &child : children) {
+                    ex.set(best_chromosome);
+                    ex.mutate_active(opts.mutations);
+                    child.set(ex.get());
+                }
+            }
+            {
+                trace_scope scope("evaluation", "es");
+                const auto cutoff = retval.fitness;
+                pool.run(children.size(), [&children, &fits, &fitness, cutoff](std::size_t i) {
+                    fits[i] = fitness(children[i], cutoff);
+                });
+            }
+            {
+                trace_scope scope("selection", "es");
+                for (decltype(children.size()) i = 0u; i < children.size(); ++i) {
+                    // NOTE: a parent with a NaN fitness is replaced by any child
+                    if (fits[i] <= retval.fitness || (std::isnan(retval.fitness) && !std::isnan(fits[i]))) {
+                        retval.fitness = fits[i];
+                        best_chromosome = children[i].get();
+                    }
+                }
+            }
+            if (!callback(retval.generations, retval.fitness)) {
+                break;
+            }
+        }
+    } catch (...) {
+        ex.set(best_chromosome);
+        throw;
+    }
+    ex.set(best_chromosome);
+    return retval;
+}
+
+/// Evolves a dCGP expression with a (1 + lambda)-ES
+/**
+ * Same as dcgp::evolve(Expr &, const Fitness &, const es_options &, const Callback &), without a callback.
+ */
+template <typename Expr, typename Fitness>
+es_result evolve(Expr &ex, const Fitness &fitness, const es_options &opts)
+{
+    return evolve(ex, fitness, opts, [](unsigned, double) { return true; });
+}
+
+/// Evolves a dCGP expression to fit a dataset with a (1 + lambda)-ES
+/**
+ * Same as dcgp::evolve(Expr &, const Fitness &, const es_options &, const Callback &), with the quadratic
+ * error on \p data as fitness (see dcgp::quadratic_error(const Expr &, const dataset &, double)).
+ *
+ * @throw std::invalid_argument if the numbers of inputs or outputs of \p ex and \p data differ
+ */
+template <typename Expr, typename Callback>
+es_result evolve(Expr &ex, const dataset &data, const es_options &opts, const Callback &callback)
+{
+    return evolve(ex, [&data](const Expr &e, double cutoff) { return quadratic_error(e, data, cutoff); }, opts,
+                  callback);
+}
+
+/// Evolves a dCGP expression to fit a dataset with a (1 + lambda)-ES
+/**
+ * Same as dcgp::evolve(Expr &, const dataset &, const es_options &, const Callback &), without a callback.
+ */
+template <typename Expr>
+es_result evolve(Expr &ex, const dataset &data, const es_options &opts)
+{
+    return evolve(ex, data, opts, [](unsigned, double) { return true; });
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_EVOLVE_H
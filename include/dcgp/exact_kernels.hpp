@@ -0,0 +1,88 @@
+#ifndef DCGP_EXACT_KERNELS_H
+#define DCGP_EXACT_KERNELS_H
+
+#include <string>
+#include <vector>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/kernel.hpp>
+#include <dcgp/kernel_set.hpp>
+
+namespace dcgp
+{
+
+/// Replaces the fast approximate kernels with the exact ones
+/**
+ * The kernels "fast_sig" and "fast_exp" of dcgp::kernel_set are replaced by "sig" and "exp", which have
+ * the same arity and symbolic representation. The other kernels are kept (their instrumentation counters
+ * are then shared with \p f).
+ *
+ * @param[in] f the kernels
+ *
+ * @return the kernels, all exact
+ */
+template <typename T>
+std::vector<kernel<T>> exact_kernels(const std::vector<kernel<T>> &f)
+{
+    std::vector<kernel<T>> retval;
+    for (const auto &k : f) {
+        const auto &name = k.get_name();
+        if (name == "fast_sig" || name == "fast_exp") {
+            retval.push_back(kernel_set<T>({name.substr(5u)})[0]);
+        } else {
+            retval.push_back(k);
+        }
+    }
+    return retval;
+}
+
+/// Re-scores a dCGP expression with the exact kernels
+/**
+ * The fast approximate kernels (e.g. "fast_sig") are meant for the search, where a few ulps of error
+ * do not change which expressions are selected. The final candidates are then copied with the exact
+ * kernels (see dcgp::exact_kernels()) to compute their fitness, generate their code, etc.:
+ *
+ * @code
+ * dcgp::kernel_set<double> search_set({"sum", "diff", "mul", "div", "fast_sig"});
+ * dcgp::expression<double> ex(2, 1, 1, 20, 21, 2, search_set(), seed);
+ * // ... evolve ex ...
+ * auto err = dcgp::quadratic_error(dcgp::with_exact_kernels(ex), points, labels);
+ * @endcode
+ *
+ * @param[in] ex the dCGP expression
+ *
+ * @return a copy of \p ex (same chromosome and random engine) with the exact kernels
+ */
+template <typename T>
+expression<T> with_exact_kernels(const expression<T> &ex)
+{
+    expression<T> retval(ex.get_n(), ex.get_m(), ex.get_rows(), ex.get_cols(), ex.get_levels_back(),
+                         ex.get_arity(), exact_kernels(ex.get_f()), 0u);
+    retval.set(ex.get());
+    retval.set_random_engine(ex.get_random_engine());
+    return retval;
+}
+
+/// Re-scores a weighted dCGP expression with the exact kernels
+/**
+ * Same as the overload for dcgp::expression, the weights are also copied.
+ *
+ * @param[in] ex the weighted dCGP expression
+ *
+ * @return a copy of \p ex (same chromosome, weights and random engine) with the exact kernels
+ */
+template <typename T>
+expression_weighted<T> with_exact_kernels(const expression_weighted<T> &ex)
+{
+    expression_weighted<T> retval(ex.get_n(), ex.get_m(), ex.get_rows(), ex.get_cols(), ex.get_levels_back(),
+                                  ex.get_arity(), exact_kernels(ex.get_f()), 0u);
+    retval.set(ex.get());
+    retval.set_weights(ex.get_weights());
+    retval.set_random_engine(ex.get_random_engine());
+    return retval;
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_EXACT_KERNELS_H
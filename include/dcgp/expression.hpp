@@ -1,7 +1,12 @@
 #ifndef DCGP_EXPRESSION_H
 #define DCGP_EXPRESSION_H
 
+#include <algorithm>
 #include <audi/audi.hpp>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <initializer_list>
 #include <iostream>
 #include <map>
@@ -11,12 +16,34 @@
 #include <string>
 #include <vector>
 
+#include <dcgp/instrumentation.hpp>
+#include <dcgp/interval.hpp>
 #include <dcgp/kernel.hpp>
 #include <dcgp/type_traits.hpp>
 
 namespace dcgp
 {
 
+namespace detail
+{
+
+// Whether the n values in x are all finite. NOTE: a double is not finite if and only if all the bits of its
+// exponent are set. Unlike a loop on std::isfinite with an early exit, the test on the bits has no branches
+// and is vectorized by the compiler
+inline bool all_finite(const double *x, std::size_t n)
+{
+    const std::uint64_t exponent_mask = 0x7ff0000000000000ull;
+    std::uint64_t non_finite = 0u;
+    for (std::size_t k = 0u; k < n; ++k) {
+        std::uint64_t bits;
+        std::memcpy(&bits, x + k, sizeof(bits));
+        non_finite |= static_cast<std::uint64_t>((bits & exponent_mask) == exponent_mask);
+    }
+    return non_finite == 0u;
+}
+
+} // namespace detail
+
 /// A dCGP expression
 /**
  * This class represents a mathematical expression as encoded using CGP and
@@ -33,12 +60,14 @@ class expression
 
 private:
     // Static checks.
-    static_assert(std::is_same<T, double>::value || is_gdual<T>::value,
-                  "A d-CGP expression can only be operating on doubles or gduals");
+    static_assert(std::is_same<T, double>::value || is_gdual<T>::value || std::is_same<T, interval>::value,
+                  "A d-CGP expression can only be operating on doubles, gduals or intervals");
     // SFINAE dust
     template <typename U>
     using functor_enabler = typename std::enable_if<
-        std::is_same<U, double>::value || is_gdual<T>::value || std::is_same<U, std::string>::value, int>::type;
+        std::is_same<U, double>::value || is_gdual<T>::value || std::is_same<T, interval>::value
+            || std::is_same<U, std::string>::value,
+        int>::type;
 
 public:
     /// Constructor
@@ -74,6 +103,13 @@ public:
         if (l == 0) throw std::invalid_argument("Number of level-backs is 0");
         if (arity < 2) throw std::invalid_argument("Basis functions arity must be at least 2");
         if (f.size() == 0) throw std::invalid_argument("Number of basis functions is 0");
+        for (const auto &k : f) {
+            if (k.get_arity() > arity) {
+                throw std::invalid_argument("The kernel " + k.get_name() + " reads " + std::to_string(k.get_arity())
+                                            + " inputs, but the basis functions arity is " + std::to_string(arity));
+            }
+            m_kernel_arity.push_back(k.get_arity() == 0u ? arity : k.get_arity());
+        }
 
         // Bounds for the function genes
         for (auto i = 0u; i < ((arity + 1u) * m_r * m_c); i += (arity + 1u)) {
@@ -161,7 +197,8 @@ public:
     /// Gets the active genes
     /**
      * Gets the idx of the active genes in the current chromosome (numbering is
-     * from 0)
+     * from 0). The connection genes of the inputs a kernel does not read (see
+     * dcgp::kernel::get_arity()) are not active.
      *
      * @return An std::vector containing the idx of the active genes in the
      * current chromosome
@@ -175,7 +212,8 @@ public:
     /**
      * Gets the idx of the active nodes in the current chromosome.
      * The numbering starts from 0 at the first input node to then follow PPSN
-     * tutorial from Miller
+     * tutorial from Miller. The nodes only connected to inputs their kernels do not
+     * read (see dcgp::kernel::get_arity()) are not active.
      *
      * @return An std::vector containing the idx of the active nodes
      */
@@ -184,6 +222,27 @@ public:
         return m_active_nodes;
     }
 
+    /// Gets the instrumentation counters
+    /**
+     * Gets the number of points where the expression was evaluated (symbolic evaluations excluded), the number
+     * of genes mutated and the number and sizes of the updates of the active nodes. The counters are shared by
+     * the copies of the expression, so that the counts of e.g. the offspring of an evolutionary strategy add up
+     * in the expression they were copied from. They are only updated if the instrumentation is compiled in
+     * (see dcgp::instrumentation_enabled()). The counters of the kernels are in dcgp::kernel::get_counters().
+     *
+     * @return the counters
+     */
+    expression_counters get_counters() const
+    {
+        return m_counters.get();
+    }
+
+    /// Resets the instrumentation counters (those of the kernels excluded)
+    void reset_counters() const
+    {
+        m_counters.reset();
+    }
+
     /// Gets the number of inputs
     /**
      * Gets the number of inputs of the dCGP expression
@@ -250,6 +309,21 @@ public:
         return m_arity;
     }
 
+    /// Gets the arity of a node
+    /**
+     * Gets the number of inputs of a function node read by its current kernel: the first
+     * ones, up to the arity of the basis functions (see dcgp::kernel::get_arity())
+     *
+     * @param[in] node_id the id of a function node (at least the number of inputs)
+     *
+     * @return the arity of the node
+     */
+    unsigned get_node_arity(unsigned node_id) const
+    {
+        assert(node_id >= m_n && node_id < m_n + m_r * m_c);
+        return m_kernel_arity[m_x[(node_id - m_n) * (m_arity + 1u)]];
+    }
+
     /// Gets the function set
     /**
      * Gets the set of functions used in the dCGP expression
@@ -261,6 +335,30 @@ public:
         return m_f;
     }
 
+    /// Gets the random engine
+    /**
+     * Gets the random engine used for the mutations, e.g. to store its state with the expression
+     * (see dcgp::to_archive())
+     *
+     * @return the random engine
+     */
+    const std::default_random_engine &get_random_engine() const
+    {
+        return m_e;
+    }
+
+    /// Sets the random engine
+    /**
+     * Sets the random engine used for the mutations: the mutations that follow are those the expression
+     * whose engine is \p e would make
+     *
+     * @param[in] e the random engine
+     */
+    void set_random_engine(const std::default_random_engine &e)
+    {
+        m_e = e;
+    }
+
     /// Mutates one gene
     /**
      * Mutates exactly one gene within its allowed bounds.
@@ -282,6 +380,7 @@ public:
                 new_value = std::uniform_int_distribution<unsigned>(m_lb[idx], m_ub[idx])(m_e);
             } while (new_value == m_x[idx]);
             m_x[idx] = new_value;
+            m_counters.add_mutations(1u);
             update_active();
         }
     }
@@ -309,6 +408,7 @@ public:
                     new_value = std::uniform_int_distribution<unsigned>(m_lb[idxs[i]], m_ub[idxs[i]])(m_e);
                 } while (new_value == m_x[idxs[i]]);
                 m_x[idxs[i]] = new_value;
+                m_counters.add_mutations(1u);
                 flag = true;
             }
         }
@@ -335,6 +435,7 @@ public:
                     new_value = std::uniform_int_distribution<unsigned>(m_lb[idx], m_ub[idx])(m_e);
                 } while (new_value == m_x[idx]);
                 m_x[idx] = new_value;
+                m_counters.add_mutations(1u);
                 flag = true;
             }
         }
@@ -344,7 +445,10 @@ public:
     /// Mutates one of the active genes
     /**
      * Mutates \p N active genes within their allowed bounds.
-     * The mutation can affect function genes, input genes and output genes.
+     * The mutation can affect function genes, input genes and output genes. The connection
+     * genes of the inputs a kernel does not read (see dcgp::kernel::get_arity()) are not active,
+     * hence never mutated here: with unary kernels such as "sin" there is less neutral drift
+     * than when all the connection genes are active.
      *
      * @param[in] N Number of active genes to be mutated
      *
@@ -377,7 +481,7 @@ public:
     /// Mutates one of the active connection genes
     /**
      * Mutates exactly one of the active connection genes within its allowed
-     * bounds.
+     * bounds, among those of the inputs the kernels read (see dcgp::kernel::get_arity()).
      */
     void mutate_active_cgene()
     {
@@ -385,8 +489,8 @@ public:
         if (m_active_genes.size() > m_m) {
             unsigned idx = std::uniform_int_distribution<unsigned>(
                 0u, static_cast<unsigned>(m_active_genes.size() - 1u - m_m))(m_e);
-            idx = m_active_genes[idx] - (m_active_genes[idx] % (m_arity + 1))
-                  + std::uniform_int_distribution<unsigned>(1, m_arity)(m_e);
+            idx = m_active_genes[idx] - (m_active_genes[idx] % (m_arity + 1));
+            idx += std::uniform_int_distribution<unsigned>(1, m_kernel_arity[m_x[idx]])(m_e);
             mutate(idx);
         }
     }
@@ -427,18 +531,24 @@ public:
         if (in.size() != m_n) {
             throw std::invalid_argument("Input size is incompatible");
         }
+        count_evaluations<U>(1u);
         std::vector<U> retval(m_m);
         std::map<unsigned, U> node;
-        std::vector<U> function_in(m_arity);
+        // The kernel inputs, function_in[a] for the nodes of arity a
+        std::vector<std::vector<U>> function_in;
+        for (auto a = 0u; a <= m_arity; ++a) {
+            function_in.emplace_back(a);
+        }
         for (auto i : m_active_nodes) {
             if (i < m_n) {
                 node[i] = in[i];
             } else {
                 unsigned idx = (i - m_n) * (m_arity + 1); // position in the chromosome of the current node
-                for (auto j = 0u; j < m_arity; ++j) {
-                    function_in[j] = node[m_x[idx + j + 1]];
+                auto &f_in = function_in[m_kernel_arity[m_x[idx]]];
+                for (decltype(f_in.size()) j = 0u; j < f_in.size(); ++j) {
+                    f_in[j] = node[m_x[idx + j + 1]];
                 }
-                node[i] = m_f[m_x[idx]](function_in);
+                node[i] = m_f[m_x[idx]](f_in);
             }
         }
         for (auto i = 0u; i < m_m; ++i) {
@@ -467,6 +577,53 @@ public:
         return (*this)(dummy);
     }
 
+    /// Evaluates the dCGP expression on a batch of points
+    /**
+     * This evaluates the dCGP expression in \p N points at once. The active nodes are
+     * computed one after the other on blocks of points, so that the kernels dispatch
+     * is paid once per block rather than once per point, and the kernels' batch
+     * implementations can be vectorized.
+     *
+     * @param[in] in the \p n pointers to the \p N values of each input
+     * @param[in] out the \p m pointers where the \p N values of each output are written
+     * @param[in] N the number of points
+     *
+     * @throw std::invalid_argument if the sizes of \p in or \p out are incompatible
+     */
+    void operator()(const std::vector<const T *> &in, const std::vector<T *> &out, std::size_t N) const
+    {
+        unsigned node_id;
+        evaluate_batch(in, out, N, kernel_node_call, [](const T *, std::size_t) { return true; }, node_id);
+    }
+
+    /// Evaluates the dCGP expression on a batch of points, stopping at the first non finite value
+    /**
+     * Same as the batch evaluation, but the values computed by each active node (the inputs included)
+     * are checked block by block. As soon as one of them is not finite (NaN or infinity) the evaluation
+     * is abandoned and the id of the node is reported: evolved expressions often contain divisions,
+     * logarithms or exponentials blowing up on part of the data, and their outputs would be useless anyway.
+     *
+     * The nodes of each block are checked in the order they are computed, so the node reported is
+     * the first one producing a non finite value in the first block where one appears.
+     *
+     * @param[in] in the \p n pointers to the \p N values of each input
+     * @param[in] out the \p m pointers where the \p N values of each output are written
+     * @param[in] N the number of points
+     * @param[out] node_id the id of the node that produced a non finite value. Left unchanged if all values are
+     * finite.
+     *
+     * @return true if all the values were finite, false if the evaluation was abandoned, in which case the
+     * content of \p out is unspecified
+     *
+     * @throw std::invalid_argument if the sizes of \p in or \p out are incompatible
+     */
+    template <typename U = T, typename std::enable_if<std::is_same<U, double>::value, int>::type = 0>
+    bool evaluate_checked(const std::vector<const T *> &in, const std::vector<T *> &out, std::size_t N,
+                          unsigned &node_id) const
+    {
+        return evaluate_batch(in, out, N, kernel_node_call, detail::all_finite, node_id);
+    }
+
     /// Overloaded stream operator
     /**
      * Will return a formatted string containing a human readable representation
@@ -517,6 +674,84 @@ protected:
         return true;
     }
 
+    // Evaluates the expression on a batch of points, block by block. The actual evaluation of a node
+    // is left to node_call(kernel, inputs, node_id, output, number of points) so that derived classes
+    // can alter the kernel inputs (e.g. with weights). The values of each active node in a block are then
+    // passed to node_check(values, number of points): if it returns false the evaluation stops, node_id
+    // is set to the node and false is returned
+    template <typename F, typename G>
+    bool evaluate_batch(const std::vector<const T *> &in, const std::vector<T *> &out, std::size_t N,
+                        const F &node_call, const G &node_check, unsigned &node_id) const
+    {
+        if (in.size() != m_n || out.size() != m_m) {
+            throw std::invalid_argument("Input or output size is incompatible");
+        }
+        m_counters.add_evaluations(N);
+        const std::size_t block = std::min(N, batch_block_size);
+        std::vector<unsigned> function_nodes;
+        for (auto i : m_active_nodes) {
+            if (i >= m_n) {
+                function_nodes.push_back(i);
+            }
+        }
+        // One buffer per active function node, node_values[i] points to the values of node i
+        std::vector<T> buffers(function_nodes.size() * block);
+        std::vector<const T *> node_values(m_n + m_r * m_c, nullptr);
+        // The kernel inputs, function_in[a] for the nodes of arity a
+        std::vector<std::vector<const T *>> function_in;
+        for (auto a = 0u; a <= m_arity; ++a) {
+            function_in.emplace_back(a);
+        }
+        for (std::size_t start = 0u; start < N; start += block) {
+            const auto n_points = std::min(block, N - start);
+            for (auto i : m_active_nodes) {
+                if (i < m_n) {
+                    node_values[i] = in[i] + start;
+                    if (!node_check(node_values[i], n_points)) {
+                        node_id = i;
+                        return false;
+                    }
+                }
+            }
+            for (decltype(function_nodes.size()) k = 0u; k < function_nodes.size(); ++k) {
+                const auto i = function_nodes[k];
+                unsigned idx = (i - m_n) * (m_arity + 1); // position in the chromosome of the current node
+                auto &f_in = function_in[m_kernel_arity[m_x[idx]]];
+                for (decltype(f_in.size()) j = 0u; j < f_in.size(); ++j) {
+                    f_in[j] = node_values[m_x[idx + j + 1]];
+                }
+                T *node_out = buffers.data() + k * block;
+                node_call(m_f[m_x[idx]], f_in, i, node_out, n_points);
+                if (!node_check(node_out, n_points)) {
+                    node_id = i;
+                    return false;
+                }
+                node_values[i] = node_out;
+            }
+            for (auto i = 0u; i < m_m; ++i) {
+                const auto src = node_values[m_x[(m_r * m_c) * (m_arity + 1) + i]];
+                std::copy(src, src + n_points, out[i] + start);
+            }
+        }
+        return true;
+    }
+
+    // Evaluates a node of a batch calling its kernel on the inputs
+    static void kernel_node_call(const kernel<T> &f, const std::vector<const T *> &function_in, unsigned, T *node_out,
+                                 std::size_t n)
+    {
+        f(function_in, node_out, n);
+    }
+
+    // Counts evaluations of the expression in the instrumentation counters, unless they are symbolic
+    template <typename U>
+    void count_evaluations(std::size_t n) const
+    {
+        if (!std::is_same<U, std::string>::value) {
+            m_counters.add_evaluations(n);
+        }
+    }
+
     // Updates the list of active nodes
     void update_active()
     {
@@ -536,8 +771,9 @@ protected:
                 if (node_id >= m_n) // we insert the input nodes connections as they do
                                     // not have any
                 {
-                    for (auto i = 1u; i <= m_arity; ++i) {
-                        next.push_back(m_x[(node_id - m_n) * (m_arity + 1) + i]);
+                    const auto idx = (node_id - m_n) * (m_arity + 1);
+                    for (auto i = 1u; i <= m_kernel_arity[m_x[idx]]; ++i) {
+                        next.push_back(m_x[idx + i]);
                     }
                 } else {
                     m_active_nodes.push_back(node_id);
@@ -560,7 +796,7 @@ protected:
         for (auto i = 0u; i < m_active_nodes.size(); ++i) {
             if (m_active_nodes[i] >= m_n) {
                 unsigned idx = (m_active_nodes[i] - m_n) * (m_arity + 1);
-                for (auto j = 0u; j <= m_arity; ++j) {
+                for (auto j = 0u; j <= m_kernel_arity[m_x[idx]]; ++j) {
                     m_active_genes.push_back(idx + j);
                 }
             }
@@ -568,6 +804,7 @@ protected:
         for (auto i = 0u; i < m_m; ++i) {
             m_active_genes.push_back(m_r * m_c * (m_arity + 1) + i);
         }
+        m_counters.add_update_active(m_active_nodes.size());
     }
 
 private:
@@ -586,6 +823,8 @@ private:
 
     // the functions allowed
     std::vector<kernel<T>> m_f;
+    // the number of inputs each function reads (the arity for the kernels reading all of them)
+    std::vector<unsigned> m_kernel_arity;
     // lower and upper bounds on all genes
     std::vector<unsigned> m_lb;
     std::vector<unsigned> m_ub;
@@ -597,10 +836,17 @@ private:
     std::vector<unsigned> m_x;
     // the random engine for the class
     std::default_random_engine m_e;
+    // the instrumentation counters (empty unless DCGP_INSTRUMENTATION is defined)
+    detail::expression_instrumentation m_counters;
     // The expression type
     using type = T;
+    // The number of points evaluated together by the batch evaluation (a few KB per node)
+    static constexpr std::size_t batch_block_size = 512u;
 };
 
+template <typename T>
+constexpr std::size_t expression<T>::batch_block_size;
+
 } // end of namespace dcgp
 
 #endif // DCGP_EXPRESSION_H
@@ -2,6 +2,7 @@
 #define DCGP_EXPRESSION_WEIGHTED_H
 
 #include <audi/audi.hpp>
+#include <cstddef>
 #include <initializer_list>
 #include <iostream>
 #include <map>
@@ -12,6 +13,7 @@
 #include <vector>
 
 #include <dcgp/expression.hpp>
+#include <dcgp/interval.hpp>
 #include <dcgp/kernel.hpp>
 #include <dcgp/type_traits.hpp>
 
@@ -37,7 +39,9 @@ private:
     // SFINAE dust
     template <typename U>
     using functor_enabler = typename std::enable_if<
-        std::is_same<U, double>::value || is_gdual<T>::value || std::is_same<U, std::string>::value, int>::type;
+        std::is_same<U, double>::value || is_gdual<T>::value || std::is_same<T, interval>::value
+            || std::is_same<U, std::string>::value,
+        int>::type;
 
 public:
     /// Constructor
@@ -88,9 +92,14 @@ public:
         if (in.size() != this->get_n()) {
             throw std::invalid_argument("Input size is incompatible");
         }
+        this->template count_evaluations<U>(1u);
         std::vector<U> retval(this->get_m());
         std::map<unsigned int, U> node;
-        std::vector<U> function_in(this->get_arity());
+        // The kernel inputs, function_in[a] for the nodes of arity a
+        std::vector<std::vector<U>> function_in;
+        for (auto a = 0u; a <= this->get_arity(); ++a) {
+            function_in.emplace_back(a);
+        }
         for (auto i : this->get_active_nodes()) {
             if (i < this->get_n()) {
                 node[i] = in[i];
@@ -98,10 +107,11 @@ public:
                 unsigned int idx
                     = (i - this->get_n()) * (this->get_arity() + 1); // position in the chromosome of the current node
                 unsigned int weight_idx = (i - this->get_n()) * this->get_arity();
-                for (auto j = 0u; j < this->get_arity(); ++j) {
-                    function_in[j] = node[this->get()[idx + j + 1]];
+                auto &f_in = function_in[this->get_node_arity(i)];
+                for (decltype(f_in.size()) j = 0u; j < f_in.size(); ++j) {
+                    f_in[j] = node[this->get()[idx + j + 1]];
                 }
-                node[i] = kernel_call(function_in, idx, weight_idx);
+                node[i] = kernel_call(f_in, idx, weight_idx);
             }
         }
         for (auto i = 0u; i < this->get_m(); ++i) {
@@ -130,6 +140,43 @@ public:
         return (*this)(dummy);
     }
 
+    /// Evaluates the dCGP expression on a batch of points
+    /**
+     * This evaluates the dCGP expression in \p N points at once, see dcgp::expression
+     *
+     * @param[in] in the \p n pointers to the \p N values of each input
+     * @param[in] out the \p m pointers where the \p N values of each output are written
+     * @param[in] N the number of points
+     *
+     * @throw std::invalid_argument if the sizes of \p in or \p out are incompatible
+     */
+    void operator()(const std::vector<const T *> &in, const std::vector<T *> &out, std::size_t N) const
+    {
+        unsigned node_id;
+        evaluate_weighted(in, out, N, [](const T *, std::size_t) { return true; }, node_id);
+    }
+
+    /// Evaluates the dCGP expression on a batch of points, stopping at the first non finite value
+    /**
+     * See dcgp::expression::evaluate_checked()
+     *
+     * @param[in] in the \p n pointers to the \p N values of each input
+     * @param[in] out the \p m pointers where the \p N values of each output are written
+     * @param[in] N the number of points
+     * @param[out] node_id the id of the node that produced a non finite value. Left unchanged if all values are
+     * finite.
+     *
+     * @return true if all the values were finite, false if the evaluation was abandoned
+     *
+     * @throw std::invalid_argument if the sizes of \p in or \p out are incompatible
+     */
+    template <typename U = T, typename std::enable_if<std::is_same<U, double>::value, int>::type = 0>
+    bool evaluate_checked(const std::vector<const T *> &in, const std::vector<T *> &out, std::size_t N,
+                          unsigned &node_id) const
+    {
+        return evaluate_weighted(in, out, N, detail::all_finite, node_id);
+    }
+
     /// Overloaded stream operator
     /**
      * Will return a formatted string containing a human readable representation
@@ -232,11 +279,37 @@ public:
     }
 
 protected:
+    // Batch evaluation with the weights applied to the kernel inputs
+    template <typename G>
+    bool evaluate_weighted(const std::vector<const T *> &in, const std::vector<T *> &out, std::size_t N,
+                           const G &node_check, unsigned &node_id) const
+    {
+        std::vector<std::vector<T>> weighted_in(this->get_arity());
+        std::vector<const T *> function_in(this->get_arity());
+        auto node_call = [this, &weighted_in, &function_in](const kernel<T> &f, const std::vector<const T *> &node_in,
+                                                            unsigned node, T *node_out, std::size_t n) {
+            unsigned int weight_idx = (node - this->get_n()) * this->get_arity();
+            function_in.resize(node_in.size());
+            for (decltype(node_in.size()) j = 0u; j < node_in.size(); ++j) {
+                weighted_in[j].resize(n);
+                for (std::size_t k = 0u; k < n; ++k) {
+                    weighted_in[j][k] = node_in[j][k] * m_weights[weight_idx + j];
+                }
+                function_in[j] = weighted_in[j].data();
+            }
+            f(function_in, node_out, n);
+        };
+        return this->evaluate_batch(in, out, N, node_call, node_check, node_id);
+    }
+
     // For numeric computations
-    template <typename U, typename std::enable_if<std::is_same<U, double>::value || is_gdual<U>::value, int>::type = 0>
+    template <typename U, typename std::enable_if<
+                              std::is_same<U, double>::value || is_gdual<U>::value || std::is_same<U, interval>::value,
+                              int>::type
+                          = 0>
     U kernel_call(std::vector<U> &function_in, unsigned int idx, unsigned int weight_idx) const
     {
-        for (auto j = 0u; j < this->get_arity(); ++j) {
+        for (decltype(function_in.size()) j = 0u; j < function_in.size(); ++j) {
             function_in[j] = function_in[j] * m_weights[weight_idx + j];
         }
         return this->get_f()[this->get()[idx]](function_in);
@@ -246,7 +319,7 @@ protected:
     template <typename U, typename std::enable_if<std::is_same<U, std::string>::value, int>::type = 0>
     U kernel_call(std::vector<U> &function_in, unsigned int idx, unsigned int weight_idx) const
     {
-        for (auto j = 0u; j < this->get_arity(); ++j) {
+        for (decltype(function_in.size()) j = 0u; j < function_in.size(); ++j) {
             function_in[j] = "(" + m_weights_symbols[weight_idx + j] + "*" + function_in[j] + ")";
         }
         return this->get_f()[this->get()[idx]](function_in);
@@ -1,16 +1,48 @@
 #ifndef DCGP_FITNESS_FUNCTIONS_H
 #define DCGP_FITNESS_FUNCTIONS_H
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
 #include <vector>
 
 #include <audi/functions.hpp>
 
+#include <dcgp/dataset.hpp>
 #include <dcgp/expression.hpp>
+#include <dcgp/streamed_dataset.hpp>
+#include <dcgp/trace.hpp>
+#include <dcgp/worker_pool.hpp>
 
 namespace dcgp
 {
 
+namespace detail
+{
+
+// Evaluates ex on a batch of points, returns false if a non finite value appeared. dCGP expressions
+// stop at the first non finite node (see dcgp::expression::evaluate_checked())...
+template <typename Expr>
+auto evaluate_finite(const Expr &ex, const std::vector<const double *> &in, const std::vector<double *> &out,
+                     std::size_t N, int) -> decltype(ex.evaluate_checked(in, out, N, std::declval<unsigned &>()))
+{
+    unsigned node_id;
+    return ex.evaluate_checked(in, out, N, node_id);
+}
+
+// ... other evaluators (e.g. dcgp::compiled_expression) are checked on their outputs
+template <typename Expr>
+bool evaluate_finite(const Expr &ex, const std::vector<const double *> &in, const std::vector<double *> &out,
+                     std::size_t N, long)
+{
+    ex(in, out, N);
+    return std::all_of(out.begin(), out.end(), [N](const double *o) { return all_finite(o, N); });
+}
+
+} // namespace detail
+
 /// Computes the quadratic error of a dCGP expression in approximating given data
 template <typename T1, typename T2, typename T3>
 T1 quadratic_error(const expression<T3> &ex, const std::vector<std::vector<T1>> &in_des,
@@ -34,6 +66,166 @@ T1 quadratic_error(const expression<T3> &ex, const std::vector<std::vector<T1>>
     return retval / static_cast<int>(out_des.size());
 }
 
+/// Computes the quadratic error of a dCGP expression in approximating given data, giving up above a cutoff
+/**
+ * Same as dcgp::quadratic_error(), but the sum of the squared errors is abandoned as soon as it
+ * exceeds \p cutoff times the number of points: from then on the result is certainly worse than \p cutoff.
+ * In a (1 + lambda)-ES, with the parent fitness as cutoff, most of the offspring are discarded after
+ * a few points.
+ *
+ * @param[in] ex the dCGP expression
+ * @param[in] in_des the input points
+ * @param[in] out_des the desired outputs
+ * @param[in] cutoff the cutoff
+ *
+ * @return the quadratic error, or infinity if it is larger than \p cutoff
+ *
+ * @throw std::invalid_argument if the sizes of \p in_des and \p out_des differ
+ */
+template <typename T>
+double quadratic_error(const expression<T> &ex, const std::vector<std::vector<double>> &in_des,
+                       const std::vector<std::vector<double>> &out_des, double cutoff)
+{
+    if (in_des.size() != out_des.size()) {
+        throw std::invalid_argument("Size of the input vector must be the size of the output vector");
+    }
+    trace_scope scope("quadratic_error", "fitness");
+    double retval(0.);
+    std::vector<double> out_real;
+    for (auto i = 0u; i < in_des.size(); ++i) {
+        out_real = ex(in_des[i]);
+        for (auto j = 0u; j < out_real.size(); ++j) {
+            retval += (out_des[i][j] - out_real[j]) * (out_des[i][j] - out_real[j]);
+        }
+        // NOTE: comparing retval / N rather than retval with cutoff * N keeps a value equal to the
+        // cutoff (e.g. a neutral mutation in an ES) from being cut by a rounding error
+        if (retval / static_cast<double>(out_des.size()) > cutoff) {
+            return std::numeric_limits<double>::infinity();
+        }
+    }
+    return retval / static_cast<double>(out_des.size());
+}
+
+/// Computes the quadratic error of a dCGP expression in approximating a dataset
+/**
+ * The expression is evaluated in batches of points (see the batch evaluation of dcgp::expression)
+ * directly on the columns of \p data. If a \p cutoff is given, the evaluation stops as soon as the
+ * partial sum of the squared errors exceeds \p cutoff times the number of points.
+ *
+ * The evaluation also stops as soon as a node of the expression produces a non finite value
+ * (see dcgp::expression::evaluate_checked()), and NaN is returned: the error of such an expression is
+ * not a number worth computing. Use dcgp::expression::evaluate_checked() to find the node responsible.
+ *
+ * @param[in] ex a dcgp::expression<double>, a dcgp::expression_weighted<double> or a dcgp::compiled_expression
+ * @param[in] data the dataset
+ * @param[in] cutoff the cutoff
+ *
+ * @return the quadratic error (the sum over the outputs of the mean squared errors), infinity if it is
+ * larger than \p cutoff or NaN if the expression is not finite on some point
+ *
+ * @throw std::invalid_argument if the numbers of inputs or outputs of \p ex and \p data differ
+ */
+template <typename Expr>
+double quadratic_error(const Expr &ex, const dataset &data, double cutoff = std::numeric_limits<double>::infinity())
+{
+    if (ex.get_n() != data.get_n() || ex.get_m() != data.get_m()) {
+        throw std::invalid_argument("The dataset and the expression have a different number of inputs or outputs");
+    }
+    trace_scope scope("quadratic_error", "fitness");
+    const std::size_t block = 4096u;
+    const auto N = data.size();
+    std::vector<std::vector<double>> out_real(data.get_m(), std::vector<double>(std::min(block, N)));
+    std::vector<const double *> in(data.get_n());
+    std::vector<double *> out(data.get_m());
+    for (auto i = 0u; i < data.get_m(); ++i) {
+        out[i] = out_real[i].data();
+    }
+    double retval(0.);
+    // With a cutoff the first blocks are small, as most bad expressions exceed it within a few points
+    std::size_t step = std::isinf(cutoff) ? block : 64u;
+    for (std::size_t start = 0u; start < N; start += step, step = std::min(2u * step, block)) {
+        const auto n_points = std::min(step, N - start);
+        for (auto j = 0u; j < data.get_n(); ++j) {
+            in[j] = data.get_input(j) + start;
+        }
+        if (!detail::evaluate_finite(ex, in, out, n_points, 0)) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        for (auto i = 0u; i < data.get_m(); ++i) {
+            const double *out_des = data.get_output(i) + start;
+            for (std::size_t k = 0u; k < n_points; ++k) {
+                retval += (out_des[k] - out[i][k]) * (out_des[k] - out[i][k]);
+            }
+        }
+        if (retval / static_cast<double>(N) > cutoff) {
+            return std::numeric_limits<double>::infinity();
+        }
+    }
+    return retval / static_cast<double>(N);
+}
+
+/// Computes the quadratic errors of many dCGP expressions in parallel
+/**
+ * Same as dcgp::quadratic_error(const Expr &, const dataset &, double) on each expression, with the
+ * expressions distributed among \p n_threads threads. The threads are started at the first call and
+ * kept waiting between the calls, so that this can be called once per generation of an evolutionary
+ * strategy. Calls from different threads are serialized.
+ *
+ * @param[in] exs the expressions (e.g. the offspring of an evolutionary strategy)
+ * @param[in] data the dataset
+ * @param[in] cutoff the cutoff
+ * @param[in] n_threads the number of threads (0 selects the number of hardware threads)
+ *
+ * @return the quadratic error of each expression
+ *
+ * @throw std::invalid_argument if the numbers of inputs or outputs of an expression and \p data differ
+ */
+template <typename Expr>
+std::vector<double> quadratic_error(const std::vector<Expr> &exs, const dataset &data, double cutoff,
+                                    unsigned n_threads)
+{
+    std::vector<double> retval(exs.size());
+    auto f = [&exs, &data, cutoff, &retval](std::size_t i) { retval[i] = quadratic_error(exs[i], data, cutoff); };
+    if (n_threads == 1u || exs.size() < 2u) {
+        for (decltype(exs.size()) i = 0u; i < exs.size(); ++i) {
+            f(i);
+        }
+    } else {
+        detail::run_on_shared_pool(n_threads, exs.size(), f);
+    }
+    return retval;
+}
+
+/// Computes the quadratic error of a dCGP expression in approximating a dataset streamed from disk
+/**
+ * The dataset is read chunk by chunk (see dcgp::streamed_dataset) and the error accumulated, so that
+ * the memory used is bounded by the chunk size and not by the dataset size. Once the expression
+ * produced a non finite value, the remaining chunks are neither read nor evaluated.
+ *
+ * @param[in] ex a dcgp::expression<double>, a dcgp::expression_weighted<double> or a dcgp::compiled_expression
+ * @param[in] data the streamed dataset
+ *
+ * @return the quadratic error (the sum over the outputs of the mean squared errors), or NaN if the expression
+ * is not finite on some point
+ *
+ * @throw std::invalid_argument if the numbers of inputs or outputs of \p ex and \p data differ
+ * @throw std::runtime_error if the dataset cannot be read
+ */
+template <typename Expr>
+double quadratic_error(const Expr &ex, const streamed_dataset &data)
+{
+    if (ex.get_n() != data.get_n() || ex.get_m() != data.get_m()) {
+        throw std::invalid_argument("The dataset and the expression have a different number of inputs or outputs");
+    }
+    trace_scope scope("quadratic_error_streamed", "fitness");
+    double retval(0.);
+    data.for_each_chunk([&ex, &retval](const dataset &chunk) {
+        retval += quadratic_error(ex, chunk) * static_cast<double>(chunk.size());
+        return !std::isnan(retval);
+    });
+    return retval / static_cast<double>(data.size());
+}
+
 } // namespace dcgp
 
 #endif
@@ -0,0 +1,117 @@
+#ifndef DCGP_GRAPH_H
+#define DCGP_GRAPH_H
+
+#include <vector>
+
+#include <audi/audi.hpp>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+
+namespace dcgp
+{
+
+/// The active graph of a dCGP expression
+/**
+ * The directed acyclic graph of the active nodes of a dCGP expression, stored as arrays. The nodes are
+ * numbered as in the chromosome: the inputs are the nodes 0, ..., n - 1, the function nodes follow.
+ * The function nodes are listed in increasing order, which is an order of evaluation (a node only
+ * depends on nodes with a smaller id). Building an expression from the graph, e.g. a symbolic one, thus
+ * takes a time linear in its size, while the symbolic representation of the expression itself
+ * (see dcgp::expression::operator()()) can grow exponentially with the number of columns.
+ */
+struct expression_graph {
+    /// Number of inputs
+    unsigned n;
+    /// Arity of the function nodes
+    unsigned arity;
+    /// Ids of the active function nodes
+    std::vector<unsigned> nodes;
+    /// Index of the kernel of each node, in the kernels of the expression (see dcgp::expression::get_f())
+    std::vector<unsigned> kernels;
+    /// Number of inputs read by the kernel of each node (see dcgp::expression::get_node_arity())
+    std::vector<unsigned> arities;
+    /// Ids of the nodes connected to the inputs of each node: \p arity ids per node, of which only the first
+    /// dcgp::expression_graph::arities are edges of the graph (the others may lead to inactive nodes)
+    std::vector<unsigned> inputs;
+    /// Weights of the connections, as dcgp::expression_graph::inputs (empty for unweighted expressions)
+    std::vector<double> weights;
+    /// Ids of the nodes connected to the outputs
+    std::vector<unsigned> outputs;
+};
+
+namespace detail
+{
+
+// The weights are exported as doubles: for gduals we take their constant coefficient (in the first point)
+inline double graph_weight(double w)
+{
+    return w;
+}
+
+template <typename T>
+double graph_weight(const audi::vectorized<T> &w)
+{
+    return w[0];
+}
+
+template <typename Cf>
+double graph_weight(const audi::gdual<Cf> &w)
+{
+    return graph_weight(w.constant_cf());
+}
+
+} // namespace detail
+
+/// Gets the active graph of a dCGP expression
+/**
+ * @param[in] ex the dCGP expression
+ *
+ * @return the graph of the active nodes of \p ex
+ */
+template <typename T>
+expression_graph active_graph(const expression<T> &ex)
+{
+    const auto &chromosome = ex.get();
+    const auto n = ex.get_n(), arity = ex.get_arity();
+    expression_graph retval{n, arity, {}, {}, {}, {}, {}, {}};
+    for (auto node_id : ex.get_active_nodes()) {
+        if (node_id < n) {
+            continue;
+        }
+        const auto idx = (node_id - n) * (arity + 1u);
+        retval.nodes.push_back(node_id);
+        retval.kernels.push_back(chromosome[idx]);
+        retval.arities.push_back(ex.get_node_arity(node_id));
+        retval.inputs.insert(retval.inputs.end(), chromosome.begin() + idx + 1u,
+                             chromosome.begin() + idx + 1u + arity);
+    }
+    retval.outputs.assign(chromosome.end() - ex.get_m(), chromosome.end());
+    return retval;
+}
+
+/// Gets the active graph of a weighted dCGP expression
+/**
+ * Same as the overload for dcgp::expression, with the weights of the connections (for gduals their
+ * constant coefficient).
+ *
+ * @param[in] ex the weighted dCGP expression
+ *
+ * @return the graph of the active nodes of \p ex
+ */
+template <typename T>
+expression_graph active_graph(const expression_weighted<T> &ex)
+{
+    auto retval = active_graph(static_cast<const expression<T> &>(ex));
+    const auto &weights = ex.get_weights();
+    for (auto node_id : retval.nodes) {
+        for (auto j = 0u; j < retval.arity; ++j) {
+            retval.weights.push_back(detail::graph_weight(weights[(node_id - retval.n) * retval.arity + j]));
+        }
+    }
+    return retval;
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_GRAPH_H
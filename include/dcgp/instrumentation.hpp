@@ -0,0 +1,280 @@
+#ifndef DCGP_INSTRUMENTATION_H
+#define DCGP_INSTRUMENTATION_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(DCGP_INSTRUMENTATION)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#endif
+
+#include <dcgp/interval.hpp>
+#include <dcgp/type_traits.hpp>
+
+namespace dcgp
+{
+
+/// Whether the instrumentation counters are compiled in
+/**
+ * The counters of dcgp::kernel and dcgp::expression are only updated if the macro DCGP_INSTRUMENTATION is
+ * defined (CMake option DCGP_ENABLE_INSTRUMENTATION), otherwise they are compiled out and always zero.
+ *
+ * @return true if the counters are updated
+ */
+constexpr bool instrumentation_enabled()
+{
+#if defined(DCGP_INSTRUMENTATION)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// Counters of a kernel (see dcgp::kernel::get_counters())
+struct kernel_counters {
+    /// Number of points where the kernel was evaluated
+    std::uint64_t calls = 0u;
+    /// Time spent in the evaluations, in nanoseconds
+    std::uint64_t nanoseconds = 0u;
+    /// Number of non finite results
+    std::uint64_t non_finite = 0u;
+};
+
+/// Counters of an expression (see dcgp::expression::get_counters())
+struct expression_counters {
+    /// Number of points where the expression was evaluated
+    std::uint64_t evaluations = 0u;
+    /// Number of genes mutated
+    std::uint64_t mutations = 0u;
+    /// Number of updates of the active nodes
+    std::uint64_t update_active = 0u;
+    /// Sum over the updates of the number of active nodes (divided by update_active gives the mean)
+    std::uint64_t active_nodes = 0u;
+    /// Largest number of active nodes
+    std::uint64_t max_active_nodes = 0u;
+};
+
+namespace detail
+{
+
+// Number of non finite values in [x, x + n)
+inline std::size_t count_non_finite(const double *x, std::size_t n)
+{
+    std::size_t retval = 0u;
+    for (std::size_t k = 0u; k < n; ++k) {
+        retval += !std::isfinite(x[k]);
+    }
+    return retval;
+}
+
+inline std::size_t count_non_finite(const interval *x, std::size_t n)
+{
+    std::size_t retval = 0u;
+    for (std::size_t k = 0u; k < n; ++k) {
+        retval += !x[k].is_finite();
+    }
+    return retval;
+}
+
+// Generalized duals are checked on their constant coefficient, when it is a number
+template <typename T, typename std::enable_if<is_gdual<T>::value
+                                                  && std::is_floating_point<typename T::cf_type>::value,
+                                              int>::type
+                      = 0>
+inline std::size_t count_non_finite(const T *x, std::size_t n)
+{
+    std::size_t retval = 0u;
+    for (std::size_t k = 0u; k < n; ++k) {
+        retval += !std::isfinite(x[k].constant_cf());
+    }
+    return retval;
+}
+
+template <typename T, typename std::enable_if<is_gdual<T>::value
+                                                  && !std::is_floating_point<typename T::cf_type>::value,
+                                              int>::type
+                      = 0>
+inline std::size_t count_non_finite(const T *, std::size_t)
+{
+    return 0u;
+}
+
+#if defined(DCGP_INSTRUMENTATION)
+
+// The counters of a kernel. They are shared by the copies of the kernel (e.g. the kernels of the
+// expressions constructed from the same dcgp::kernel_set) and updated atomically, as the copies may be
+// evaluated by different threads
+class kernel_instrumentation
+{
+public:
+    kernel_instrumentation() : m_counters(std::make_shared<counters>()) {}
+
+    // Evaluates f() in n points, writing their values in out
+    template <typename T, typename F>
+    void count(const T *out, std::size_t n, const F &f) const
+    {
+        const auto start = std::chrono::steady_clock::now();
+        f();
+        const auto stop = std::chrono::steady_clock::now();
+        record(n, stop - start, count_non_finite(out, n));
+    }
+
+    // Evaluates f() in one point, returning its value
+    template <typename F>
+    auto count(const F &f) const -> decltype(f())
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto retval = f();
+        const auto stop = std::chrono::steady_clock::now();
+        record(1u, stop - start, count_non_finite(&retval, 1u));
+        return retval;
+    }
+
+    kernel_counters get() const
+    {
+        kernel_counters retval;
+        retval.calls = m_counters->calls.load(std::memory_order_relaxed);
+        retval.nanoseconds = m_counters->nanoseconds.load(std::memory_order_relaxed);
+        retval.non_finite = m_counters->non_finite.load(std::memory_order_relaxed);
+        return retval;
+    }
+
+    void reset() const
+    {
+        m_counters->calls = 0u;
+        m_counters->nanoseconds = 0u;
+        m_counters->non_finite = 0u;
+    }
+
+private:
+    struct counters {
+        std::atomic<std::uint64_t> calls{0u};
+        std::atomic<std::uint64_t> nanoseconds{0u};
+        std::atomic<std::uint64_t> non_finite{0u};
+    };
+
+    void record(std::size_t n, std::chrono::steady_clock::duration elapsed, std::size_t non_finite) const
+    {
+        m_counters->calls.fetch_add(n, std::memory_order_relaxed);
+        m_counters->nanoseconds.fetch_add(
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+            std::memory_order_relaxed);
+        m_counters->non_finite.fetch_add(non_finite, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<counters> m_counters;
+};
+
+// The counters of an expression. They are shared by the copies of the expression, so that the counts of
+// e.g. the offspring of an evolutionary strategy add up in the expression they were copied from
+class expression_instrumentation
+{
+public:
+    expression_instrumentation() : m_counters(std::make_shared<counters>()) {}
+
+    void add_evaluations(std::size_t n) const
+    {
+        m_counters->evaluations.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void add_mutations(std::size_t n) const
+    {
+        m_counters->mutations.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void add_update_active(std::size_t active_nodes) const
+    {
+        m_counters->update_active.fetch_add(1u, std::memory_order_relaxed);
+        m_counters->active_nodes.fetch_add(active_nodes, std::memory_order_relaxed);
+        auto max = m_counters->max_active_nodes.load(std::memory_order_relaxed);
+        while (max < active_nodes
+               && !m_counters->max_active_nodes.compare_exchange_weak(max, active_nodes, std::memory_order_relaxed)) {
+        }
+    }
+
+    expression_counters get() const
+    {
+        expression_counters retval;
+        retval.evaluations = m_counters->evaluations.load(std::memory_order_relaxed);
+        retval.mutations = m_counters->mutations.load(std::memory_order_relaxed);
+        retval.update_active = m_counters->update_active.load(std::memory_order_relaxed);
+        retval.active_nodes = m_counters->active_nodes.load(std::memory_order_relaxed);
+        retval.max_active_nodes = m_counters->max_active_nodes.load(std::memory_order_relaxed);
+        return retval;
+    }
+
+    void reset() const
+    {
+        m_counters->evaluations = 0u;
+        m_counters->mutations = 0u;
+        m_counters->update_active = 0u;
+        m_counters->active_nodes = 0u;
+        m_counters->max_active_nodes = 0u;
+    }
+
+private:
+    struct counters {
+        std::atomic<std::uint64_t> evaluations{0u};
+        std::atomic<std::uint64_t> mutations{0u};
+        std::atomic<std::uint64_t> update_active{0u};
+        std::atomic<std::uint64_t> active_nodes{0u};
+        std::atomic<std::uint64_t> max_active_nodes{0u};
+    };
+
+    std::shared_ptr<counters> m_counters;
+};
+
+#else
+
+// Without DCGP_INSTRUMENTATION the counters are empty and their updates compile to nothing
+
+class kernel_instrumentation
+{
+public:
+    template <typename T, typename F>
+    void count(const T *, std::size_t, const F &f) const
+    {
+        f();
+    }
+
+    template <typename F>
+    auto count(const F &f) const -> decltype(f())
+    {
+        return f();
+    }
+
+    kernel_counters get() const
+    {
+        return kernel_counters{};
+    }
+
+    void reset() const {}
+};
+
+class expression_instrumentation
+{
+public:
+    void add_evaluations(std::size_t) const {}
+    void add_mutations(std::size_t) const {}
+    void add_update_active(std::size_t) const {}
+
+    expression_counters get() const
+    {
+        return expression_counters{};
+    }
+
+    void reset() const {}
+};
+
+#endif
+
+} // namespace detail
+
+} // end of namespace dcgp
+
+#endif // DCGP_INSTRUMENTATION_H
@@ -0,0 +1,278 @@
+#ifndef DCGP_INTERVAL_H
+#define DCGP_INTERVAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace dcgp
+{
+
+/// An interval of real numbers
+/**
+ * This class implements interval arithmetic: the result of an operation on intervals contains
+ * the results of the operation on every choice of values in the operands. Evaluating a dCGP expression
+ * (dcgp::expression<dcgp::interval>) on the ranges of its inputs thus bounds every node over the whole
+ * input domain at the cost of one evaluation (see dcgp::output_bounds()).
+ *
+ * The bounds are widened by one ulp after each operation to absorb rounding errors. A possible division
+ * by zero, logarithm of a non positive number or overflow gives infinite bounds, and marks the result
+ * and everything computed from it as possibly non finite (see dcgp::interval::is_finite()), even when
+ * later operations (e.g. a sine) bring the bounds back to finite values. Operations with no valid
+ * result at all (e.g. the logarithm of a negative interval) give the empty interval, whose bounds are NaN.
+ */
+class interval
+{
+public:
+    /// Constructor from a number
+    /**
+     * Constructs the degenerate interval [x, x]
+     *
+     * @param[in] x the number
+     */
+    interval(double x = 0.) : m_lower(x), m_upper(x), m_non_finite(!std::isfinite(x)) {}
+
+    /// Constructor
+    /**
+     * Constructs the interval [lower, upper]
+     *
+     * @param[in] lower the lower bound
+     * @param[in] upper the upper bound
+     *
+     * @throw std::invalid_argument if \p lower is larger than \p upper
+     */
+    interval(double lower, double upper)
+        : m_lower(lower), m_upper(upper), m_non_finite(!(std::isfinite(lower) && std::isfinite(upper)))
+    {
+        if (lower > upper) {
+            throw std::invalid_argument("The lower bound of an interval cannot be larger than the upper bound");
+        }
+    }
+
+    /// The empty interval
+    static interval empty()
+    {
+        interval retval;
+        retval.m_lower = retval.m_upper = std::numeric_limits<double>::quiet_NaN();
+        retval.m_non_finite = true;
+        return retval;
+    }
+
+    /// Gets the lower bound
+    double lower() const
+    {
+        return m_lower;
+    }
+
+    /// Gets the upper bound
+    double upper() const
+    {
+        return m_upper;
+    }
+
+    /// Whether the interval is empty
+    bool is_empty() const
+    {
+        return std::isnan(m_lower) || std::isnan(m_upper);
+    }
+
+    /// Whether the values in the interval are certainly finite
+    /**
+     * @return true if the interval is not empty, its bounds are finite and it was not computed from
+     * intervals with infinite bounds
+     */
+    bool is_finite() const
+    {
+        return !m_non_finite;
+    }
+
+    /// Whether the interval contains \p x
+    bool contains(double x) const
+    {
+        return m_lower <= x && x <= m_upper;
+    }
+
+    interval operator-() const
+    {
+        interval retval(*this);
+        retval.m_lower = -m_upper;
+        retval.m_upper = -m_lower;
+        return retval;
+    }
+
+    friend interval operator+(const interval &a, const interval &b)
+    {
+        if (a.is_empty() || b.is_empty()) {
+            return empty();
+        }
+        return widened(a.m_lower + b.m_lower, a.m_upper + b.m_upper, a.m_non_finite || b.m_non_finite);
+    }
+
+    friend interval operator-(const interval &a, const interval &b)
+    {
+        return a + (-b);
+    }
+
+    friend interval operator*(const interval &a, const interval &b)
+    {
+        if (a.is_empty() || b.is_empty()) {
+            return empty();
+        }
+        const double p[] = {mul(a.m_lower, b.m_lower), mul(a.m_lower, b.m_upper), mul(a.m_upper, b.m_lower),
+                            mul(a.m_upper, b.m_upper)};
+        return widened(*std::min_element(p, p + 4), *std::max_element(p, p + 4),
+                       a.m_non_finite || b.m_non_finite);
+    }
+
+    friend interval operator/(const interval &a, const interval &b)
+    {
+        if (a.is_empty() || b.is_empty() || (b.m_lower == 0. && b.m_upper == 0.)) {
+            return empty();
+        }
+        if (b.contains(0.)) {
+            return interval(-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+        }
+        return a * widened(1. / b.m_upper, 1. / b.m_lower, b.m_non_finite);
+    }
+
+    interval &operator+=(const interval &other)
+    {
+        return *this = *this + other;
+    }
+
+    interval &operator-=(const interval &other)
+    {
+        return *this = *this - other;
+    }
+
+    interval &operator*=(const interval &other)
+    {
+        return *this = *this * other;
+    }
+
+    interval &operator/=(const interval &other)
+    {
+        return *this = *this / other;
+    }
+
+    /// The smallest interval containing \p a and \p b (empty if any of the two is)
+    friend interval hull(const interval &a, const interval &b)
+    {
+        if (a.is_empty() || b.is_empty()) {
+            return empty();
+        }
+        interval retval(std::min(a.m_lower, b.m_lower), std::max(a.m_upper, b.m_upper));
+        retval.m_non_finite = a.m_non_finite || b.m_non_finite;
+        return retval;
+    }
+
+    friend interval exp(const interval &a)
+    {
+        if (a.is_empty()) {
+            return empty();
+        }
+        return widened(std::max(0., std::exp(a.m_lower)), std::exp(a.m_upper), a.m_non_finite);
+    }
+
+    /// The sigmoid 1 / (1 + exp(-x))
+    /**
+     * The sigmoid is increasing and bounded by [0, 1]: the result is finite (unless \p a is marked as
+     * non finite) even when exp(-x) overflows over the interval.
+     */
+    friend interval sig(const interval &a)
+    {
+        if (a.is_empty()) {
+            return empty();
+        }
+        auto retval = widened(logistic(a.m_lower), logistic(a.m_upper), a.m_non_finite);
+        retval.m_lower = std::max(retval.m_lower, 0.);
+        retval.m_upper = std::min(retval.m_upper, 1.);
+        return retval;
+    }
+
+    friend interval log(const interval &a)
+    {
+        if (a.is_empty() || a.m_upper < 0.) {
+            return empty();
+        }
+        return widened(a.m_lower > 0. ? std::log(a.m_lower) : -std::numeric_limits<double>::infinity(),
+                       std::log(a.m_upper), a.m_non_finite);
+    }
+
+    friend interval cos(const interval &a)
+    {
+        if (a.is_empty()) {
+            return empty();
+        }
+        const double pi = 3.141592653589793238463;
+        if (!(a.m_upper - a.m_lower < 2. * pi)) {
+            interval retval(-1., 1.);
+            retval.m_non_finite = a.m_non_finite;
+            return retval;
+        }
+        double lower = std::min(std::cos(a.m_lower), std::cos(a.m_upper));
+        double upper = std::max(std::cos(a.m_lower), std::cos(a.m_upper));
+        // The maxima are at 2k pi, the minima at (2k + 1) pi
+        if (2. * pi * std::ceil(a.m_lower / (2. * pi)) <= a.m_upper) {
+            upper = 1.;
+        }
+        if (pi + 2. * pi * std::ceil((a.m_lower - pi) / (2. * pi)) <= a.m_upper) {
+            lower = -1.;
+        }
+        auto retval = widened(lower, upper, a.m_non_finite);
+        retval.m_lower = std::max(retval.m_lower, -1.);
+        retval.m_upper = std::min(retval.m_upper, 1.);
+        return retval;
+    }
+
+    friend interval sin(const interval &a)
+    {
+        return cos(a - interval(1.570796326794896619231));
+    }
+
+    /// Overloaded stream operator
+    friend std::ostream &operator<<(std::ostream &os, const interval &a)
+    {
+        os << "[" << a.m_lower << ", " << a.m_upper << "]";
+        return os;
+    }
+
+private:
+    // Products of bounds: 0 * inf is 0, as the infinite bound is never attained
+    static double mul(double x, double y)
+    {
+        return (x == 0. || y == 0.) ? 0. : x * y;
+    }
+
+    // The sigmoid in a form where the exponential cannot overflow
+    static double logistic(double x)
+    {
+        if (x >= 0.) {
+            return 1. / (1. + std::exp(-x));
+        }
+        const double e = std::exp(x);
+        return e / (1. + e);
+    }
+
+    // Widens [lower, upper] by one ulp on each side, the result is marked as possibly non finite if
+    // non_finite is or the bounds are not finite
+    static interval widened(double lower, double upper, bool non_finite)
+    {
+        interval retval;
+        retval.m_lower = std::nextafter(lower, -std::numeric_limits<double>::infinity());
+        retval.m_upper = std::nextafter(upper, std::numeric_limits<double>::infinity());
+        retval.m_non_finite = non_finite || !(std::isfinite(retval.m_lower) && std::isfinite(retval.m_upper));
+        return retval;
+    }
+
+    double m_lower;
+    double m_upper;
+    // Whether a value in the interval, or in the intervals it was computed from, may be non finite
+    bool m_non_finite;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_INTERVAL_H
@@ -0,0 +1,339 @@
+#ifndef DCGP_JIT_H
+#define DCGP_JIT_H
+
+#if defined(_WIN32)
+#error "The dcgp JIT compiler relies on dlopen and is only available on POSIX systems"
+#endif
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <dcgp/code_generator.hpp>
+#include <dcgp/dataset.hpp>
+#include <dcgp/fitness_functions.hpp>
+
+namespace dcgp
+{
+
+namespace detail
+{
+
+// FNV-1a: unlike std::hash, it is stable across runs and platforms, which is what we need
+// to key an on-disk cache
+inline std::uint64_t fnv1a(const std::string &in)
+{
+    std::uint64_t retval = 14695981039346656037ull;
+    for (auto c : in) {
+        retval ^= static_cast<unsigned char>(c);
+        retval *= 1099511628211ull;
+    }
+    return retval;
+}
+
+inline std::string getenv_or(const char *name, const std::string &def)
+{
+    auto value = std::getenv(name);
+    return (value && *value) ? std::string(value) : def;
+}
+
+inline std::string home_dir()
+{
+    auto home = std::getenv("HOME");
+    if (home && *home) {
+        return home;
+    }
+    auto pw = ::getpwuid(::getuid());
+    if (!pw || !pw->pw_dir) {
+        throw std::runtime_error("Could not determine the home directory of the current user");
+    }
+    return pw->pw_dir;
+}
+
+// A cached file or directory is trusted only if it is ours and nobody else can write it, otherwise
+// another local user could plant a shared object that we would load
+inline bool is_private(const std::string &path, bool directory)
+{
+    struct stat st;
+    if (::lstat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    return (directory ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode)) && st.st_uid == ::getuid()
+           && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+inline void make_private_dir(const std::string &dir)
+{
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Could not create the directory " + dir);
+    }
+    if (!is_private(dir, true)) {
+        throw std::runtime_error("The directory " + dir
+                                 + " is not owned by the current user or is writable by others");
+    }
+}
+
+// Runs a program without going through the shell, returns true if it exited with status 0
+inline bool run_program(const std::vector<std::string> &args)
+{
+    std::vector<char *> argv;
+    for (const auto &arg : args) {
+        argv.push_back(const_cast<char *>(arg.c_str()));
+    }
+    argv.push_back(nullptr);
+    auto pid = ::fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+    }
+    int status;
+    while (::waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+} // namespace detail
+
+/// A dCGP expression compiled to native code
+/**
+ * This class compiles the active graph of a dCGP expression (see dcgp::generate_c_source()) with the compiler
+ * installed in the system, loads the resulting shared object via dlopen and evaluates the expression through
+ * a native function pointer. There is no interpretive overhead left, but the construction takes as long
+ * as a compiler invocation (tens of milliseconds), hence it only pays off on large datasets.
+ *
+ * The shared objects are cached on disk and keyed by a hash of the phenotype and of the compiler command,
+ * so that compiling the same phenotype again (in this or another process) only costs a dlopen. The cache
+ * directory is the environment variable DCGP_JIT_CACHE_DIR, if defined, or $XDG_CACHE_HOME/dcgp
+ * (~/.cache/dcgp by default). It is created with mode 0700, and the cache directory and shared objects
+ * are only used if they belong to the current user and are not writable by others. The compiler is the
+ * environment variable DCGP_JIT_CC, CC or, if none is defined, "cc": it is executed directly (not through
+ * the shell), hence it must be the name or path of a program, without arguments.
+ *
+ * The compiled expression is immutable: it does not follow later changes of the dCGP expression it
+ * was built from. Copies share the loaded shared object.
+ */
+class compiled_expression
+{
+    using fun_type = void (*)(const double *, double *);
+    using batch_fun_type = void (*)(const double *const *, double *const *, std::size_t);
+
+public:
+    /// Constructor
+    /**
+     * Compiles (or loads from the cache) the dCGP expression \p ex.
+     *
+     * @param[in] ex a dcgp::expression or dcgp::expression_weighted
+     *
+     * @throw std::invalid_argument if \p ex uses kernels with no C counterpart
+     * @throw std::runtime_error if the compilation or the loading of the shared object fail
+     */
+    template <typename Expr>
+    explicit compiled_expression(const Expr &ex) : m_n(ex.get_n()), m_m(ex.get_m())
+    {
+        auto source = generate_c_source(ex, "dcgp_expression");
+        const auto compiler = get_compiler();
+        std::string key = source;
+        for (const auto &arg : compiler) {
+            key += '\0' + arg;
+        }
+        std::ostringstream oss;
+        oss << std::hex << std::setw(16) << std::setfill('0') << detail::fnv1a(key);
+        m_hash = oss.str();
+        m_handle = load(source, compiler);
+        m_f = reinterpret_cast<fun_type>(::dlsym(m_handle.get(), "dcgp_expression"));
+        m_f_batch = reinterpret_cast<batch_fun_type>(::dlsym(m_handle.get(), "dcgp_expression_batch"));
+        if (!m_f || !m_f_batch) {
+            throw std::runtime_error("Could not find the compiled dCGP expression in the shared object " + m_hash);
+        }
+    }
+
+    /// Evaluates the compiled expression
+    /**
+     * @param[in] in an std::vector containing the values where the expression has to be computed
+     *
+     * @return The value of the function (an std::vector)
+     *
+     * @throw std::invalid_argument if the size of \p in is not the number of inputs
+     */
+    std::vector<double> operator()(const std::vector<double> &in) const
+    {
+        if (in.size() != m_n) {
+            throw std::invalid_argument("Input size is incompatible");
+        }
+        std::vector<double> retval(m_m);
+        m_f(in.data(), retval.data());
+        return retval;
+    }
+
+    /// Evaluates the compiled expression on a batch of points
+    /**
+     * @param[in] in the \p n pointers to the \p N values of each input
+     * @param[in] out the \p m pointers where the \p N values of each output are written
+     * @param[in] N the number of points
+     *
+     * @throw std::invalid_argument if the sizes of \p in or \p out are incompatible
+     */
+    void operator()(const std::vector<const double *> &in, const std::vector<double *> &out, std::size_t N) const
+    {
+        if (in.size() != m_n || out.size() != m_m) {
+            throw std::invalid_argument("Input or output size is incompatible");
+        }
+        m_f_batch(in.data(), out.data(), N);
+    }
+
+    /// Gets the number of inputs
+    unsigned get_n() const
+    {
+        return m_n;
+    }
+
+    /// Gets the number of outputs
+    unsigned get_m() const
+    {
+        return m_m;
+    }
+
+    /// Gets the phenotype hash
+    /**
+     * @return the hexadecimal hash of the phenotype and of the compiler command used as key in the on-disk cache
+     */
+    const std::string &get_hash() const
+    {
+        return m_hash;
+    }
+
+    /// Gets the cache directory
+    /**
+     * @return the directory where the compiled shared objects are cached
+     */
+    static std::string get_cache_dir()
+    {
+        auto dir = detail::getenv_or("DCGP_JIT_CACHE_DIR", "");
+        if (dir.empty()) {
+            auto xdg = detail::getenv_or("XDG_CACHE_HOME", "");
+            dir = (xdg.empty() ? detail::home_dir() + "/.cache" : xdg) + "/dcgp";
+        }
+        return dir;
+    }
+
+private:
+    // The compiler followed by the flags, without the output and input files
+    static std::vector<std::string> get_compiler()
+    {
+        return {detail::getenv_or("DCGP_JIT_CC", detail::getenv_or("CC", "cc")), "-O3", "-shared", "-fPIC"};
+    }
+
+    std::shared_ptr<void> load(const std::string &source, const std::vector<std::string> &compiler) const
+    {
+        const auto dir = get_cache_dir();
+        if (detail::getenv_or("DCGP_JIT_CACHE_DIR", "").empty()) {
+            // ~/.cache may not exist yet
+            auto parent = dir.substr(0, dir.rfind('/'));
+            if (::mkdir(parent.c_str(), 0700) != 0 && errno != EEXIST) {
+                throw std::runtime_error("Could not create the directory " + parent);
+            }
+        }
+        detail::make_private_dir(dir);
+        const auto so_file = dir + "/dcgp_" + m_hash + ".so";
+        struct stat st;
+        if (::lstat(so_file.c_str(), &st) != 0) {
+            // Compiles in private files and then renames the object, so that concurrent processes
+            // and threads never load a partially written shared object
+            const auto tmp = dir + "/dcgp_" + m_hash + "_" + std::to_string(::getpid()) + "_"
+                             + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+            {
+                std::ofstream src(tmp + ".c");
+                src << source;
+                if (!src) {
+                    throw std::runtime_error("Could not write the source file " + tmp + ".c");
+                }
+            }
+            auto args = compiler;
+            args.insert(args.end(), {"-o", tmp + ".so", tmp + ".c", "-lm"});
+            auto success = detail::run_program(args);
+            std::remove((tmp + ".c").c_str());
+            if (!success || ::chmod((tmp + ".so").c_str(), 0700) != 0
+                || std::rename((tmp + ".so").c_str(), so_file.c_str()) != 0) {
+                std::remove((tmp + ".so").c_str());
+                std::string command;
+                for (const auto &arg : args) {
+                    command += (command.empty() ? "" : " ") + arg;
+                }
+                throw std::runtime_error("Failed to compile the dCGP expression with: " + command);
+            }
+        }
+        if (!detail::is_private(so_file, false)) {
+            throw std::runtime_error("The shared object " + so_file
+                                     + " is not owned by the current user or is writable by others");
+        }
+        auto handle = ::dlopen(so_file.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle) {
+            throw std::runtime_error("Could not load the shared object " + so_file + ": " + ::dlerror());
+        }
+        return std::shared_ptr<void>(handle, [](void *h) { ::dlclose(h); });
+    }
+
+    unsigned m_n;
+    unsigned m_m;
+    std::string m_hash;
+    std::shared_ptr<void> m_handle;
+    fun_type m_f;
+    batch_fun_type m_f_batch;
+};
+
+/// Computes the quadratic error of a dCGP expression, compiling it when the data are many
+/**
+ * Same as dcgp::quadratic_error(const Expr &, const dataset &, double) on a columnar copy of the data
+ * (see dcgp::dataset), but when the number of points is at least \p min_points the expression is first
+ * compiled to native code (see dcgp::compiled_expression). Below the threshold the compilation time would
+ * not be amortized and the expression is interpreted as usual. In both cases the expression is evaluated
+ * in batches and the result does not depend on the threshold: in particular it is NaN if the expression
+ * is not finite on some point.
+ *
+ * This is meant for long evaluations (final refinements, validations), not for the evolution
+ * loop where every offspring is a new phenotype.
+ *
+ * @param[in] ex a dcgp::expression<double> or dcgp::expression_weighted<double>
+ * @param[in] in_des the input points
+ * @param[in] out_des the desired outputs
+ * @param[in] min_points the minimum number of points that triggers the compilation
+ *
+ * @return the quadratic error, or NaN if the expression is not finite on some point
+ *
+ * @throw std::invalid_argument if the sizes of \p in_des and \p out_des are inconsistent
+ */
+template <typename Expr>
+double quadratic_error_jit(const Expr &ex, const std::vector<std::vector<double>> &in_des,
+                           const std::vector<std::vector<double>> &out_des, std::size_t min_points = 100000u)
+{
+    const dataset data(in_des, out_des);
+    if (data.size() < min_points) {
+        return quadratic_error(ex, data);
+    }
+    return quadratic_error(compiled_expression(ex), data);
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_JIT_H
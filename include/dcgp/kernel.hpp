@@ -1,6 +1,7 @@
 #ifndef DCGP_KERNEL_H
 #define DCGP_KERNEL_H
 
+#include <cstddef>
 #include <functional> // std::function
 #include <utility>    // std::forward
 #include <string>
@@ -8,6 +9,8 @@
 #include <vector>
 #include <audi/audi.hpp>
 
+#include <dcgp/instrumentation.hpp>
+
 using namespace audi;
 using gdual_d = audi::gdual<double>;
 
@@ -35,6 +38,8 @@ public:
     using my_fun_type = std::function<T(const std::vector<T>&)>;
     /// Basic prototype of a kernel function returning its symbolic representation
     using my_print_fun_type = std::function<std::string(const std::vector<std::string>&)>;
+    /// Basic prototype of a kernel function evaluating a batch of points
+    using my_batch_fun_type = std::function<void(const std::vector<const T*>&, T*, std::size_t)>;
 
     /// Constructor
     /**
@@ -48,6 +53,45 @@ public:
     template <typename U, typename V>
     kernel(U &&f, V &&pf, std::string name):m_f(std::forward<U>(f)), m_pf(std::forward<V>(pf)), m_name(name) {}
 
+    /// Constructor
+    /**
+     * Constructs a kernel that can be used as kernel in a dCGP expression and that
+     * has a dedicated implementation for the evaluation of batches of points
+     *
+     * @param[in] f any callable with prototype T(const std::vector<T>&)
+     * @param[in] pf any callable with prototype std::string(const std::vector<std::string>&)
+     * @param[in] name string containing the function name (ex. "sum")
+     * @param[in] bf any callable with prototype void(const std::vector<const T*>&, T*, std::size_t)
+     * writing in its second argument the function values in the points whose inputs are in the first argument
+     *
+     */
+    template <typename U, typename V, typename W>
+    kernel(U &&f, V &&pf, std::string name, W &&bf)
+        : m_f(std::forward<U>(f)), m_pf(std::forward<V>(pf)), m_bf(std::forward<W>(bf)), m_name(name)
+    {
+    }
+
+    /// Constructor
+    /**
+     * Constructs a kernel that reads only the first \p arity inputs of the node (e.g. 1 for "sin"):
+     * the connections to the other inputs are then inactive, and the nodes they lead to are not evaluated
+     *
+     * @param[in] f any callable with prototype T(const std::vector<T>&)
+     * @param[in] pf any callable with prototype std::string(const std::vector<std::string>&)
+     * @param[in] name string containing the function name (ex. "sin")
+     * @param[in] bf any callable with prototype void(const std::vector<const T*>&, T*, std::size_t), or nullptr
+     * if the kernel has no dedicated batch implementation
+     * @param[in] arity the number of inputs read by the kernel, 0 if it reads all the inputs of the node
+     * (e.g. "sum")
+     *
+     */
+    template <typename U, typename V, typename W>
+    kernel(U &&f, V &&pf, std::string name, W &&bf, unsigned arity)
+        : m_f(std::forward<U>(f)), m_pf(std::forward<V>(pf)), m_bf(std::forward<W>(bf)), m_name(name),
+          m_arity(arity)
+    {
+    }
+
     /// Parenthesis operator
     /**
     * Evaluates the kernel in the point \p in
@@ -58,7 +102,7 @@ public:
     */
     T operator()(const std::vector<T>& in) const
     {
-            return m_f(in);
+            return m_counters.count([this, &in]() { return m_f(in); });
     }
     /// Parenthesis operator
     /**
@@ -70,7 +114,32 @@ public:
     */
     T operator()(const std::initializer_list<T>& in) const
     {
-            return m_f(in);
+            return m_counters.count([this, &in]() { return m_f(in); });
+    }
+    /// Parenthesis operator
+    /**
+    * Evaluates the kernel in \p N points. If the kernel was not constructed with a batch function,
+    * it is evaluated point by point.
+    *
+    * @param[in] in the pointers to the \p N values of each input
+    * @param[out] out where the \p N function values are written
+    * @param[in] N the number of points
+    */
+    void operator()(const std::vector<const T*>& in, T* out, std::size_t N) const
+    {
+            m_counters.count(out, N, [this, &in, out, N]() {
+                if (m_bf) {
+                    m_bf(in, out, N);
+                    return;
+                }
+                std::vector<T> point(in.size());
+                for (std::size_t k = 0u; k < N; ++k) {
+                    for (decltype(in.size()) j = 0u; j < in.size(); ++j) {
+                        point[j] = in[j][k];
+                    }
+                    out[k] = m_f(point);
+                }
+            });
     }
     /// Parenthesis operator
     /**
@@ -85,6 +154,60 @@ public:
             return m_pf(in);
     }
 
+    /// Gets the kernel name
+    /**
+     * Gets the name of the kernel (ex. "sum")
+     *
+     * @return the kernel name
+     */
+    const std::string &get_name() const
+    {
+            return m_name;
+    }
+
+    /// Gets the arity
+    /**
+     * Gets the number of inputs the kernel reads: the kernel is called with the first ones of its node
+     *
+     * @return the arity, 0 if the kernel reads all the inputs of its node (e.g. "sum")
+     */
+    unsigned get_arity() const
+    {
+            return m_arity;
+    }
+
+    /// Gets the symbolic representation
+    /**
+     * Gets the function returning the symbolic representation of the operation, e.g. to find
+     * (via std::function::target()) the objects a user-defined kernel was constructed from
+     *
+     * @return the function passed to the constructor as \p pf
+     */
+    const my_print_fun_type &get_print_function() const
+    {
+            return m_pf;
+    }
+
+    /// Gets the instrumentation counters
+    /**
+     * Gets the number of evaluations of the kernel, the time they took and the number of non finite
+     * results. The counters are shared by the copies of the kernel, e.g. by all the expressions constructed
+     * with the kernels of the same dcgp::kernel_set, and are only updated if the instrumentation is compiled
+     * in (see dcgp::instrumentation_enabled()).
+     *
+     * @return the counters
+     */
+    kernel_counters get_counters() const
+    {
+            return m_counters.get();
+    }
+
+    /// Resets the instrumentation counters
+    void reset_counters() const
+    {
+            m_counters.reset();
+    }
+
     /// Overloaded stream operator
     /**
      * Will stream the function name
@@ -106,8 +229,14 @@ private:
     my_fun_type m_f;
     /// Its symbolic representation
     my_print_fun_type m_pf;
+    /// Its batch evaluation (may be empty)
+    my_batch_fun_type m_bf;
     /// Its name
     std::string m_name;
+    /// The number of inputs it reads (0 for all)
+    unsigned m_arity = 0u;
+    /// Its instrumentation counters
+    detail::kernel_instrumentation m_counters;
 };
 
 } // end of namespace dcgp
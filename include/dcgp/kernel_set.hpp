@@ -44,7 +44,15 @@ public:
     /// Adds a kernel to the set
     /**
      * Constructs a kernel<T> given a string containing the function name, and
-     * inserts it into the std::vector
+     * inserts it into the std::vector. The unary kernels ("sin", "cos", "log", "exp") and "pdiv" only read
+     * their first inputs (see dcgp::kernel::get_arity()): the connection genes of their other inputs are not
+     * active, hence not mutated by dcgp::expression::mutate_active(). This changes the search dynamics
+     * (less neutral drift) with respect to versions where all the connections were active; the old behaviour
+     * is obtained by constructing the kernels without an arity, e.g.
+     * kernel<T>(my_sin<T>, print_my_sin, "sin", my_sin_batch<T>). "fast_sig" and "fast_exp" compute "sig" and "exp"
+     * for doubles with a relative error below 1e-15 (exactly for gduals and intervals) and, on batches of
+     * points, in a fraction of their time if the compiler vectorizes them (e.g. with AVX2): the expressions
+     * found with them can be re-scored with the exact kernels (see dcgp::with_exact_kernels())
      *
      * @param[in] kernel_name a string containing the function name
      *
@@ -53,25 +61,29 @@ public:
     void push_back(std::string kernel_name)
     {
         if (kernel_name == "sum")
-            m_kernels.emplace_back(my_sum<T>, print_my_sum, kernel_name);
+            m_kernels.emplace_back(my_sum<T>, print_my_sum, kernel_name, my_sum_batch<T>);
         else if (kernel_name == "diff")
-            m_kernels.emplace_back(my_diff<T>, print_my_diff, kernel_name);
+            m_kernels.emplace_back(my_diff<T>, print_my_diff, kernel_name, my_diff_batch<T>);
         else if (kernel_name == "mul")
-            m_kernels.emplace_back(my_mul<T>, print_my_mul, kernel_name);
+            m_kernels.emplace_back(my_mul<T>, print_my_mul, kernel_name, my_mul_batch<T>);
         else if (kernel_name == "div")
-            m_kernels.emplace_back(my_div<T>, print_my_div, kernel_name);
+            m_kernels.emplace_back(my_div<T>, print_my_div, kernel_name, my_div_batch<T>);
         else if (kernel_name == "pdiv")
-            m_kernels.emplace_back(my_pdiv<T>, print_my_pdiv, kernel_name);
+            m_kernels.emplace_back(my_pdiv<T>, print_my_pdiv, kernel_name, my_pdiv_batch<T>, 2u);
         else if (kernel_name == "sig")
-            m_kernels.emplace_back(my_sig<T>, print_my_sig, kernel_name);
+            m_kernels.emplace_back(my_sig<T>, print_my_sig, kernel_name, my_sig_batch<T>);
         else if (kernel_name == "sin")
-            m_kernels.emplace_back(my_sin<T>, print_my_sin, kernel_name);
+            m_kernels.emplace_back(my_sin<T>, print_my_sin, kernel_name, my_sin_batch<T>, 1u);
         else if (kernel_name == "cos")
-            m_kernels.emplace_back(my_cos<T>, print_my_cos, kernel_name);
+            m_kernels.emplace_back(my_cos<T>, print_my_cos, kernel_name, my_cos_batch<T>, 1u);
         else if (kernel_name == "log")
-            m_kernels.emplace_back(my_log<T>, print_my_log, kernel_name);
+            m_kernels.emplace_back(my_log<T>, print_my_log, kernel_name, my_log_batch<T>, 1u);
         else if (kernel_name == "exp")
-            m_kernels.emplace_back(my_exp<T>, print_my_exp, kernel_name);
+            m_kernels.emplace_back(my_exp<T>, print_my_exp, kernel_name, my_exp_batch<T>, 1u);
+        else if (kernel_name == "fast_sig")
+            m_kernels.emplace_back(my_fast_sig<T>, print_my_sig, kernel_name, my_fast_sig_batch<T>);
+        else if (kernel_name == "fast_exp")
+            m_kernels.emplace_back(my_fast_exp<T>, print_my_exp, kernel_name, my_fast_exp_batch<T>, 1u);
         else
             throw std::invalid_argument("Unimplemented function " + kernel_name);
     }
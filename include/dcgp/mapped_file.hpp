@@ -0,0 +1,123 @@
+#ifndef DCGP_MAPPED_FILE_H
+#define DCGP_MAPPED_FILE_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dcgp
+{
+
+/// A read-only memory-mapped file
+/**
+ * This class maps a whole file in memory, read-only, for the lifetime of the object. The pages are
+ * loaded lazily by the operating system and are shared with all the other processes mapping the same file.
+ * The class is not copyable: share it through a smart pointer.
+ */
+class mapped_file
+{
+public:
+    /// Constructor
+    /**
+     * Maps the file \p filename in memory
+     *
+     * @param[in] filename the file to map
+     *
+     * @throw std::runtime_error if the file cannot be opened or mapped
+     */
+    explicit mapped_file(const std::string &filename) : m_data(nullptr), m_size(0u)
+    {
+#if defined(_WIN32)
+        auto file = ::CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Could not open the file " + filename);
+        }
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(file, &size)) {
+            ::CloseHandle(file);
+            throw std::runtime_error("Could not get the size of the file " + filename);
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+        if (m_size) {
+            auto mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                m_data = static_cast<const char *>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                ::CloseHandle(mapping);
+            }
+        }
+        ::CloseHandle(file);
+#else
+        auto fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::runtime_error("Could not open the file " + filename);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == -1) {
+            ::close(fd);
+            throw std::runtime_error("Could not get the size of the file " + filename);
+        }
+        m_size = static_cast<std::size_t>(st.st_size);
+        if (m_size) {
+            auto ptr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (ptr != MAP_FAILED) {
+                m_data = static_cast<const char *>(ptr);
+            }
+        }
+        ::close(fd);
+#endif
+        if (m_size && !m_data) {
+            throw std::runtime_error("Could not map the file " + filename + " in memory");
+        }
+    }
+
+    /// Destructor
+    ~mapped_file()
+    {
+        if (m_data) {
+#if defined(_WIN32)
+            ::UnmapViewOfFile(m_data);
+#else
+            ::munmap(const_cast<char *>(m_data), m_size);
+#endif
+        }
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    /// Gets the mapped data
+    /**
+     * @return a pointer to the first byte of the file (aligned to the page size), nullptr for an empty file
+     */
+    const char *data() const
+    {
+        return m_data;
+    }
+
+    /// Gets the size of the file
+    /**
+     * @return the size of the mapped file in bytes
+     */
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    const char *m_data;
+    std::size_t m_size;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_MAPPED_FILE_H
@@ -0,0 +1,224 @@
+#ifndef DCGP_RACING_FITNESS_H
+#define DCGP_RACING_FITNESS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <dcgp/dataset.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/trace.hpp>
+
+namespace dcgp
+{
+
+/// Racing evaluation of the quadratic error
+/**
+ * This class computes the quadratic error (see dcgp::quadratic_error()) of a group of candidate expressions,
+ * e.g. the offspring of one generation of an evolutionary strategy, when only the best ones matter.
+ * All candidates are first evaluated on a random sample of the points. The candidates whose error is,
+ * with statistical confidence, worse than that of another candidate (or worse than a given cutoff, such
+ * as the parent fitness) are dropped, the others race on a sample twice as large, and so on until
+ * the survivors are evaluated on the whole dataset. Hopeless candidates are thus discarded after a
+ * fraction of the point evaluations.
+ *
+ * The confidence test compares the means of the squared errors on the sample, plus or minus \p z times
+ * their standard error. The blocks of 64 consecutive points are shuffled once at construction and each race
+ * starts from a random point, so the samples are made of whole blocks evaluated in batches. The data are not
+ * copied: the dataset (e.g. a memory mapped one) is shared.
+ */
+class racing_fitness
+{
+public:
+    /// Constructor
+    /**
+     * @param[in] data the dataset
+     * @param[in] initial_sample the number of points of the first sample
+     * @param[in] z the width, in standard errors, of the confidence interval of the errors
+     * @param[in] seed seed for the random number generator
+     *
+     * @throw std::invalid_argument if \p initial_sample is zero or \p z is negative
+     */
+    racing_fitness(const dataset &data, std::size_t initial_sample = 1000u, double z = 2.,
+                   unsigned seed = std::random_device{}())
+        : m_data(data), m_initial_sample(initial_sample), m_z(z), m_e(seed), m_evaluations(0u),
+          m_saved_evaluations(0u)
+    {
+        if (initial_sample == 0u) {
+            throw std::invalid_argument("The initial sample must contain at least one point");
+        }
+        if (!(z >= 0.)) {
+            throw std::invalid_argument("The confidence parameter z must be non negative");
+        }
+        // The last block, possibly partial, stays last
+        m_blocks.resize((data.size() + block_size - 1u) / block_size);
+        std::iota(m_blocks.begin(), m_blocks.end(), std::size_t(0u));
+        std::shuffle(m_blocks.begin(), m_blocks.end() - (data.size() % block_size ? 1 : 0), m_e);
+    }
+
+    /// Races the candidates
+    /**
+     * @param[in] candidates the candidate expressions (dcgp::expression<double> or dcgp::expression_weighted<double>)
+     * @param[in] cutoff candidates confidently worse than this are dropped too (e.g. the parent fitness in a
+     * (1 + lambda)-ES)
+     *
+     * @return the fitness of each candidate: its quadratic error on the whole dataset if it survived the race,
+     * infinity if it was dropped, NaN if it produced a non finite value (such candidates are dropped at once,
+     * see dcgp::expression::evaluate_checked())
+     *
+     * @throw std::invalid_argument if the number of inputs or outputs of a candidate and the dataset differ
+     */
+    template <typename Expr>
+    std::vector<double> operator()(const std::vector<Expr> &candidates,
+                                   double cutoff = std::numeric_limits<double>::infinity())
+    {
+        trace_scope scope("racing", "fitness");
+        for (const auto &ex : candidates) {
+            if (ex.get_n() != m_data.get_n() || ex.get_m() != m_data.get_m()) {
+                throw std::invalid_argument("The dataset and the expression have a different number of inputs or "
+                                            "outputs");
+            }
+        }
+        const auto N = m_data.size();
+        std::vector<double> sum(candidates.size(), 0.), sum2(candidates.size(), 0.);
+        std::vector<bool> alive(candidates.size(), true), finite(candidates.size(), true);
+        const auto start = N ? std::uniform_int_distribution<std::size_t>(0u, N - 1u)(m_e) : std::size_t(0u);
+        std::size_t done = 0u;
+        std::size_t n_alive = candidates.size();
+        while (done < N && n_alive) {
+            const auto sample = (done == 0u) ? std::min(N, m_initial_sample) : std::min(N, 2u * done);
+            // The sample grows from done to sample points: [start + done, start + sample) wrapping around
+            for (decltype(candidates.size()) i = 0u; i < candidates.size(); ++i) {
+                if (alive[i]) {
+                    const auto first = (start + done) % N;
+                    const auto size = sample - done;
+                    const auto size1 = std::min(size, N - first);
+                    std::size_t evaluated = 0u;
+                    finite[i] = accumulate(candidates[i], first, size1, sum[i], sum2[i], evaluated)
+                                && accumulate(candidates[i], 0u, size - size1, sum[i], sum2[i], evaluated);
+                    m_evaluations += evaluated;
+                    if (!finite[i]) {
+                        alive[i] = false;
+                        --n_alive;
+                        m_saved_evaluations += N - done - evaluated;
+                    }
+                }
+            }
+            done = sample;
+            if (done == N) {
+                break;
+            }
+            // The best upper bound among the candidates (and the cutoff)
+            const auto n = static_cast<double>(done);
+            auto bound = [this, n, &sum, &sum2](decltype(candidates.size()) i, double sign) {
+                const auto mean = sum[i] / n;
+                const auto variance = std::max(0., sum2[i] / n - mean * mean);
+                return mean + sign * m_z * std::sqrt(variance / n);
+            };
+            double best_upper = cutoff;
+            for (decltype(candidates.size()) i = 0u; i < candidates.size(); ++i) {
+                if (alive[i]) {
+                    best_upper = std::min(best_upper, bound(i, 1.));
+                }
+            }
+            for (decltype(candidates.size()) i = 0u; i < candidates.size(); ++i) {
+                if (alive[i] && !(bound(i, -1.) <= best_upper)) {
+                    alive[i] = false;
+                    --n_alive;
+                    m_saved_evaluations += N - done;
+                }
+            }
+        }
+        std::vector<double> retval(candidates.size(), std::numeric_limits<double>::infinity());
+        for (decltype(candidates.size()) i = 0u; i < candidates.size(); ++i) {
+            if (!finite[i]) {
+                retval[i] = std::numeric_limits<double>::quiet_NaN();
+            } else if (alive[i]) {
+                retval[i] = sum[i] / static_cast<double>(N);
+            }
+        }
+        return retval;
+    }
+
+    /// Gets the number of point evaluations
+    /**
+     * @return the number of points (times candidates) evaluated since construction
+     */
+    std::uint64_t get_evaluations() const
+    {
+        return m_evaluations;
+    }
+
+    /// Gets the number of point evaluations saved
+    /**
+     * @return the number of points (times candidates) that were not evaluated since construction thanks to the
+     * racing, with respect to evaluating all candidates on the whole dataset
+     */
+    std::uint64_t get_saved_evaluations() const
+    {
+        return m_saved_evaluations;
+    }
+
+private:
+    // Adds the squared errors of ex in the points [first, first + size) of the shuffled order of the blocks,
+    // and their number to evaluated. Returns false (and stops) if ex produces a non finite value
+    template <typename Expr>
+    bool accumulate(const Expr &ex, std::size_t first, std::size_t size, double &sum, double &sum2,
+                    std::size_t &evaluated) const
+    {
+        std::vector<std::vector<double>> out_real(m_data.get_m(), std::vector<double>(block_size));
+        std::vector<double> errors(block_size);
+        std::vector<const double *> in(m_data.get_n());
+        std::vector<double *> out(m_data.get_m());
+        for (auto i = 0u; i < m_data.get_m(); ++i) {
+            out[i] = out_real[i].data();
+        }
+        for (auto position = first; position < first + size;) {
+            const auto offset = m_blocks[position / block_size] * block_size + position % block_size;
+            const auto n_points = std::min({block_size - position % block_size, first + size - position,
+                                            m_data.size() - offset});
+            for (auto j = 0u; j < m_data.get_n(); ++j) {
+                in[j] = m_data.get_input(j) + offset;
+            }
+            evaluated += n_points;
+            if (!detail::evaluate_finite(ex, in, out, n_points, 0)) {
+                return false;
+            }
+            std::fill(errors.begin(), errors.begin() + static_cast<std::ptrdiff_t>(n_points), 0.);
+            for (auto i = 0u; i < m_data.get_m(); ++i) {
+                const double *out_des = m_data.get_output(i) + offset;
+                for (std::size_t k = 0u; k < n_points; ++k) {
+                    errors[k] += (out_des[k] - out[i][k]) * (out_des[k] - out[i][k]);
+                }
+            }
+            for (std::size_t k = 0u; k < n_points; ++k) {
+                sum += errors[k];
+                sum2 += errors[k] * errors[k];
+            }
+            position += n_points;
+        }
+        return true;
+    }
+
+    // The number of consecutive points shuffled together
+    static constexpr std::size_t block_size = 64u;
+
+    dataset m_data;
+    // The order in which the blocks of points are visited
+    std::vector<std::size_t> m_blocks;
+    std::size_t m_initial_sample;
+    double m_z;
+    std::default_random_engine m_e;
+    std::uint64_t m_evaluations;
+    std::uint64_t m_saved_evaluations;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_RACING_FITNESS_H
@@ -0,0 +1,517 @@
+#ifndef DCGP_SERIALIZATION_H
+#define DCGP_SERIALIZATION_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <locale>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/kernel.hpp>
+#include <dcgp/kernel_set.hpp>
+#include <dcgp/mapped_file.hpp>
+
+namespace dcgp
+{
+
+/*--------------------------------------------------------------------------
+ * Binary archive format (native byte order, checked through a marker):
+ *
+ * header:  char[8] magic "DCGP-EXP", uint32 byte order marker, uint32 version,
+ *          uint64 number of records, uint64 offset of each record (from the file start)
+ * record:  uint32 weighted, uint32 n, m, r, c, l, arity, uint32 number of kernels,
+ *          {uint32 length, chars} for each kernel name, padding to 4 bytes,
+ *          uint32 chromosome size, uint32 genes, padding to 8 bytes,
+ *          uint64 number of weights, float64 weights,
+ *          uint32 length, chars of the state of the random engine (from version 2)
+ *
+ * Records start at 8 bytes boundaries, so that genes and weights can be read in place. Archives of
+ * version 1 (with no random state) are still read.
+ *------------------------------------------------------------------------**/
+
+/// A record of an expression archive
+/**
+ * A view on one expression stored in a dcgp::expression_archive. The chromosome and the weights point
+ * directly into the archive memory and are valid as long as the archive is.
+ */
+struct archive_record {
+    /// Whether the record stores a dcgp::expression_weighted
+    bool weighted;
+    /// Number of inputs
+    unsigned n;
+    /// Number of outputs
+    unsigned m;
+    /// Number of rows
+    unsigned r;
+    /// Number of columns
+    unsigned c;
+    /// Number of levels-back
+    unsigned l;
+    /// Arity of the basis functions
+    unsigned arity;
+    /// Names of the kernels
+    std::vector<std::string> kernels;
+    /// The chromosome
+    const std::uint32_t *chromosome;
+    /// Size of the chromosome
+    std::size_t chromosome_size;
+    /// The weights (only for weighted expressions)
+    const double *weights;
+    /// Number of weights
+    std::size_t weights_size;
+    /// The state of the random engine, in the text format of the standard library (empty for archives of
+    /// version 1)
+    std::string random_state;
+};
+
+namespace detail
+{
+
+constexpr char archive_magic[8] = {'D', 'C', 'G', 'P', '-', 'E', 'X', 'P'};
+constexpr std::uint32_t archive_byte_order = 0x01020304u;
+constexpr std::uint32_t archive_version = 2u;
+
+template <typename U>
+void archive_put(std::string &buffer, const U &value)
+{
+    buffer.append(reinterpret_cast<const char *>(&value), sizeof(U));
+}
+
+inline void archive_pad(std::string &buffer, std::size_t alignment)
+{
+    buffer.append((alignment - buffer.size() % alignment) % alignment, '\0');
+}
+
+// Weights are stored as doubles: for gduals we store their constant coefficient
+inline double archive_weight(double w)
+{
+    return w;
+}
+
+inline double archive_weight(const gdual_d &w)
+{
+    return w.constant_cf();
+}
+
+template <typename T>
+std::vector<double> archive_weights(const expression<T> &)
+{
+    return {};
+}
+
+template <typename T>
+std::vector<double> archive_weights(const expression_weighted<T> &ex)
+{
+    std::vector<double> retval;
+    for (const auto &w : ex.get_weights()) {
+        retval.push_back(archive_weight(w));
+    }
+    return retval;
+}
+
+template <typename T>
+bool archive_is_weighted(const expression<T> &)
+{
+    return false;
+}
+
+template <typename T>
+bool archive_is_weighted(const expression_weighted<T> &)
+{
+    return true;
+}
+
+template <typename T>
+void archive_set_weights(expression<T> &, const archive_record &)
+{
+}
+
+template <typename T>
+void archive_set_weights(expression_weighted<T> &ex, const archive_record &record)
+{
+    std::vector<T> weights;
+    for (decltype(record.weights_size) i = 0u; i < record.weights_size; ++i) {
+        weights.emplace_back(record.weights[i]);
+    }
+    ex.set_weights(weights);
+}
+
+// The type T of a dcgp::expression<T> or dcgp::expression_weighted<T>
+template <typename Expr>
+struct expression_value_type {
+};
+
+template <typename T>
+struct expression_value_type<expression<T>> {
+    using type = T;
+};
+
+template <typename T>
+struct expression_value_type<expression_weighted<T>> {
+    using type = T;
+};
+
+inline std::string archive_random_state(const std::default_random_engine &e)
+{
+    std::ostringstream oss;
+    oss.imbue(std::locale::classic());
+    oss << e;
+    return oss.str();
+}
+
+inline std::default_random_engine archive_random_engine(const std::string &state)
+{
+    std::istringstream iss(state);
+    iss.imbue(std::locale::classic());
+    std::default_random_engine retval;
+    if (!(iss >> retval) || !(iss >> std::ws).eof()) {
+        throw std::invalid_argument("Corrupted dCGP expression archive");
+    }
+    return retval;
+}
+
+template <typename Expr>
+void archive_put_record(std::string &buffer, const Expr &ex)
+{
+    const auto weights = archive_weights(ex);
+    archive_put(buffer, static_cast<std::uint32_t>(archive_is_weighted(ex)));
+    for (auto v : {ex.get_n(), ex.get_m(), ex.get_rows(), ex.get_cols(), ex.get_levels_back(), ex.get_arity()}) {
+        archive_put(buffer, static_cast<std::uint32_t>(v));
+    }
+    archive_put(buffer, static_cast<std::uint32_t>(ex.get_f().size()));
+    for (const auto &k : ex.get_f()) {
+        archive_put(buffer, static_cast<std::uint32_t>(k.get_name().size()));
+        buffer.append(k.get_name());
+    }
+    archive_pad(buffer, 4u);
+    archive_put(buffer, static_cast<std::uint32_t>(ex.get().size()));
+    for (auto g : ex.get()) {
+        archive_put(buffer, static_cast<std::uint32_t>(g));
+    }
+    archive_pad(buffer, 8u);
+    archive_put(buffer, static_cast<std::uint64_t>(weights.size()));
+    for (auto w : weights) {
+        archive_put(buffer, w);
+    }
+    const auto state = archive_random_state(ex.get_random_engine());
+    archive_put(buffer, static_cast<std::uint32_t>(state.size()));
+    buffer.append(state);
+}
+
+// Bounds-checked reader over the archive memory
+class archive_reader
+{
+public:
+    archive_reader(const char *data, std::size_t size, std::size_t pos) : m_data(data), m_size(size), m_pos(pos) {}
+    template <typename U>
+    U get()
+    {
+        U retval;
+        std::memcpy(&retval, advance(sizeof(U)), sizeof(U));
+        return retval;
+    }
+    template <typename U>
+    const U *get_array(std::size_t n)
+    {
+        if (n > m_size / sizeof(U)) {
+            throw std::invalid_argument("Corrupted dCGP expression archive");
+        }
+        return reinterpret_cast<const U *>(advance(n * sizeof(U)));
+    }
+    void align(std::size_t alignment)
+    {
+        advance((alignment - m_pos % alignment) % alignment);
+    }
+
+private:
+    const char *advance(std::size_t n)
+    {
+        if (n > m_size || m_pos > m_size - n) {
+            throw std::invalid_argument("Corrupted dCGP expression archive");
+        }
+        auto retval = m_data + m_pos;
+        m_pos += n;
+        return retval;
+    }
+    const char *m_data;
+    std::size_t m_size;
+    std::size_t m_pos;
+};
+
+} // namespace detail
+
+/// Serializes a population of dCGP expressions
+/**
+ * Encodes the expressions in \p pop in the dcgp binary archive format. For each expression the archive
+ * contains the topology parameters, the names of the kernels, the chromosome, for weighted
+ * expressions the weights (for gduals only their constant coefficient) and the state of the random
+ * engine, so that the expressions loaded mutate as the original ones would.
+ *
+ * @param[in] pop an std::vector of dcgp::expression or dcgp::expression_weighted
+ *
+ * @return an std::string containing the archive
+ */
+template <typename Expr>
+std::string to_archive(const std::vector<Expr> &pop)
+{
+    std::string buffer;
+    buffer.append(detail::archive_magic, sizeof(detail::archive_magic));
+    detail::archive_put(buffer, detail::archive_byte_order);
+    detail::archive_put(buffer, detail::archive_version);
+    detail::archive_put(buffer, static_cast<std::uint64_t>(pop.size()));
+    const auto offsets_pos = buffer.size();
+    buffer.append(pop.size() * sizeof(std::uint64_t), '\0');
+    for (decltype(pop.size()) i = 0u; i < pop.size(); ++i) {
+        detail::archive_pad(buffer, 8u);
+        const auto offset = static_cast<std::uint64_t>(buffer.size());
+        std::memcpy(&buffer[offsets_pos + i * sizeof(std::uint64_t)], &offset, sizeof(std::uint64_t));
+        detail::archive_put_record(buffer, pop[i]);
+    }
+    return buffer;
+}
+
+/// Saves a population of dCGP expressions to file
+/**
+ * Writes to \p filename the archive returned by dcgp::to_archive()
+ *
+ * @param[in] filename the file name
+ * @param[in] pop an std::vector of dcgp::expression or dcgp::expression_weighted
+ *
+ * @throw std::runtime_error if the file cannot be written
+ */
+template <typename Expr>
+void save_archive(const std::string &filename, const std::vector<Expr> &pop)
+{
+    const auto buffer = to_archive(pop);
+    std::ofstream file(filename, std::ios::binary);
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!file) {
+        throw std::runtime_error("Could not write the file " + filename);
+    }
+}
+
+/// An archive of dCGP expressions
+/**
+ * This class gives random access to the expressions stored in the dcgp binary archive format (see
+ * dcgp::to_archive()). When constructed from a file, the file is memory-mapped and nothing is read
+ * besides the records that are accessed: loading thousands of expressions costs as much as the
+ * ones actually used.
+ */
+class expression_archive
+{
+public:
+    /// Constructor from file
+    /**
+     * Memory-maps the archive in \p filename
+     *
+     * @param[in] filename the file name
+     *
+     * @throw std::runtime_error if the file cannot be mapped
+     * @throw std::invalid_argument if the file is not a valid archive
+     */
+    explicit expression_archive(const std::string &filename)
+        : m_file(std::make_shared<mapped_file>(filename)), m_data(m_file->data()), m_size(m_file->size())
+    {
+        check_header();
+    }
+
+    /// Constructor from memory
+    /**
+     * Views the archive in the memory pointed by \p data, that must stay valid for the lifetime of
+     * the object and of the records it returns, and be aligned to 8 bytes.
+     *
+     * @param[in] data pointer to the archive
+     * @param[in] size size of the archive in bytes
+     *
+     * @throw std::invalid_argument if \p data is not a valid archive
+     */
+    expression_archive(const char *data, std::size_t size) : m_data(data), m_size(size)
+    {
+        check_header();
+    }
+
+    /// Number of expressions
+    /**
+     * @return the number of expressions in the archive
+     */
+    std::size_t size() const
+    {
+        return m_count;
+    }
+
+    /// Gets a record
+    /**
+     * @param[in] idx the index of the record
+     *
+     * @return the \p idx -th record
+     *
+     * @throw std::out_of_range if \p idx is not smaller than size()
+     * @throw std::invalid_argument if the record is corrupted
+     */
+    archive_record operator[](std::size_t idx) const
+    {
+        if (idx >= m_count) {
+            throw std::out_of_range("Index of the dCGP expression out of the archive bounds");
+        }
+        detail::archive_reader offsets(m_data, m_size, m_offsets_pos + idx * sizeof(std::uint64_t));
+        const auto offset = offsets.get<std::uint64_t>();
+        if (offset % 8u || offset > m_size) {
+            throw std::invalid_argument("Corrupted dCGP expression archive");
+        }
+        detail::archive_reader reader(m_data, m_size, static_cast<std::size_t>(offset));
+        archive_record retval;
+        retval.weighted = reader.get<std::uint32_t>() != 0u;
+        retval.n = reader.get<std::uint32_t>();
+        retval.m = reader.get<std::uint32_t>();
+        retval.r = reader.get<std::uint32_t>();
+        retval.c = reader.get<std::uint32_t>();
+        retval.l = reader.get<std::uint32_t>();
+        retval.arity = reader.get<std::uint32_t>();
+        const auto n_kernels = reader.get<std::uint32_t>();
+        for (auto i = 0u; i < n_kernels; ++i) {
+            const auto length = reader.get<std::uint32_t>();
+            retval.kernels.emplace_back(reader.get_array<char>(length), length);
+        }
+        reader.align(4u);
+        retval.chromosome_size = reader.get<std::uint32_t>();
+        retval.chromosome = reader.get_array<std::uint32_t>(retval.chromosome_size);
+        reader.align(8u);
+        retval.weights_size = static_cast<std::size_t>(reader.get<std::uint64_t>());
+        retval.weights = reader.get_array<double>(retval.weights_size);
+        if (m_version >= 2u) {
+            const auto length = reader.get<std::uint32_t>();
+            retval.random_state.assign(reader.get_array<char>(length), length);
+        }
+        return retval;
+    }
+
+private:
+    void check_header()
+    {
+        if (reinterpret_cast<std::uintptr_t>(m_data) % 8u) {
+            throw std::invalid_argument("A dCGP expression archive must be aligned to 8 bytes");
+        }
+        detail::archive_reader reader(m_data, m_size, 0u);
+        if (std::memcmp(reader.get_array<char>(8u), detail::archive_magic, 8u) != 0) {
+            throw std::invalid_argument("Not a dCGP expression archive");
+        }
+        if (reader.get<std::uint32_t>() != detail::archive_byte_order) {
+            throw std::invalid_argument("The dCGP expression archive was written with a different byte order");
+        }
+        m_version = reader.get<std::uint32_t>();
+        if (m_version == 0u || m_version > detail::archive_version) {
+            throw std::invalid_argument("Unsupported version of the dCGP expression archive: "
+                                        + std::to_string(m_version));
+        }
+        m_count = static_cast<std::size_t>(reader.get<std::uint64_t>());
+        m_offsets_pos = 24u;
+        reader.get_array<std::uint64_t>(m_count);
+    }
+
+    std::shared_ptr<mapped_file> m_file;
+    const char *m_data;
+    std::size_t m_size;
+    std::uint32_t m_version;
+    std::size_t m_count;
+    std::size_t m_offsets_pos;
+};
+
+/// Constructs a dCGP expression from an archive record
+/**
+ * Constructs the dcgp::expression (or dcgp::expression_weighted) stored in \p record using the
+ * kernels \p f, for example when the expression uses user-defined kernels. The random engine is
+ * restored from the record, if it stores its state.
+ *
+ * @tparam Expr dcgp::expression<T> or dcgp::expression_weighted<T>
+ *
+ * @param[in] record the archive record
+ * @param[in] f the kernels, their names must match those in the record
+ * @param[in] seed seed for the random number generator of the expression, if the record stores no random state
+ *
+ * @return the expression
+ *
+ * @throw std::invalid_argument if the kernels do not match or the record does not store an \p Expr
+ */
+template <typename Expr, typename T>
+Expr from_archive(const archive_record &record, const std::vector<kernel<T>> &f, unsigned seed = 0u)
+{
+    static_assert(std::is_same<Expr, expression<T>>::value || std::is_same<Expr, expression_weighted<T>>::value,
+                  "A dCGP archive record can only be loaded as a dcgp::expression or a dcgp::expression_weighted");
+    if (record.weighted != std::is_same<Expr, expression_weighted<T>>::value) {
+        throw std::invalid_argument(record.weighted ? "The record stores a weighted dCGP expression"
+                                                    : "The record stores a dCGP expression with no weights");
+    }
+    if (f.size() != record.kernels.size()) {
+        throw std::invalid_argument("The number of kernels does not match the archive record");
+    }
+    for (decltype(f.size()) i = 0u; i < f.size(); ++i) {
+        if (f[i].get_name() != record.kernels[i]) {
+            throw std::invalid_argument("The kernel " + f[i].get_name() + " does not match the archive record, "
+                                        + record.kernels[i] + " was expected");
+        }
+    }
+    Expr retval(record.n, record.m, record.r, record.c, record.l, record.arity, f, seed);
+    retval.set(std::vector<unsigned>(record.chromosome, record.chromosome + record.chromosome_size));
+    detail::archive_set_weights(retval, record);
+    if (!record.random_state.empty()) {
+        retval.set_random_engine(detail::archive_random_engine(record.random_state));
+    }
+    return retval;
+}
+
+/// Constructs a dCGP expression from an archive record
+/**
+ * Constructs the dcgp::expression (or dcgp::expression_weighted) stored in \p record. The kernels are
+ * constructed by name via dcgp::kernel_set. The random engine is restored from the record, if it stores
+ * its state.
+ *
+ * @tparam Expr dcgp::expression<T> or dcgp::expression_weighted<T>
+ *
+ * @param[in] record the archive record
+ * @param[in] seed seed for the random number generator of the expression, if the record stores no random state
+ *
+ * @return the expression
+ *
+ * @throw std::invalid_argument if a kernel is not implemented or the record does not store an \p Expr
+ */
+template <typename Expr>
+Expr from_archive(const archive_record &record, unsigned seed = 0u)
+{
+    using T = typename detail::expression_value_type<Expr>::type;
+    return from_archive<Expr>(record, kernel_set<T>(record.kernels)(), seed);
+}
+
+/// Loads a population of dCGP expressions from file
+/**
+ * Loads all the expressions in the archive \p filename (see dcgp::save_archive())
+ *
+ * @tparam Expr dcgp::expression<T> or dcgp::expression_weighted<T>
+ *
+ * @param[in] filename the file name
+ * @param[in] seed seed for the random number generator of the first expression, the following get seed + 1, ...
+ * (only for archives of version 1, the later ones store the state of the random engines)
+ *
+ * @return an std::vector containing the expressions
+ */
+template <typename Expr>
+std::vector<Expr> load_archive(const std::string &filename, unsigned seed = 0u)
+{
+    expression_archive archive(filename);
+    std::vector<Expr> retval;
+    retval.reserve(archive.size());
+    for (decltype(archive.size()) i = 0u; i < archive.size(); ++i) {
+        retval.push_back(from_archive<Expr>(archive[i], seed + static_cast<unsigned>(i)));
+    }
+    return retval;
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_SERIALIZATION_H
@@ -0,0 +1,168 @@
+#ifndef DCGP_STREAMED_DATASET_H
+#define DCGP_STREAMED_DATASET_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dcgp/dataset.hpp>
+#include <dcgp/trace.hpp>
+
+namespace dcgp
+{
+
+/// A dataset read from disk chunk by chunk
+/**
+ * This class gives access to a dataset in the dcgp binary format (see dcgp::dataset::save_binary()) that
+ * does not need to fit in memory: the points are read in chunks of fixed size, and the next chunk is
+ * read by a background thread while the current one is being processed. At most two chunks are in
+ * memory at any time.
+ *
+ * Datasets in the CSV format can be converted to the binary format with the convert_dataset example.
+ */
+class streamed_dataset
+{
+public:
+    /// Constructor
+    /**
+     * Opens the dataset in \p filename and reads its header
+     *
+     * @param[in] filename the file name of a dataset in the dcgp binary format
+     * @param[in] chunk_size the number of points in each chunk
+     *
+     * @throw std::runtime_error if the file cannot be read
+     * @throw std::invalid_argument if the file is not a valid dcgp binary dataset or if \p chunk_size is zero
+     */
+    explicit streamed_dataset(const std::string &filename, std::size_t chunk_size = 65536u)
+        : m_filename(filename), m_chunk_size(chunk_size)
+    {
+        if (chunk_size == 0u) {
+            throw std::invalid_argument("The chunk size must be positive");
+        }
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file) {
+            throw std::runtime_error("Could not open the file " + filename);
+        }
+        const auto size = static_cast<std::uint64_t>(file.tellg());
+        char buffer[detail::dataset_header_size] = {};
+        file.seekg(0);
+        file.read(buffer, static_cast<std::streamsize>(std::min<std::uint64_t>(size, detail::dataset_header_size)));
+        m_header = detail::read_dataset_header(buffer, size, filename);
+    }
+
+    /// Gets the number of inputs
+    unsigned get_n() const
+    {
+        return m_header.n;
+    }
+
+    /// Gets the number of outputs
+    unsigned get_m() const
+    {
+        return m_header.m;
+    }
+
+    /// Gets the number of points
+    std::size_t size() const
+    {
+        return static_cast<std::size_t>(m_header.N);
+    }
+
+    /// Gets the chunk size
+    std::size_t get_chunk_size() const
+    {
+        return m_chunk_size;
+    }
+
+    /// Processes the dataset chunk by chunk
+    /**
+     * Reads the dataset from the beginning and calls \p f on each chunk, in order. While \p f runs,
+     * the next chunk is read by a background thread. As soon as \p f returns false no further chunk
+     * is read, and the function returns.
+     *
+     * @param[in] f any callable with prototype bool(const dcgp::dataset &), returning whether to continue.
+     * The chunk passed is only valid during the call: its memory is recycled for the following chunks.
+     *
+     * @throw std::runtime_error if the file cannot be read
+     */
+    template <typename F>
+    void for_each_chunk(const F &f) const
+    {
+        const auto N = size();
+        if (N == 0u) {
+            return;
+        }
+        const auto rows = std::min(m_chunk_size, N);
+        // Double buffering: each buffer has its own stream, as they are used by different threads
+        dataset chunks[2];
+        std::ifstream files[2];
+        for (auto b = 0u; b < 2u; ++b) {
+            chunks[b].allocate(get_n(), get_m(), rows);
+            files[b].open(m_filename, std::ios::binary);
+            if (!files[b]) {
+                throw std::runtime_error("Could not open the file " + m_filename);
+            }
+        }
+        std::vector<float> scratch[2];
+        auto read = [this, &chunks, &files, &scratch](unsigned b, std::size_t start) {
+            trace_scope scope("read_chunk", "io");
+            read_chunk(files[b], chunks[b], scratch[b], start);
+        };
+        // NOTE: the future is declared after the buffers, so that if f throws its destructor
+        // waits for the prefetching thread before the buffers are destroyed
+        auto next = std::async(std::launch::async, read, 0u, std::size_t(0u));
+        unsigned current = 0u;
+        for (std::size_t start = 0u; start < N; start += m_chunk_size) {
+            {
+                // Time lost waiting for the disk
+                trace_scope scope("wait_chunk", "io");
+                next.get();
+            }
+            if (start + m_chunk_size < N) {
+                next = std::async(std::launch::async, read, 1u - current, start + m_chunk_size);
+            }
+            if (!f(static_cast<const dataset &>(chunks[current]))) {
+                // The destructor of next waits for the chunk being prefetched, if any
+                return;
+            }
+            current = 1u - current;
+        }
+    }
+
+private:
+    // Reads the points [start, start + chunk size) into the chunk
+    void read_chunk(std::ifstream &file, dataset &chunk, std::vector<float> &scratch, std::size_t start) const
+    {
+        const auto rows = std::min(m_chunk_size, size() - start);
+        const auto column_size = m_header.stride * m_header.value_size;
+        chunk.m_N = rows;
+        for (auto c = 0u; c < get_n() + get_m(); ++c) {
+            file.seekg(static_cast<std::streamoff>(detail::dataset_header_size + c * column_size
+                                                   + start * m_header.value_size));
+            if (m_header.value_size == 8u) {
+                file.read(reinterpret_cast<char *>(chunk.column(c)),
+                          static_cast<std::streamsize>(rows * sizeof(double)));
+            } else {
+                scratch.resize(rows);
+                file.read(reinterpret_cast<char *>(scratch.data()), static_cast<std::streamsize>(rows * sizeof(float)));
+                std::copy(scratch.begin(), scratch.end(), chunk.column(c));
+            }
+            if (!file) {
+                throw std::runtime_error("Could not read the file " + m_filename);
+            }
+        }
+    }
+
+    std::string m_filename;
+    std::size_t m_chunk_size;
+    detail::dataset_header m_header;
+};
+
+} // end of namespace dcgp
+
+#endif // DCGP_STREAMED_DATASET_H
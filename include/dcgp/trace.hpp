@@ -0,0 +1,316 @@
+#ifndef DCGP_TRACE_H
+#define DCGP_TRACE_H
+
+#include <cstddef>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(DCGP_TRACE)
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace dcgp
+{
+
+/// Whether the trace events are compiled in
+/**
+ * The events of dcgp::trace_scope are only recorded if the macro DCGP_TRACE is defined (CMake option
+ * DCGP_ENABLE_TRACE), otherwise they are compiled out and the traces written are empty.
+ *
+ * @return true if the events are recorded
+ */
+constexpr bool trace_enabled()
+{
+#if defined(DCGP_TRACE)
+    return true;
+#else
+    return false;
+#endif
+}
+
+namespace detail
+{
+
+// Escapes a string for JSON
+inline std::string trace_json_string(const char *s)
+{
+    std::string retval = "\"";
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') {
+            retval += '\\';
+        }
+        retval += *s;
+    }
+    return retval + "\"";
+}
+
+#if defined(DCGP_TRACE)
+
+// A complete event: times in nanoseconds from the start of the trace. The names are not copied, they
+// must be string literals (or otherwise outlive the trace)
+struct trace_event {
+    const char *name;
+    const char *category;
+    std::int64_t start;
+    std::int64_t duration;
+};
+
+// The events of one thread. When full, the oldest events are overwritten: the memory used is bounded
+// and the last events before a problem are kept. The buffer is only written by its thread, the mutex
+// (uncontended but for the export) protects the reads of dcgp::write_trace()
+class trace_buffer
+{
+public:
+    trace_buffer(unsigned tid, std::size_t capacity) : m_tid(tid), m_capacity(capacity)
+    {
+        m_events.reserve(capacity);
+    }
+
+    void push(const trace_event &e)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_events.size() < m_capacity) {
+            m_events.push_back(e);
+        } else {
+            m_events[m_pushed % m_capacity] = e;
+        }
+        ++m_pushed;
+    }
+
+    // Writes the events (oldest first) in the Chrome format, each preceded by a comma
+    void write(std::ostream &os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto first = m_events.size() < m_capacity ? 0u : m_pushed % m_capacity;
+        for (std::size_t i = 0u; i < m_events.size(); ++i) {
+            const auto &e = m_events[(first + i) % m_events.size()];
+            os << ",\n{\"name\": " << trace_json_string(e.name) << ", \"cat\": " << trace_json_string(e.category)
+               << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << m_tid
+               << ", \"ts\": " << static_cast<double>(e.start) * 1e-3
+               << ", \"dur\": " << static_cast<double>(e.duration) * 1e-3 << "}";
+        }
+    }
+
+    std::size_t dropped() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pushed - m_events.size();
+    }
+
+    unsigned get_tid() const
+    {
+        return m_tid;
+    }
+
+    void reset(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity;
+        m_events.clear();
+        m_events.shrink_to_fit();
+        m_events.reserve(capacity);
+        m_pushed = 0u;
+    }
+
+private:
+    const unsigned m_tid;
+    std::size_t m_capacity;
+    std::vector<trace_event> m_events;
+    std::size_t m_pushed = 0u;
+    mutable std::mutex m_mutex;
+};
+
+// The buffers of all the threads that recorded events. They are kept after the threads end, so that
+// the trace of a parallel run can be written once its threads are joined
+class trace_registry
+{
+public:
+    static trace_registry &get()
+    {
+        static trace_registry registry;
+        return registry;
+    }
+
+    // The buffer of the calling thread, created at its first event
+    trace_buffer &local()
+    {
+        thread_local std::shared_ptr<trace_buffer> buffer = add();
+        return *buffer;
+    }
+
+    std::int64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_origin)
+            .count();
+    }
+
+    void write(std::ostream &os) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t dropped = 0u;
+        os << "{\"traceEvents\": [\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": "
+              "\"dcgp\"}}";
+        const auto flags = os.flags();
+        const auto precision = os.precision();
+        os << std::fixed << std::setprecision(3);
+        for (const auto &b : m_buffers) {
+            os << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << b->get_tid()
+               << ", \"args\": {\"name\": \"thread " << b->get_tid() << "\"}}";
+            b->write(os);
+            dropped += b->dropped();
+        }
+        os.flags(flags);
+        os.precision(precision);
+        os << "\n], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": " << dropped << "}}\n";
+    }
+
+    void reset(std::size_t capacity)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity;
+        for (const auto &b : m_buffers) {
+            b->reset(capacity);
+        }
+    }
+
+private:
+    trace_registry() : m_origin(std::chrono::steady_clock::now()) {}
+
+    std::shared_ptr<trace_buffer> add()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(std::make_shared<trace_buffer>(static_cast<unsigned>(m_buffers.size()), m_capacity));
+        return m_buffers.back();
+    }
+
+    const std::chrono::steady_clock::time_point m_origin;
+    std::size_t m_capacity = 65536u;
+    std::vector<std::shared_ptr<trace_buffer>> m_buffers;
+    mutable std::mutex m_mutex;
+};
+
+#endif
+
+} // namespace detail
+
+/// A scoped trace event
+/**
+ * Records the time spent between its construction and its destruction as a complete event of the
+ * calling thread (e.g. the evaluation of the offspring in an evolutionary strategy). The events are
+ * kept in a ring buffer per thread, whose mutex is only contended while the trace is written (threads
+ * recording events never wait for each other), and can be written in the Chrome trace-event format
+ * with dcgp::write_trace() to look at the load of each thread (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * If the trace is not compiled in (see dcgp::trace_enabled()) the class is empty and does nothing.
+ *
+ * @code
+ * {
+ *     dcgp::trace_scope scope("evaluation", "es");
+ *     ... // work to be traced
+ * }
+ * @endcode
+ */
+class trace_scope
+{
+public:
+    /// Constructor
+    /**
+     * Starts the event.
+     *
+     * @param[in] name the event name, a string literal as it is not copied
+     * @param[in] category the event category (e.g. "es", "fitness", "io"), a string literal as well
+     */
+#if defined(DCGP_TRACE)
+    trace_scope(const char *name, const char *category)
+        : m_name(name), m_category(category), m_start(detail::trace_registry::get().now())
+    {
+    }
+
+    /// Destructor, ends the event
+    ~trace_scope()
+    {
+        auto &registry = detail::trace_registry::get();
+        const auto stop = registry.now();
+        registry.local().push({m_name, m_category, m_start, stop - m_start});
+    }
+#else
+    trace_scope(const char *, const char *) {}
+#endif
+
+    // The event is bound to its scope
+    trace_scope(const trace_scope &) = delete;
+    trace_scope &operator=(const trace_scope &) = delete;
+
+#if defined(DCGP_TRACE)
+private:
+    const char *m_name;
+    const char *m_category;
+    std::int64_t m_start;
+#endif
+};
+
+/// Writes the trace events in the Chrome trace-event format
+/**
+ * Writes a JSON object with the events of all the threads that recorded some, one track per thread,
+ * with the times in microseconds from the first event. The number of events overwritten in full
+ * ring buffers is reported as "dropped_events" in "otherData".
+ *
+ * The events recorded while writing may or may not be included: to trace a parallel run, write the
+ * trace once the threads are joined.
+ *
+ * @param[in] os the stream where the trace is written
+ */
+inline void write_trace(std::ostream &os)
+{
+#if defined(DCGP_TRACE)
+    detail::trace_registry::get().write(os);
+#else
+    os << "{\"traceEvents\": [], \"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": 0}}\n";
+#endif
+}
+
+/// Writes the trace events in a file in the Chrome trace-event format
+/**
+ * See dcgp::write_trace().
+ *
+ * @param[in] filename the file name (e.g. "trace.json")
+ *
+ * @throw std::runtime_error if the file cannot be written
+ */
+inline void save_trace(const std::string &filename)
+{
+    std::ofstream file(filename);
+    write_trace(file);
+    if (!file) {
+        throw std::runtime_error("Could not write the trace in " + filename);
+    }
+}
+
+/// Clears the trace events
+/**
+ * Discards the events recorded so far and sets the capacity of the ring buffers.
+ *
+ * @param[in] capacity the number of events kept per thread (the most recent ones)
+ *
+ * @throw std::invalid_argument if \p capacity is zero
+ */
+inline void clear_trace(std::size_t capacity = 65536u)
+{
+    if (capacity == 0u) {
+        throw std::invalid_argument("The capacity of the trace buffers must be positive");
+    }
+#if defined(DCGP_TRACE)
+    detail::trace_registry::get().reset(capacity);
+#endif
+}
+
+} // end of namespace dcgp
+
+#endif // DCGP_TRACE_H
@@ -0,0 +1,156 @@
+#ifndef DCGP_WORKER_POOL_H
+#define DCGP_WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dcgp
+{
+
+namespace detail
+{
+
+// A pool of threads running the iterations of parallel loops. The threads are started once and wait
+// between the loops, so that loops as short as a generation of an evolutionary strategy can be run in
+// parallel. The calling thread takes part in the loops.
+class worker_pool
+{
+public:
+    // n_threads is the total number of threads, the calling one included (0 selects the number of
+    // hardware threads)
+    explicit worker_pool(unsigned n_threads)
+    {
+        if (n_threads == 0u) {
+            n_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (auto t = 1u; t < n_threads; ++t) {
+            m_threads.emplace_back([this]() { work(); });
+        }
+    }
+
+    ~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    worker_pool(const worker_pool &) = delete;
+    worker_pool &operator=(const worker_pool &) = delete;
+
+    unsigned size() const
+    {
+        return static_cast<unsigned>(m_threads.size()) + 1u;
+    }
+
+    // Calls f(i) for i in [0, n), in parallel. The first exception thrown by f is rethrown, once all the
+    // iterations are done
+    void run(std::size_t n, const std::function<void(std::size_t)> &f)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &f;
+            m_n = n;
+            m_next = 0u;
+            m_error = nullptr;
+            m_busy = static_cast<unsigned>(m_threads.size());
+            ++m_round;
+        }
+        if (!m_threads.empty()) {
+            m_start.notify_all();
+        }
+        execute();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this]() { return m_busy == 0u; });
+        m_task = nullptr;
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+private:
+    void work()
+    {
+        unsigned round = 0u;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_start.wait(lock, [this, round]() { return m_stop || m_round != round; });
+                if (m_stop) {
+                    return;
+                }
+                round = m_round;
+            }
+            execute();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_busy == 0u) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    void execute()
+    {
+        for (auto i = m_next++; i < m_n; i = m_next++) {
+            try {
+                (*m_task)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error) {
+                    m_error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    // The current loop: written under the mutex before the threads are woken up
+    const std::function<void(std::size_t)> *m_task = nullptr;
+    std::size_t m_n = 0u;
+    std::atomic<std::size_t> m_next{0u};
+    std::exception_ptr m_error;
+    unsigned m_busy = 0u;
+    unsigned m_round = 0u;
+    bool m_stop = false;
+};
+
+// Runs a parallel loop on a pool of n_threads threads (0 selects the number of hardware threads) shared by
+// the callers that do not keep their own (e.g. the parallel fitness functions, called once per generation
+// from Python). The pool is created at the first call and recreated only when the number of threads changes.
+// The loops of different threads are serialized, and f must not run loops on the shared pool itself
+inline void run_on_shared_pool(unsigned n_threads, std::size_t n, const std::function<void(std::size_t)> &f)
+{
+    static std::mutex mutex;
+    static std::unique_ptr<worker_pool> pool;
+    if (n_threads == 0u) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pool || pool->size() != n_threads) {
+        pool.reset();
+        pool.reset(new worker_pool(n_threads));
+    }
+    pool->run(n, f);
+}
+
+} // namespace detail
+
+} // end of namespace dcgp
+
+#endif // DCGP_WORKER_POOL_H
@@ -3,9 +3,14 @@
 
 #include <audi/audi.hpp>
 #include <audi/functions.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 
+#include <dcgp/interval.hpp>
 #include <dcgp/type_traits.hpp>
 
 using namespace audi;
@@ -15,9 +20,10 @@ namespace dcgp
 
 // SFINAE dust (to hide under the carpet). Its used to enable the templated
 // version of the various functions that can construct a kernel object. Only for
-// double and a gdual type Complex could also be allowed.
+// double, a gdual type and interval. Complex could also be allowed.
 template <typename T>
-using f_enabler = typename std::enable_if<std::is_same<T, double>::value || is_gdual<T>::value, int>::type;
+using f_enabler = typename std::enable_if<
+    std::is_same<T, double>::value || is_gdual<T>::value || std::is_same<T, interval>::value, int>::type;
 
 // Allows to overload in templates std functions with audi functions
 using namespace audi;
@@ -44,6 +50,19 @@ std::string print_my_sum(const std::vector<std::string> &in)
     return "(" + retval + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_sum_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = in[0][k];
+    }
+    for (auto i = 1u; i < in.size(); ++i) {
+        for (std::size_t k = 0u; k < N; ++k) {
+            out[k] += in[i][k];
+        }
+    }
+}
+
 template <typename T, f_enabler<T> = 0>
 T my_diff(const std::vector<T> &in)
 {
@@ -63,6 +82,19 @@ std::string print_my_diff(const std::vector<std::string> &in)
     return "(" + retval + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_diff_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = in[0][k];
+    }
+    for (auto i = 1u; i < in.size(); ++i) {
+        for (std::size_t k = 0u; k < N; ++k) {
+            out[k] -= in[i][k];
+        }
+    }
+}
+
 template <typename T, f_enabler<T> = 0>
 T my_mul(const std::vector<T> &in)
 {
@@ -82,6 +114,19 @@ std::string print_my_mul(const std::vector<std::string> &in)
     return "(" + retval + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_mul_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = in[0][k];
+    }
+    for (auto i = 1u; i < in.size(); ++i) {
+        for (std::size_t k = 0u; k < N; ++k) {
+            out[k] *= in[i][k];
+        }
+    }
+}
+
 template <typename T, f_enabler<T> = 0>
 T my_div(const std::vector<T> &in)
 {
@@ -101,6 +146,19 @@ std::string print_my_div(const std::vector<std::string> &in)
     return "(" + retval + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_div_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = in[0][k];
+    }
+    for (auto i = 1u; i < in.size(); ++i) {
+        for (std::size_t k = 0u; k < N; ++k) {
+            out[k] /= in[i][k];
+        }
+    }
+}
+
 // sigmoid function: 1 / (1 + exp(- (a + b + c + d+ .. + ))
 template <typename T, f_enabler<T> = 0>
 T my_sig(const std::vector<T> &in)
@@ -121,6 +179,15 @@ std::string print_my_sig(const std::vector<std::string> &in)
     return "sig(" + retval + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_sig_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    my_sum_batch(in, out, N);
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = 1. / (1. + audi::exp(-out[k]));
+    }
+}
+
 /*--------------------------------------------------------------------------
  *                                  BINARY FUNCTIONS
  *------------------------------------------------------------------------**/
@@ -140,6 +207,14 @@ std::string print_my_pdiv(const std::vector<std::string> &in)
     return "(" + in[0] + "/" + in[1] + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_pdiv_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = (in[0][k] == in[1][k]) ? T(1.) : in[0][k] / in[1][k];
+    }
+}
+
 /*--------------------------------------------------------------------------
  *                                  UNARY FUNCTIONS
  *------------------------------------------------------------------------**/
@@ -155,6 +230,14 @@ std::string print_my_sin(const std::vector<std::string> &in)
     return "sin(" + in[0] + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_sin_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = sin(in[0][k]);
+    }
+}
+
 // cosine
 template <typename T, f_enabler<T> = 0>
 T my_cos(const std::vector<T> &in)
@@ -167,6 +250,14 @@ std::string print_my_cos(const std::vector<std::string> &in)
     return "cos(" + in[0] + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_cos_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = cos(in[0][k]);
+    }
+}
+
 // logarithm
 template <typename T, f_enabler<T> = 0>
 T my_log(const std::vector<T> &in)
@@ -179,6 +270,14 @@ std::string print_my_log(const std::vector<std::string> &in)
     return "log(" + in[0] + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_log_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = audi::log(in[0][k]);
+    }
+}
+
 // exponential
 template <typename T, f_enabler<T> = 0>
 T my_exp(const std::vector<T> &in)
@@ -191,6 +290,181 @@ std::string print_my_exp(const std::vector<std::string> &in)
     return "exp(" + in[0] + ")";
 }
 
+template <typename T, f_enabler<T> = 0>
+void my_exp_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = audi::exp(in[0][k]);
+    }
+}
+
+/*--------------------------------------------------------------------------
+ *                            FAST APPROXIMATIONS
+ *------------------------------------------------------------------------**/
+namespace detail
+{
+
+// Exponential of a double with a relative error below 1e-15 (a few ulps). It is 0 for x below -708.05
+// (where exp(x) < 3.2e-308, i.e. the results close to the subnormals are flushed to zero) and inf above
+// 709.78, as exp. NaN propagates. With x = k ln2 + r, |r| <= ln2 / 2, exp(x) = 2^k exp(r): k is rounded
+// by the 1.5 * 2^52 shift, r is computed exactly (Cody-Waite, the high part of ln2 has 32 significant bits)
+// and exp(r) by its Taylor polynomial of degree 12 (truncation error below 3e-16). There are no branches
+// nor calls to libm, so that the loops of the batch kernels vectorize.
+inline double fast_exp(double x)
+{
+    // Clamping to [-1022 ln2, 710] keeps 2^(k - 1) a normal number (or 0, or inf). NOTE: the bounds are
+    // selected via copysign, as constants would let gcc split the loops of the batch kernels in branches
+    const double xl = x < -708.39641853226408 ? std::copysign(708.39641853226408, x) : x;
+    const double xc = xl > 710. ? std::copysign(710., xl) : xl;
+    const double shifter = 6755399441055744.;
+    const double kd = xc * 1.4426950408889634 + shifter;
+    const double k = kd - shifter;
+    const double r = (xc - k * 6.93147180369123816490e-01) - k * 1.90821492927058770002e-10;
+    double p = 1. / 479001600.;
+    p = p * r + 1. / 39916800.;
+    p = p * r + 1. / 3628800.;
+    p = p * r + 1. / 362880.;
+    p = p * r + 1. / 40320.;
+    p = p * r + 1. / 5040.;
+    p = p * r + 1. / 720.;
+    p = p * r + 1. / 120.;
+    p = p * r + 1. / 24.;
+    p = p * r + 1. / 6.;
+    p = p * r + 0.5;
+    p = p * r + 1.;
+    p = p * r + 1.;
+    // The low bits of kd hold k: 2^(k - 1) is built in the exponent field (k - 1 keeps 2^1023 finite)
+    std::uint64_t bits;
+    std::memcpy(&bits, &kd, sizeof(bits));
+    bits = (bits - 0x4338000000000000ull + 1022u) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return (2. * p) * scale;
+}
+
+// gduals and intervals use the exact exponential: their derivatives (bounds) are not the bottleneck
+template <typename T>
+T fast_exp(const T &x)
+{
+    return exp(x);
+}
+
+} // namespace detail
+
+// fast exponential: exp(a), approximated for doubles (see detail::fast_exp())
+template <typename T, f_enabler<T> = 0>
+T my_fast_exp(const std::vector<T> &in)
+{
+    return detail::fast_exp(in[0]);
+}
+
+template <typename T, f_enabler<T> = 0>
+void my_fast_exp_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = detail::fast_exp(in[0][k]);
+    }
+}
+
+// fast sigmoid function: 1 / (1 + exp(- (a + b + c + d+ .. + )), approximated for doubles
+template <typename T, f_enabler<T> = 0>
+T my_fast_sig(const std::vector<T> &in)
+{
+    return 1. / (1. + detail::fast_exp(-my_sum(in)));
+}
+
+template <typename T, f_enabler<T> = 0>
+void my_fast_sig_batch(const std::vector<const T *> &in, T *out, std::size_t N)
+{
+    my_sum_batch(in, out, N);
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = 1. / (1. + detail::fast_exp(-out[k]));
+    }
+}
+
+/*--------------------------------------------------------------------------
+ *                            INTERVAL SPECIALIZATIONS
+ *------------------------------------------------------------------------**/
+// NOTE: audi::exp does not know intervals, hence the specializations of the kernels using it. The sigmoid
+// uses its monotonicity rather than the composition of exp and /, which overflows on wide intervals
+template <>
+inline interval my_sig<interval, 0>(const std::vector<interval> &in)
+{
+    return sig(my_sum(in));
+}
+
+template <>
+inline void my_sig_batch<interval, 0>(const std::vector<const interval *> &in, interval *out, std::size_t N)
+{
+    my_sum_batch(in, out, N);
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = sig(out[k]);
+    }
+}
+
+// The fast sigmoid bounds intervals as the exact one
+template <>
+inline interval my_fast_sig<interval, 0>(const std::vector<interval> &in)
+{
+    return sig(my_sum(in));
+}
+
+template <>
+inline void my_fast_sig_batch<interval, 0>(const std::vector<const interval *> &in, interval *out, std::size_t N)
+{
+    my_sum_batch(in, out, N);
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = sig(out[k]);
+    }
+}
+
+// The protected division is 1 wherever the dividend can equal the divisor
+template <>
+inline interval my_pdiv<interval, 0>(const std::vector<interval> &in)
+{
+    auto retval = in[0] / in[1];
+    if (in[0].is_empty() || in[1].is_empty() || in[0].upper() < in[1].lower() || in[1].upper() < in[0].lower()) {
+        return retval;
+    }
+    return hull(retval, interval(1.));
+}
+
+template <>
+inline void my_pdiv_batch<interval, 0>(const std::vector<const interval *> &in, interval *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = my_pdiv(std::vector<interval>{in[0][k], in[1][k]});
+    }
+}
+
+template <>
+inline interval my_log<interval, 0>(const std::vector<interval> &in)
+{
+    return log(in[0]);
+}
+
+template <>
+inline void my_log_batch<interval, 0>(const std::vector<const interval *> &in, interval *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = log(in[0][k]);
+    }
+}
+
+template <>
+inline interval my_exp<interval, 0>(const std::vector<interval> &in)
+{
+    return exp(in[0]);
+}
+
+template <>
+inline void my_exp_batch<interval, 0>(const std::vector<const interval *> &in, interval *out, std::size_t N)
+{
+    for (std::size_t k = 0u; k < N; ++k) {
+        out[k] = exp(in[0][k]);
+    }
+}
+
 } // namespace dcgp
 
 #endif // DCGP_WRAPPED_FUNCTIONS_H
@@ -0,0 +1,69 @@
+#include <stdexcept>
+#include <string>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_code_generator_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/code_generator.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/kernel_set.hpp>
+
+using namespace dcgp;
+
+BOOST_AUTO_TEST_CASE(generate_c_source_expression)
+{
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+
+    /// Testing over Miller's test case from the PPSN 2014 tutorial
+    expression<double> ex(2, 4, 2, 3, 4, 2, basic_set(), 0u);
+    ex.set({0, 0, 1, 1, 0, 0, 1, 3, 1, 2, 0, 1, 0, 4, 4, 2, 5, 4, 2, 5, 7, 3});
+    auto source = generate_c_source(ex, "my_expression");
+
+    // Only the active nodes are computed
+    BOOST_CHECK(source.find("void my_expression(const double *x, double *y)\n{\n"
+                            "    const double n2 = x[0] + x[1];\n"
+                            "    const double n3 = x[0] - x[0];\n"
+                            "    const double n4 = n3 - x[1];\n"
+                            "    const double n5 = x[0] * x[1];\n"
+                            "    const double n7 = n5 * n4;\n"
+                            "    y[0] = n2;\n"
+                            "    y[1] = n5;\n"
+                            "    y[2] = n7;\n"
+                            "    y[3] = n3;\n}\n")
+                != std::string::npos);
+    BOOST_CHECK(source.find("void my_expression_batch(const double *const *x, double *const *y, size_t N)")
+                != std::string::npos);
+    BOOST_CHECK(source.find("        const double n4 = n3 - x[1][k];\n") != std::string::npos);
+    BOOST_CHECK(source.find("        y[2][k] = n7;\n") != std::string::npos);
+    BOOST_CHECK(source.find("n6") == std::string::npos);
+
+    // Invalid function names
+    BOOST_CHECK_THROW(generate_c_source(ex, ""), std::invalid_argument);
+    BOOST_CHECK_THROW(generate_c_source(ex, "3d"), std::invalid_argument);
+    BOOST_CHECK_THROW(generate_c_source(ex, "my-expression"), std::invalid_argument);
+
+    // Kernels without a C counterpart
+    kernel_set<double> custom_set({"sum"});
+    custom_set.push_back(kernel<double>([](const std::vector<double> &in) { return in[0]; },
+                                        [](const std::vector<std::string> &in) { return in[0]; }, "first"));
+    expression<double> ex2(1, 1, 1, 1, 2, 2, custom_set(), 0u);
+    ex2.set({1, 0, 0, 1});
+    BOOST_CHECK_THROW(generate_c_source(ex2, "f"), std::invalid_argument);
+    // ... unless they are not active
+    ex2.set({1, 0, 0, 0});
+    BOOST_CHECK(generate_c_source(ex2, "f").find("y[0] = x[0];") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(generate_c_source_expression_weighted)
+{
+    kernel_set<double> basic_set({"sum", "pdiv", "sig", "exp"});
+    expression_weighted<double> ex(1, 1, 1, 2, 2, 2, basic_set(), 0u);
+    ex.set({1, 0, 0, 2, 1, 0, 2});
+    ex.set_weights({2., -0.5, 1., 3.});
+    auto source = generate_c_source(ex, "f");
+    BOOST_CHECK(source.find("const double n1 = ((2. * x[0]) == ((-0.5) * x[0])) ? 1. : (2. * x[0]) / ((-0.5) * x[0]);")
+                != std::string::npos);
+    BOOST_CHECK(source.find("const double n2 = 1. / (1. + exp(-((1. * n1) + (3. * x[0]))));") != std::string::npos);
+    BOOST_CHECK(source.find("y[0] = n2;") != std::string::npos);
+}
@@ -1,3 +1,4 @@
+#include <limits>
 #include <random>
 #define BOOST_TEST_MODULE dcgp_compute_test
 #include <boost/test/unit_test.hpp>
@@ -50,3 +51,110 @@ BOOST_AUTO_TEST_CASE(check_bounds)
     CHECK_EQUAL_V(ex.get_ub(), std::vector<unsigned int>(
                                    {3, 2, 2, 2, 3, 2, 2, 2, 3, 4, 4, 4, 3, 4, 4, 4, 3, 6, 6, 6, 3, 6, 6, 6, 8}));
 }
+
+BOOST_AUTO_TEST_CASE(compute_batch)
+{
+    std::default_random_engine re(23);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "pdiv", "sig", "sin", "cos"});
+
+    // The batch evaluation must agree with the point-wise one, also across blocks
+    const unsigned N = 1500u;
+    std::vector<std::vector<double>> in(2, std::vector<double>(N)), out(3, std::vector<double>(N));
+    for (auto &column : in) {
+        for (auto &value : column) {
+            value = std::uniform_real_distribution<double>(-1., 1.)(re);
+        }
+    }
+    std::vector<const double *> in_ptr{in[0].data(), in[1].data()};
+    std::vector<double *> out_ptr{out[0].data(), out[1].data(), out[2].data()};
+    for (auto trial = 0u; trial < 20u; ++trial) {
+        expression<double> ex(2, 3, 2, 8, 4, 3, basic_set(), re());
+        expression_weighted<double> ex_w(2, 3, 2, 8, 4, 3, basic_set(), re());
+        std::vector<double> weights(ex_w.get_weights().size());
+        for (auto &w : weights) {
+            w = std::uniform_real_distribution<double>(-2., 2.)(re);
+        }
+        ex_w.set_weights(weights);
+        ex(in_ptr, out_ptr, N);
+        for (auto k = 0u; k < N; k += 7u) {
+            auto expected = ex({in[0][k], in[1][k]});
+            for (auto i = 0u; i < 3u; ++i) {
+                BOOST_CHECK_CLOSE(out[i][k], expected[i], 1e-10);
+            }
+        }
+        ex_w(in_ptr, out_ptr, N);
+        for (auto k = 0u; k < N; k += 7u) {
+            auto expected = ex_w({in[0][k], in[1][k]});
+            for (auto i = 0u; i < 3u; ++i) {
+                BOOST_CHECK_CLOSE(out[i][k], expected[i], 1e-10);
+            }
+        }
+    }
+    // Sizes are checked
+    expression<double> ex(2, 3, 2, 8, 4, 3, basic_set(), re());
+    BOOST_CHECK_THROW(ex({in[0].data()}, out_ptr, N), std::invalid_argument);
+    BOOST_CHECK_THROW(ex(in_ptr, {out[0].data()}, N), std::invalid_argument);
+    BOOST_CHECK_NO_THROW(ex(in_ptr, out_ptr, 0u));
+}
+
+BOOST_AUTO_TEST_CASE(compute_checked)
+{
+    kernel_set<double> basic_set({"sum", "div"});
+    // x / x + x: node 1 is NaN in x = 0
+    expression<double> ex(1, 1, 1, 2, 2, 2, basic_set(), 0u);
+    ex.set({1, 0, 0, 0, 1, 0, 2});
+    std::vector<double> x(1000u), y(1000u);
+    for (auto k = 0u; k < x.size(); ++k) {
+        x[k] = 1. + k;
+    }
+    unsigned node_id = 42u;
+    BOOST_CHECK(ex.evaluate_checked({x.data()}, {y.data()}, x.size(), node_id));
+    BOOST_CHECK_EQUAL(node_id, 42u);
+    for (auto k = 0u; k < x.size(); ++k) {
+        BOOST_CHECK_EQUAL(y[k], 1. + x[k]);
+    }
+    // A non finite value is reported, also in the second block
+    x[700] = 0.;
+    BOOST_CHECK(!ex.evaluate_checked({x.data()}, {y.data()}, x.size(), node_id));
+    BOOST_CHECK_EQUAL(node_id, 1u);
+    // Non finite inputs are reported as the input node
+    x[700] = std::numeric_limits<double>::infinity();
+    BOOST_CHECK(!ex.evaluate_checked({x.data()}, {y.data()}, x.size(), node_id));
+    BOOST_CHECK_EQUAL(node_id, 0u);
+    // The weighted expression
+    expression_weighted<double> ex_w(1, 1, 1, 2, 2, 2, basic_set(), 0u);
+    ex_w.set({1, 0, 0, 0, 1, 0, 2});
+    x[700] = 1.;
+    BOOST_CHECK(ex_w.evaluate_checked({x.data()}, {y.data()}, x.size(), node_id));
+    ex_w.set_weight(1u, 1u, 0.);
+    BOOST_CHECK(!ex_w.evaluate_checked({x.data()}, {y.data()}, x.size(), node_id));
+    BOOST_CHECK_EQUAL(node_id, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(kernel_arity)
+{
+    kernel_set<double> basic_set({"sum", "sin"});
+    BOOST_CHECK_EQUAL(basic_set()[0].get_arity(), 0u);
+    BOOST_CHECK_EQUAL(basic_set()[1].get_arity(), 1u);
+    // n1 = x0 + x0, n2 = sin(x0) (its second input, n1, is not read), y = n2
+    expression<double> ex(1, 1, 1, 2, 2, 2, basic_set(), 0u);
+    ex.set({0, 0, 0, 1, 0, 1, 2});
+    CHECK_EQUAL_V(ex.get_active_nodes(), std::vector<unsigned>({0, 2}));
+    CHECK_EQUAL_V(ex.get_active_genes(), std::vector<unsigned>({3, 4, 6}));
+    BOOST_CHECK_EQUAL(ex.get_node_arity(1u), 2u);
+    BOOST_CHECK_EQUAL(ex.get_node_arity(2u), 1u);
+    BOOST_CHECK_EQUAL(ex({0.5})[0], std::sin(0.5));
+    BOOST_CHECK_EQUAL(ex({std::string("x")})[0], "sin(x)");
+    std::vector<double> x{0.5, 1.}, y(2u);
+    ex({x.data()}, {y.data()}, 2u);
+    CHECK_EQUAL_V(y, std::vector<double>({std::sin(0.5), std::sin(1.)}));
+    // The unread connection is never mutated by mutate_active_cgene
+    for (auto i = 0u; i < 100u; ++i) {
+        ex.mutate_active_cgene();
+        BOOST_CHECK_EQUAL(ex.get()[5], 1u);
+    }
+    // A kernel cannot read more inputs than the nodes have
+    kernel<double> sum3(my_sum<double>, print_my_sum, "sum3", nullptr, 3u);
+    BOOST_CHECK_THROW(expression<double>(1, 1, 1, 2, 2, 2, {sum3}, 0u), std::invalid_argument);
+    BOOST_CHECK_NO_THROW(expression<double>(1, 1, 1, 2, 2, 3, {sum3}, 0u));
+}
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#define BOOST_TEST_MODULE dcgp_dataset_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/dataset.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/kernel_set.hpp>
+#include <dcgp/racing_fitness.hpp>
+#include <dcgp/streamed_dataset.hpp>
+
+using namespace dcgp;
+
+// Writes content in a temporary file that is removed at destruction
+struct temp_file {
+    temp_file(const std::string &content) : m_name(std::tmpnam(nullptr))
+    {
+        std::ofstream(m_name) << content;
+    }
+    ~temp_file()
+    {
+        std::remove(m_name.c_str());
+    }
+    std::string m_name;
+};
+
+BOOST_AUTO_TEST_CASE(parse_double)
+{
+    for (std::string token :
+         {"0", "-0", "1", "-1.5", "3.14159", "0.1", "1e10", "1.5E-3", "-4.700000", "14400.000000", "0.335533716244",
+          "123456789012345678901234", "1e-300", "4.9e-324", "1.7976931348623157e308", "0.30000000000000004",
+          "9007199254740993", "+2.5", "inf", "-nan"}) {
+        auto expected = std::strtod(token.c_str(), nullptr);
+        auto value = detail::parse_double(token.data(), token.data() + token.size());
+        if (std::isnan(expected)) {
+            BOOST_CHECK(std::isnan(value));
+        } else {
+            BOOST_CHECK_EQUAL(value, expected);
+            BOOST_CHECK_EQUAL(std::signbit(value), std::signbit(expected));
+        }
+    }
+    for (std::string token : {"", "-", "1.2.3", "abc", "1e", "2,5"}) {
+        BOOST_CHECK_THROW(detail::parse_double(token.data(), token.data() + token.size()), std::invalid_argument);
+    }
+    // Random numbers printed with 17 digits round-trip
+    std::default_random_engine re(32);
+    for (auto i = 0u; i < 10000u; ++i) {
+        auto x = std::uniform_real_distribution<double>(-1e5, 1e5)(re);
+        char buffer[64];
+        auto size = std::snprintf(buffer, 64, "%.17g", x);
+        BOOST_CHECK_EQUAL(detail::parse_double(buffer, buffer + size), x);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(construction)
+{
+    dataset empty;
+    BOOST_CHECK_EQUAL(empty.size(), 0u);
+    BOOST_CHECK_EQUAL(empty.get_n(), 0u);
+
+    dataset data({{1., 2.}, {3., 4.}, {5., 6.}}, {{7.}, {8.}, {9.}});
+    BOOST_CHECK_EQUAL(data.get_n(), 2u);
+    BOOST_CHECK_EQUAL(data.get_m(), 1u);
+    BOOST_CHECK_EQUAL(data.size(), 3u);
+    BOOST_CHECK_EQUAL(data.get_input(0)[2], 5.);
+    BOOST_CHECK_EQUAL(data.get_input(1)[0], 2.);
+    BOOST_CHECK_EQUAL(data.get_output(0)[1], 8.);
+    BOOST_CHECK_EQUAL(data.get_inputs().size(), 2u);
+    BOOST_CHECK_EQUAL(data.get_outputs().size(), 1u);
+    for (auto column : {data.get_input(0), data.get_input(1), data.get_output(0)}) {
+        BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(column) % 64u, 0u);
+    }
+    BOOST_CHECK_THROW(dataset({{1.}, {2.}}, {{1.}}), std::invalid_argument);
+    BOOST_CHECK_THROW(dataset({{1.}, {2., 3.}}, {{1.}, {2.}}), std::invalid_argument);
+    BOOST_CHECK_THROW(data.get_input(2), std::out_of_range);
+
+    // From columns
+    const std::vector<double> x0{1., 3., 5.}, x1{2., 4., 6.}, y{7., 8., 9.};
+    dataset columns({x0.data(), x1.data()}, {y.data()}, 3u);
+    BOOST_CHECK_EQUAL(columns.get_n(), 2u);
+    BOOST_CHECK_EQUAL(columns.size(), 3u);
+    for (auto k = 0u; k < 3u; ++k) {
+        BOOST_CHECK_EQUAL(columns.get_input(0)[k], data.get_input(0)[k]);
+        BOOST_CHECK_EQUAL(columns.get_input(1)[k], data.get_input(1)[k]);
+        BOOST_CHECK_EQUAL(columns.get_output(0)[k], data.get_output(0)[k]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(read_csv)
+{
+    // With and without the trailing commas, with windows line endings
+    for (std::string content :
+         {"2,1,3,\n1.,2.,3.,\n4.,5.,6.,\n-7.,8e-1,9.5,\n", "2, 1, 3\r\n1, 2, 3\r\n4, 5, 6\r\n-7, 0.8, 9.5"}) {
+        temp_file file(content);
+        auto data = dataset::read_csv(file.m_name);
+        BOOST_CHECK_EQUAL(data.get_n(), 2u);
+        BOOST_CHECK_EQUAL(data.get_m(), 1u);
+        BOOST_CHECK_EQUAL(data.size(), 3u);
+        BOOST_CHECK_EQUAL(data.get_input(0)[2], -7.);
+        BOOST_CHECK_EQUAL(data.get_input(1)[2], 0.8);
+        BOOST_CHECK_EQUAL(data.get_output(0)[1], 6.);
+    }
+    {
+        temp_file file("2,1,3,\n1.,2.,3.,\n4.,5.,6.,\n");
+        BOOST_CHECK_THROW(dataset::read_csv(file.m_name), std::invalid_argument);
+    }
+    {
+        temp_file file("2,1,1,\n1.,2.,x,\n");
+        BOOST_CHECK_THROW(dataset::read_csv(file.m_name), std::invalid_argument);
+    }
+    {
+        temp_file file("2,-1,1,\n1.,2.,\n");
+        BOOST_CHECK_THROW(dataset::read_csv(file.m_name), std::invalid_argument);
+    }
+    // Header fields out of range, extra values in the header, in a row or at the end
+    for (std::string content : {"2,1,1e20,\n1.,2.,3.,\n", "5e9,1,1,\n1.,2.,3.,\n", "2,1,1.5,\n1.,2.,3.,\n",
+                                "2,1,1,7,\n1.,2.,3.,\n", "2,1,2,\n1.,2.,3.,4.,\n5.,6.,\n",
+                                "2,1,1,\n1.,2.,3.,\n4.,\n"}) {
+        temp_file file(content);
+        BOOST_CHECK_THROW(dataset::read_csv(file.m_name), std::invalid_argument);
+    }
+    BOOST_CHECK_THROW(dataset::read_csv("a_file_that_does_not_exist.data"), std::runtime_error);
+
+    // A large file parsed with many threads gives the same result as a serial parse
+    std::default_random_engine re(32);
+    std::string content("3,2,20000,\n");
+    for (auto i = 0u; i < 20000u * 5u; ++i) {
+        char buffer[64];
+        std::snprintf(buffer, 64, "%.12g,", std::uniform_real_distribution<double>(-10., 10.)(re));
+        content += buffer;
+        if (i % 5u == 4u) {
+            content += "\n";
+        }
+    }
+    temp_file file(content);
+    auto serial = dataset::read_csv(file.m_name, 1u);
+    auto parallel = dataset::read_csv(file.m_name, 7u);
+    BOOST_CHECK_EQUAL(serial.size(), 20000u);
+    BOOST_CHECK_EQUAL(parallel.size(), 20000u);
+    for (auto k = 0u; k < 20000u; ++k) {
+        for (auto j = 0u; j < 3u; ++j) {
+            BOOST_CHECK_EQUAL(serial.get_input(j)[k], parallel.get_input(j)[k]);
+        }
+        for (auto i = 0u; i < 2u; ++i) {
+            BOOST_CHECK_EQUAL(serial.get_output(i)[k], parallel.get_output(i)[k]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(quadratic_error_on_dataset)
+{
+    std::default_random_engine re(23);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 5000u; ++i) {
+        auto x = std::uniform_real_distribution<double>(-1., 1.)(re);
+        auto y = std::uniform_real_distribution<double>(-1., 1.)(re);
+        in.push_back({x, y});
+        out.push_back({x * y, x - y});
+    }
+    dataset data(in, out);
+    for (auto trial = 0u; trial < 10u; ++trial) {
+        expression<double> ex(2, 2, 2, 6, 7, 2, basic_set(), re());
+        BOOST_CHECK_CLOSE(quadratic_error(ex, data), quadratic_error(ex, in, out), 1e-8);
+    }
+    expression<double> ex(1, 2, 2, 6, 7, 2, basic_set(), re());
+    BOOST_CHECK_THROW(quadratic_error(ex, data), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(binary_format)
+{
+    std::default_random_engine re(32);
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 1001u; ++i) {
+        in.push_back({std::uniform_real_distribution<double>(-10., 10.)(re), static_cast<double>(i)});
+        out.push_back({std::uniform_real_distribution<double>(-10., 10.)(re)});
+    }
+    dataset data(in, out);
+    temp_file file("");
+    // Double precision is exact and used in place
+    data.save_binary(file.m_name);
+    {
+        auto loaded = dataset::load_binary(file.m_name);
+        BOOST_CHECK_EQUAL(loaded.get_n(), 2u);
+        BOOST_CHECK_EQUAL(loaded.get_m(), 1u);
+        BOOST_CHECK_EQUAL(loaded.size(), 1001u);
+        for (auto k = 0u; k < 1001u; ++k) {
+            BOOST_CHECK_EQUAL(loaded.get_input(0)[k], in[k][0]);
+            BOOST_CHECK_EQUAL(loaded.get_input(1)[k], in[k][1]);
+            BOOST_CHECK_EQUAL(loaded.get_output(0)[k], out[k][0]);
+        }
+        for (auto column : {loaded.get_input(0), loaded.get_input(1), loaded.get_output(0)}) {
+            BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(column) % 64u, 0u);
+        }
+        // The mapping outlives the loaded dataset through its copies
+        auto copy = loaded;
+        loaded = dataset();
+        BOOST_CHECK_EQUAL(copy.get_output(0)[1000], out[1000][0]);
+    }
+    // Single precision rounds
+    data.save_binary(file.m_name, true);
+    {
+        auto loaded = dataset::load_binary(file.m_name);
+        BOOST_CHECK_EQUAL(loaded.size(), 1001u);
+        for (auto k = 0u; k < 1001u; ++k) {
+            BOOST_CHECK_EQUAL(loaded.get_input(0)[k], static_cast<double>(static_cast<float>(in[k][0])));
+            BOOST_CHECK_EQUAL(loaded.get_output(0)[k], static_cast<double>(static_cast<float>(out[k][0])));
+        }
+    }
+    // An empty dataset
+    dataset({}, {}).save_binary(file.m_name);
+    BOOST_CHECK_EQUAL(dataset::load_binary(file.m_name).size(), 0u);
+    // Invalid files
+    {
+        temp_file csv("1,1,1,\n1.,2.,\n");
+        BOOST_CHECK_THROW(dataset::load_binary(csv.m_name), std::invalid_argument);
+    }
+    data.save_binary(file.m_name);
+    {
+        std::ifstream full(file.m_name, std::ios::binary);
+        std::string content((std::istreambuf_iterator<char>(full)), std::istreambuf_iterator<char>());
+        temp_file truncated(content.substr(0u, content.size() - 8u));
+        BOOST_CHECK_THROW(dataset::load_binary(truncated.m_name), std::invalid_argument);
+        content[12] = 2;
+        temp_file other_version(content);
+        BOOST_CHECK_THROW(dataset::load_binary(other_version.m_name), std::invalid_argument);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(streamed)
+{
+    std::default_random_engine re(23);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 5000u; ++i) {
+        auto x = std::uniform_real_distribution<double>(-1., 1.)(re);
+        auto y = std::uniform_real_distribution<double>(-1., 1.)(re);
+        in.push_back({x, y});
+        out.push_back({x * y, x - y});
+    }
+    dataset data(in, out);
+    temp_file file("");
+    data.save_binary(file.m_name);
+    for (auto chunk_size : {1u, 7u, 1000u, 4999u, 5000u, 100000u}) {
+        streamed_dataset streamed(file.m_name, chunk_size);
+        BOOST_CHECK_EQUAL(streamed.get_n(), 2u);
+        BOOST_CHECK_EQUAL(streamed.get_m(), 2u);
+        BOOST_CHECK_EQUAL(streamed.size(), 5000u);
+        // The chunks cover the dataset in order
+        std::size_t next = 0u;
+        streamed.for_each_chunk([&](const dataset &chunk) {
+            BOOST_CHECK(chunk.size() <= chunk_size);
+            BOOST_CHECK(chunk.size() > 0u);
+            for (std::size_t k = 0u; k < chunk.size(); ++k) {
+                if (chunk.get_input(1)[k] != in[next + k][1] || chunk.get_output(0)[k] != out[next + k][0]) {
+                    BOOST_ERROR("wrong data in chunk");
+                }
+            }
+            next += chunk.size();
+            return true;
+        });
+        BOOST_CHECK_EQUAL(next, 5000u);
+        // Returning false stops the reading
+        auto calls = 0u;
+        streamed.for_each_chunk([&calls](const dataset &) { return ++calls < 2u; });
+        BOOST_CHECK_EQUAL(calls, std::min(2u, (5000u + chunk_size - 1u) / chunk_size));
+    }
+    streamed_dataset streamed(file.m_name, 1024u);
+    for (auto trial = 0u; trial < 10u; ++trial) {
+        expression<double> ex(2, 2, 2, 6, 7, 2, basic_set(), re());
+        BOOST_CHECK_CLOSE(quadratic_error(ex, streamed), quadratic_error(ex, data), 1e-8);
+    }
+    // Exceptions thrown while processing a chunk propagate
+    BOOST_CHECK_THROW(streamed.for_each_chunk([](const dataset &) -> bool { throw std::logic_error("stop"); }),
+                      std::logic_error);
+    // Single precision
+    data.save_binary(file.m_name, true);
+    streamed_dataset streamed32(file.m_name, 999u);
+    double sum = 0.;
+    streamed32.for_each_chunk([&sum](const dataset &chunk) {
+        for (std::size_t k = 0u; k < chunk.size(); ++k) {
+            sum += chunk.get_input(0)[k];
+        }
+        return true;
+    });
+    double expected = 0.;
+    for (auto &point : in) {
+        expected += static_cast<float>(point[0]);
+    }
+    BOOST_CHECK_CLOSE(sum, expected, 1e-10);
+    // Invalid files
+    BOOST_CHECK_THROW(streamed_dataset("a_file_that_does_not_exist.dcgpd"), std::runtime_error);
+    BOOST_CHECK_THROW(streamed_dataset(file.m_name, 0u), std::invalid_argument);
+    temp_file csv("1,1,1,\n1.,2.,\n");
+    BOOST_CHECK_THROW(streamed_dataset(csv.m_name), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(subset)
+{
+    dataset data({{1., 2.}, {3., 4.}, {5., 6.}}, {{7.}, {8.}, {9.}});
+    auto sub = data.subset({2u, 0u, 2u});
+    BOOST_CHECK_EQUAL(sub.size(), 3u);
+    BOOST_CHECK_EQUAL(sub.get_input(0)[0], 5.);
+    BOOST_CHECK_EQUAL(sub.get_input(1)[1], 2.);
+    BOOST_CHECK_EQUAL(sub.get_output(0)[2], 9.);
+    BOOST_CHECK_EQUAL(data.subset({}).size(), 0u);
+    BOOST_CHECK_THROW(data.subset({3u}), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(racing)
+{
+    std::default_random_engine re(23);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 20000u; ++i) {
+        auto x = std::uniform_real_distribution<double>(-1., 1.)(re);
+        auto y = std::uniform_real_distribution<double>(-1., 1.)(re);
+        in.push_back({x, y});
+        out.push_back({x * y + x});
+    }
+    dataset data(in, out);
+    racing_fitness racing(data, 500u, 2., 32u);
+    std::vector<expression<double>> candidates;
+    for (auto i = 0u; i < 20u; ++i) {
+        candidates.emplace_back(2, 1, 2, 6, 7, 2, basic_set(), re());
+    }
+    // The exact solution x * y + x must win the race
+    auto chromosome = candidates[0].get();
+    chromosome[0] = 2u; // node 2 = x * y
+    chromosome[1] = 0u;
+    chromosome[2] = 1u;
+    chromosome[6] = 0u; // node 4 = node 2 + x
+    chromosome[7] = 2u;
+    chromosome[8] = 0u;
+    chromosome.back() = 4u;
+    candidates[0].set(chromosome);
+    auto fitness = racing(candidates);
+    BOOST_CHECK_EQUAL(fitness.size(), 20u);
+    auto best = std::min_element(fitness.begin(), fitness.end());
+    BOOST_CHECK_EQUAL(best - fitness.begin(), 0);
+    BOOST_CHECK_SMALL(*best, 1e-12);
+    // Survivors get the exact error, all the others are dropped
+    for (auto i = 0u; i < 20u; ++i) {
+        if (std::isfinite(fitness[i])) {
+            BOOST_CHECK_CLOSE(fitness[i], quadratic_error(candidates[i], data), 1e-8);
+        } else {
+            BOOST_CHECK(quadratic_error(candidates[i], data) > *best);
+        }
+    }
+    BOOST_CHECK(racing.get_saved_evaluations() > 0u);
+    BOOST_CHECK_EQUAL(racing.get_evaluations() + racing.get_saved_evaluations(), 20u * 20000u);
+    // With a cutoff, candidates are also compared to it
+    candidates.erase(candidates.begin());
+    const auto saved = racing.get_saved_evaluations();
+    fitness = racing(candidates, 1e-3);
+    for (auto i = 0u; i < fitness.size(); ++i) {
+        BOOST_CHECK(std::isinf(fitness[i])
+                    || std::abs(fitness[i] - quadratic_error(candidates[i], data)) <= 1e-8 * fitness[i]);
+    }
+    BOOST_CHECK(racing.get_saved_evaluations() > saved);
+    // With a single candidate and no cutoff it is an ordinary (shuffled) evaluation
+    fitness = racing(std::vector<expression<double>>{candidates[3]});
+    BOOST_CHECK_CLOSE(fitness[0], quadratic_error(candidates[3], data), 1e-8);
+
+    BOOST_CHECK_THROW(racing_fitness(data, 0u), std::invalid_argument);
+    BOOST_CHECK_THROW(racing_fitness(data, 10u, -1.), std::invalid_argument);
+    BOOST_CHECK_THROW(racing(std::vector<expression<double>>{expression<double>(1, 1, 2, 6, 7, 2, basic_set(), 0u)}),
+                      std::invalid_argument);
+}
@@ -0,0 +1,113 @@
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_differential_fitness_test
+#include <boost/test/unit_test.hpp>
+
+#include <audi/audi.hpp>
+
+#include <dcgp/differential_fitness.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/kernel_set.hpp>
+
+using namespace dcgp;
+
+BOOST_AUTO_TEST_CASE(grid_inputs_test)
+{
+    auto in = grid_inputs({{1., 2., 3.}, {4., 5., 6.}}, {"x", "y"}, 1u);
+    BOOST_CHECK_EQUAL(in.size(), 2u);
+    BOOST_CHECK_EQUAL(in[1].constant_cf()[2], 6.);
+    // Sizes not matching
+    BOOST_CHECK_THROW(grid_inputs({{1., 2.}}, {"x", "y"}, 1u), std::invalid_argument);
+    BOOST_CHECK_THROW(grid_inputs({{1., 2.}, {1.}}, {"x", "y"}, 1u), std::invalid_argument);
+    BOOST_CHECK_THROW(grid_inputs({}, {}, 1u), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(derivative_values_test)
+{
+    auto in = grid_inputs({{1., 2., 3.}}, {"x"}, 1u);
+    // y = x * x + x
+    auto y = in[0] * in[0] + in[0];
+    BOOST_CHECK(derivative_values(y, {}, 3u) == std::vector<double>({2., 6., 12.}));
+    BOOST_CHECK(derivative_values(y, {{"dx", 1u}}, 3u) == std::vector<double>({3., 5., 7.}));
+    // The derivative of a linear expression is the same in all the points
+    BOOST_CHECK(derivative_values(in[0] + in[0], {{"dx", 1u}}, 3u) == std::vector<double>({2., 2., 2.}));
+    BOOST_CHECK_THROW(derivative_values(y, {}, 4u), std::invalid_argument);
+}
+
+// The grid evaluation must give the same fitness as the evaluation point by point with gdual_d
+BOOST_AUTO_TEST_CASE(differential_error_test)
+{
+    kernel_set<gdual_v> set_v({"sum", "diff", "mul", "div", "exp"});
+    kernel_set<gdual_d> set_d({"sum", "diff", "mul", "div", "exp"});
+    std::vector<double> x;
+    for (auto k = 0u; k < 10u; ++k) {
+        x.push_back(0.1 + 0.1 * k);
+    }
+    auto in = grid_inputs({x}, {"x"}, 1u);
+    // Residual of y' = (2x - y) / x (Tsoulos and Lagaris ODE1)
+    auto residual = [&x](std::size_t k, const std::vector<double> &d) { return d[1] - (2. * x[k] - d[0]) / x[k]; };
+    for (auto seed = 0u; seed < 20u; ++seed) {
+        expression<gdual_v> ex_v(1, 1, 1, 15, 16, 2, set_v(), seed);
+        expression<gdual_d> ex_d(1, 1, 1, 15, 16, 2, set_d(), seed);
+        double expected = 0.;
+        for (auto k = 0u; k < x.size(); ++k) {
+            auto T = ex_d({gdual_d(x[k], "x", 1u)});
+            auto err = residual(k, {T[0].constant_cf(), T[0].get_derivative({{"dx", 1u}})});
+            expected += err * err;
+        }
+        expected /= static_cast<double>(x.size());
+        auto err = differential_error(ex_v, in, {{0u, {}}, {0u, {{"dx", 1u}}}}, residual);
+        if (std::isfinite(expected)) {
+            BOOST_CHECK_CLOSE(err, expected, 1e-10);
+        } else {
+            BOOST_CHECK(!std::isfinite(err));
+        }
+    }
+    expression<gdual_v> ex(1, 1, 1, 15, 16, 2, set_v(), 0u);
+    BOOST_CHECK_THROW(differential_error(ex, in, {{1u, {}}}, residual), std::invalid_argument);
+    BOOST_CHECK_THROW(differential_error(ex, {}, {{0u, {}}}, residual), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(derivative_index_test)
+{
+    kernel_set<gdual_d> basic_set({"sum", "diff", "mul", "div"});
+    derivative_index idx({"p", "q"}, {{0u, {}}, {0u, {{"dp", 1u}}}, {0u, {{"dq", 1u}}}, {1u, {{"dq", 1u}}}});
+    BOOST_CHECK_EQUAL(idx.size(), 4u);
+    std::vector<double> d(idx.size());
+    for (auto seed = 0u; seed < 20u; ++seed) {
+        expression<gdual_d> ex(2, 2, 2, 5, 6, 2, basic_set(), seed);
+        for (auto k = 0u; k < 5u; ++k) {
+            auto T = ex({gdual_d(0.5 + k, "p", 1u), gdual_d(1. + 0.1 * k, "q", 1u)});
+            idx(T, d.data());
+            // The outputs not depending on p or q lack their symbols: the lookup by name returns zero
+            std::vector<double> expected{T[0].constant_cf(), T[0].get_derivative({{"dp", 1u}}),
+                                         T[0].get_derivative({{"dq", 1u}}), T[1].get_derivative({{"dq", 1u}})};
+            for (auto i = 0u; i < expected.size(); ++i) {
+                if (std::isfinite(expected[i])) {
+                    BOOST_CHECK_EQUAL(d[i], expected[i]);
+                }
+            }
+        }
+    }
+    // Unknown or repeated symbols
+    BOOST_CHECK_THROW(derivative_index({"p", "q"}, {{0u, {{"dx", 1u}}}}), std::invalid_argument);
+    BOOST_CHECK_THROW(derivative_index({"p", "p"}, {}), std::invalid_argument);
+    // Missing outputs or symbols
+    expression<gdual_d> ex(2, 1, 2, 5, 6, 2, basic_set(), 0u);
+    BOOST_CHECK_THROW(idx(ex({gdual_d(1., "p", 1u), gdual_d(1., "q", 1u)}), d.data()), std::invalid_argument);
+    derivative_index idx_p({"p"}, {{0u, {{"dp", 1u}}}});
+    expression<gdual_d> ex_sum(2, 1, 1, 1, 2, 2, basic_set(), 0u);
+    ex_sum.set({0, 0, 1, 2});
+    BOOST_CHECK_THROW(idx_p(ex_sum({gdual_d(1., "p", 1u), gdual_d(1., "q", 1u)}), d.data()), std::invalid_argument);
+    // An output lacking a symbol: its derivatives w.r.t. the others are found, those w.r.t. it are zero
+    derivative_index idx_missing({"p", "q"}, {{0u, {}}, {0u, {{"dp", 1u}}}, {0u, {{"dq", 1u}}}});
+    idx_missing(ex_sum({gdual_d(1., "p", 1u), gdual_d(2.)}), d.data());
+    BOOST_CHECK_EQUAL(d[0], 3.);
+    BOOST_CHECK_EQUAL(d[1], 1.);
+    BOOST_CHECK_EQUAL(d[2], 0.);
+    // As many symbols as the index, but not the same ones
+    derivative_index idx_pq({"p", "q"}, {{0u, {{"dq", 1u}}}});
+    BOOST_CHECK_THROW(idx_pq(ex_sum({gdual_d(1., "p", 1u), gdual_d(1., "z", 1u)}), d.data()), std::invalid_argument);
+    BOOST_CHECK_THROW(idx_pq(ex_sum({gdual_d(1., "a", 1u), gdual_d(1., "b", 1u)}), d.data()), std::invalid_argument);
+}
@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_evolve_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/dataset.hpp>
+#include <dcgp/evolve.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/kernel_set.hpp>
+#include <dcgp/worker_pool.hpp>
+
+using namespace dcgp;
+
+// y = x^3 + x on [-1, 1]
+dataset cubic()
+{
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 20u; ++i) {
+        const double x = -1. + 2. * i / 19.;
+        in.push_back({x});
+        out.push_back({x * x * x + x});
+    }
+    return dataset(in, out);
+}
+
+BOOST_AUTO_TEST_CASE(worker_pool_test)
+{
+    for (auto n_threads : {1u, 4u}) {
+        detail::worker_pool pool(n_threads);
+        BOOST_CHECK_EQUAL(pool.size(), n_threads);
+        // Many short loops, as in an evolutionary strategy
+        for (auto round = 0u; round < 100u; ++round) {
+            std::vector<int> done(37u, 0);
+            pool.run(done.size(), [&done](std::size_t i) { ++done[i]; });
+            for (auto d : done) {
+                BOOST_CHECK_EQUAL(d, 1);
+            }
+        }
+        // The iterations all run, then the error is rethrown
+        std::atomic<unsigned> count(0u);
+        BOOST_CHECK_THROW(pool.run(10u,
+                                   [&count](std::size_t i) {
+                                       ++count;
+                                       if (i == 3u) {
+                                           throw std::runtime_error("error");
+                                       }
+                                   }),
+                          std::runtime_error);
+        BOOST_CHECK_EQUAL(count, 10u);
+        pool.run(0u, [](std::size_t) { throw std::runtime_error("error"); });
+    }
+    // The shared pool is reused across the calls, and recreated when the number of threads changes
+    for (auto n_threads : {2u, 2u, 3u, 0u}) {
+        std::vector<int> done(37u, 0);
+        detail::run_on_shared_pool(n_threads, done.size(), [&done](std::size_t i) { ++done[i]; });
+        for (auto d : done) {
+            BOOST_CHECK_EQUAL(d, 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_quadratic_error)
+{
+    kernel_set<double> ks({"sum", "diff", "mul", "div"});
+    const auto data = cubic();
+    std::vector<expression<double>> exs;
+    for (auto seed = 0u; seed < 10u; ++seed) {
+        exs.emplace_back(1u, 1u, 1u, 15u, 16u, 2u, ks(), seed);
+    }
+    for (auto n_threads : {0u, 1u, 3u, 20u}) {
+        const auto errors = quadratic_error(exs, data, 1., n_threads);
+        BOOST_CHECK_EQUAL(errors.size(), exs.size());
+        for (decltype(exs.size()) i = 0u; i < exs.size(); ++i) {
+            const auto expected = quadratic_error(exs[i], data, 1.);
+            BOOST_CHECK((std::isnan(expected) && std::isnan(errors[i])) || errors[i] == expected);
+        }
+    }
+    BOOST_CHECK(quadratic_error(std::vector<expression<double>>{}, data, 1., 0u).empty());
+}
+
+BOOST_AUTO_TEST_CASE(evolve_test)
+{
+    kernel_set<double> ks({"sum", "diff", "mul", "div"});
+    const auto data = cubic();
+    es_options opts;
+    opts.max_generations = 20000u;
+    opts.target = 1e-12;
+    expression<double> ex(1u, 1u, 1u, 15u, 16u, 2u, ks(), 123u);
+    const auto initial = quadratic_error(ex, data);
+    auto result = evolve(ex, data, opts);
+    BOOST_CHECK(result.generations > 0u);
+    BOOST_CHECK(result.fitness <= initial || std::isnan(initial));
+    // The expression has the best chromosome
+    BOOST_CHECK_EQUAL(quadratic_error(ex, data), result.fitness);
+    BOOST_CHECK(result.fitness <= opts.target || result.generations == opts.max_generations);
+
+    // The evolution does not depend on the number of threads
+    std::vector<std::vector<unsigned>> chromosomes;
+    for (auto n_threads : {1u, 2u, 4u}) {
+        expression<double> ex2(1u, 1u, 1u, 15u, 16u, 2u, ks(), 321u);
+        opts.threads = n_threads;
+        opts.max_generations = 200u;
+        opts.target = 0.;
+        evolve(ex2, data, opts);
+        chromosomes.push_back(ex2.get());
+    }
+    BOOST_CHECK(chromosomes[0] == chromosomes[1]);
+    BOOST_CHECK(chromosomes[0] == chromosomes[2]);
+
+    // Weighted expressions
+    expression_weighted<double> exw(1u, 1u, 1u, 15u, 16u, 2u, ks(), 123u);
+    result = evolve(exw, data, opts);
+    BOOST_CHECK_EQUAL(quadratic_error(exw, data), result.fitness);
+
+    // The callback stops the evolution
+    expression<double> ex3(1u, 1u, 1u, 15u, 16u, 2u, ks(), 123u);
+    std::vector<unsigned> generations;
+    const auto fitness
+        = [&data](const expression<double> &e, double cutoff) { return quadratic_error(e, data, cutoff); };
+    result = evolve(ex3, fitness, opts, [&generations](unsigned gen, double) {
+        generations.push_back(gen);
+        return gen < 5u;
+    });
+    BOOST_CHECK_EQUAL(result.generations, 5u);
+    BOOST_CHECK((generations == std::vector<unsigned>{1u, 2u, 3u, 4u, 5u}));
+
+    // Errors in the fitness are propagated and leave the best chromosome
+    const auto chromosome = ex3.get();
+    BOOST_CHECK_THROW(evolve(ex3, [](const expression<double> &, double) -> double { throw std::runtime_error(""); },
+                             opts),
+                      std::runtime_error);
+    BOOST_CHECK(ex3.get() == chromosome);
+    opts.offspring = 0u;
+    BOOST_CHECK_THROW(evolve(ex3, data, opts), std::invalid_argument);
+}
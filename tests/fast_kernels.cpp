@@ -0,0 +1,130 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_fast_kernels_test
+#include <boost/test/unit_test.hpp>
+
+#include <audi/audi.hpp>
+
+#include <dcgp/bounds.hpp>
+#include <dcgp/exact_kernels.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/interval.hpp>
+#include <dcgp/kernel_set.hpp>
+#include <dcgp/wrapped_functions.hpp>
+
+using namespace dcgp;
+
+BOOST_AUTO_TEST_CASE(fast_exp_test)
+{
+    // The documented error bound, over the whole range and where most arguments are
+    std::default_random_engine re(123u);
+    for (auto i = 0u; i < 100000u; ++i) {
+        const auto x = std::uniform_real_distribution<double>(-708., 709.78)(re);
+        const auto y = std::uniform_real_distribution<double>(-10., 10.)(re);
+        BOOST_CHECK_SMALL(detail::fast_exp(x) / std::exp(x) - 1., 1e-15);
+        BOOST_CHECK_SMALL(detail::fast_exp(y) / std::exp(y) - 1., 1e-15);
+    }
+    BOOST_CHECK_EQUAL(detail::fast_exp(0.), 1.);
+    // Overflow, underflow and special values
+    const auto inf = std::numeric_limits<double>::infinity();
+    BOOST_CHECK(std::isfinite(detail::fast_exp(709.78)));
+    BOOST_CHECK_EQUAL(detail::fast_exp(709.79), inf);
+    BOOST_CHECK_EQUAL(detail::fast_exp(1e300), inf);
+    BOOST_CHECK_EQUAL(detail::fast_exp(inf), inf);
+    BOOST_CHECK_GT(detail::fast_exp(-708.), 0.);
+    BOOST_CHECK_EQUAL(detail::fast_exp(-709.), 0.);
+    BOOST_CHECK_EQUAL(detail::fast_exp(-1e300), 0.);
+    BOOST_CHECK_EQUAL(detail::fast_exp(-inf), 0.);
+    BOOST_CHECK(std::isnan(detail::fast_exp(std::nan(""))));
+}
+
+BOOST_AUTO_TEST_CASE(fast_kernels_test)
+{
+    kernel_set<double> fast_set({"fast_sig", "fast_exp"});
+    kernel_set<double> exact_set({"sig", "exp"});
+    BOOST_CHECK_EQUAL(fast_set[0].get_arity(), exact_set[0].get_arity());
+    BOOST_CHECK_EQUAL(fast_set[1].get_arity(), exact_set[1].get_arity());
+    const std::vector<std::string> symbols = {"x", "y"};
+    BOOST_CHECK_EQUAL(fast_set[0](symbols), exact_set[0](symbols));
+    BOOST_CHECK_EQUAL(fast_set[1](symbols), exact_set[1](symbols));
+    // Point and batch evaluations
+    std::vector<double> x = {-800., -3., -0.5, 0., 0.1, 2., 30., 800.}, y = {1., 2., -0.3, 0., 0.2, -1., 4., 5.};
+    std::vector<double> out(x.size());
+    for (auto i = 0u; i < 2u; ++i) {
+        fast_set[i]({x.data(), y.data()}, out.data(), x.size());
+        for (auto k = 0u; k < x.size(); ++k) {
+            const auto expected = exact_set[i]({x[k], y[k]});
+            if (std::isfinite(expected)) {
+                BOOST_CHECK_CLOSE(fast_set[i]({x[k], y[k]}), expected, 1e-12);
+                BOOST_CHECK_CLOSE(out[k], expected, 1e-12);
+            } else {
+                BOOST_CHECK_EQUAL(fast_set[i]({x[k], y[k]}), expected);
+                BOOST_CHECK_EQUAL(out[k], expected);
+            }
+        }
+    }
+    // gduals and intervals are computed exactly
+    kernel_set<gdual_d> fast_set_d({"fast_sig", "fast_exp"});
+    kernel_set<gdual_d> exact_set_d({"sig", "exp"});
+    gdual_d a(0.3, "x", 2u), b(-1.2, "y", 2u);
+    BOOST_CHECK(fast_set_d[0]({a, b}) == exact_set_d[0]({a, b}));
+    BOOST_CHECK(fast_set_d[1]({a}) == exact_set_d[1]({a}));
+    kernel_set<interval> fast_set_i({"fast_sig", "fast_exp"});
+    kernel_set<interval> exact_set_i({"sig", "exp"});
+    interval c(-1., 2.), d(0.5, 3.);
+    BOOST_CHECK_EQUAL(fast_set_i[0]({c, d}).lower(), exact_set_i[0]({c, d}).lower());
+    BOOST_CHECK_EQUAL(fast_set_i[0]({c, d}).upper(), exact_set_i[0]({c, d}).upper());
+    BOOST_CHECK_EQUAL(fast_set_i[1]({c}).lower(), exact_set_i[1]({c}).lower());
+    BOOST_CHECK_EQUAL(fast_set_i[1]({c}).upper(), exact_set_i[1]({c}).upper());
+    // The fast sigmoid stays finite where the exponential overflows, pointwise and in batches
+    interval wide(-1000., 1000.);
+    BOOST_CHECK(fast_set_i[0]({wide}).is_finite());
+    std::vector<interval> wide_column{wide}, out_i(1u);
+    fast_set_i[0]({wide_column.data()}, out_i.data(), 1u);
+    BOOST_CHECK(out_i[0].is_finite());
+    BOOST_CHECK(out_i[0].lower() >= 0. && out_i[0].upper() <= 1.);
+    // and so do the bounds of an expression using it
+    kernel_set<double> sig_set({"fast_sig"});
+    expression<double> ex(1, 1, 1, 1, 1, 2, sig_set(), 0u);
+    ex.set({0, 0, 0, 1});
+    auto bounds = output_bounds(ex, {wide});
+    BOOST_CHECK(bounds[0].is_finite());
+    BOOST_CHECK(bounds[0].lower() >= 0. && bounds[0].upper() <= 1.);
+}
+
+BOOST_AUTO_TEST_CASE(with_exact_kernels_test)
+{
+    kernel_set<double> fast_set({"sum", "mul", "fast_sig", "fast_exp"});
+    kernel_set<double> exact_set({"sum", "mul", "sig", "exp"});
+    auto f = exact_kernels(fast_set());
+    for (auto i = 0u; i < f.size(); ++i) {
+        BOOST_CHECK_EQUAL(f[i].get_name(), exact_set[i].get_name());
+    }
+    for (auto seed = 0u; seed < 20u; ++seed) {
+        expression<double> ex(3, 2, 2, 10, 11, 2, fast_set(), seed);
+        expression<double> ex_exact(3, 2, 2, 10, 11, 2, exact_set(), seed);
+        auto ex_rescored = with_exact_kernels(ex);
+        BOOST_CHECK(ex_rescored.get() == ex.get());
+        BOOST_CHECK(ex_rescored({0.1, -0.2, 0.3}) == ex_exact({0.1, -0.2, 0.3}));
+        // The mutations continue as in the original expression
+        ex.mutate_active(3u);
+        ex_rescored.mutate_active(3u);
+        BOOST_CHECK(ex_rescored.get() == ex.get());
+        // Weighted expressions keep their weights
+        expression_weighted<double> exw(3, 2, 2, 10, 11, 2, fast_set(), seed);
+        expression_weighted<double> exw_exact(3, 2, 2, 10, 11, 2, exact_set(), seed);
+        std::vector<double> weights(exw.get_weights().size());
+        for (auto i = 0u; i < weights.size(); ++i) {
+            weights[i] = 0.1 * i - 1.;
+        }
+        exw.set_weights(weights);
+        exw_exact.set_weights(weights);
+        auto exw_rescored = with_exact_kernels(exw);
+        BOOST_CHECK(exw_rescored.get_weights() == weights);
+        BOOST_CHECK(exw_rescored({0.1, -0.2, 0.3}) == exw_exact({0.1, -0.2, 0.3}));
+    }
+}
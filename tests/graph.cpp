@@ -0,0 +1,85 @@
+#include <map>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_graph_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/graph.hpp>
+#include <dcgp/kernel_set.hpp>
+
+#include "helpers.hpp"
+
+using namespace dcgp;
+
+// Evaluates the graph of ex in the point x
+template <typename Expr>
+std::vector<double> evaluate_graph(const Expr &ex, const expression_graph &graph, const std::vector<double> &x)
+{
+    std::map<unsigned, double> values;
+    for (auto j = 0u; j < graph.n; ++j) {
+        values[j] = x[j];
+    }
+    for (auto i = 0u; i < graph.nodes.size(); ++i) {
+        std::vector<double> in;
+        for (auto j = 0u; j < graph.arities[i]; ++j) {
+            const auto w = graph.weights.empty() ? 1. : graph.weights[i * graph.arity + j];
+            in.push_back(w * values.at(graph.inputs[i * graph.arity + j]));
+        }
+        values[graph.nodes[i]] = ex.get_f()[graph.kernels[i]](in);
+    }
+    std::vector<double> retval;
+    for (auto o : graph.outputs) {
+        retval.push_back(values.at(o));
+    }
+    return retval;
+}
+
+BOOST_AUTO_TEST_CASE(active_graph_test)
+{
+    kernel_set<double> basic_set({"sum", "mul"});
+    expression<double> ex(2, 1, 1, 3, 3, 2, basic_set(), 0u);
+    // n2 = x0 + x1, n3 = n2 * n2, n4 = x0 + x0 (inactive), y = n3
+    ex.set({0, 0, 1, 1, 2, 2, 0, 0, 0, 3});
+    auto graph = active_graph(ex);
+    BOOST_CHECK_EQUAL(graph.n, 2u);
+    BOOST_CHECK_EQUAL(graph.arity, 2u);
+    CHECK_EQUAL_V(graph.nodes, std::vector<unsigned>({2, 3}));
+    CHECK_EQUAL_V(graph.kernels, std::vector<unsigned>({0, 1}));
+    CHECK_EQUAL_V(graph.arities, std::vector<unsigned>({2, 2}));
+    CHECK_EQUAL_V(graph.inputs, std::vector<unsigned>({0, 1, 2, 2}));
+    CHECK_EQUAL_V(graph.outputs, std::vector<unsigned>({3}));
+    BOOST_CHECK(graph.weights.empty());
+
+    // The graph computes the expression
+    kernel_set<double> ks({"sum", "diff", "mul", "sig", "sin", "cos"});
+    for (auto seed = 0u; seed < 20u; ++seed) {
+        expression<double> ex1(3, 2, 2, 10, 11, 3, ks(), seed);
+        CHECK_CLOSE_V(evaluate_graph(ex1, active_graph(ex1), {0.1, 0.2, 0.3}), ex1({0.1, 0.2, 0.3}), 1e-10);
+        expression_weighted<double> ex2(3, 2, 2, 10, 11, 3, ks(), seed);
+        std::vector<double> weights(ex2.get_weights().size());
+        for (auto i = 0u; i < weights.size(); ++i) {
+            weights[i] = 0.1 * i - 1.;
+        }
+        ex2.set_weights(weights);
+        graph = active_graph(ex2);
+        BOOST_CHECK_EQUAL(graph.weights.size(), graph.inputs.size());
+        CHECK_CLOSE_V(evaluate_graph(ex2, graph, {0.1, 0.2, 0.3}), ex2({0.1, 0.2, 0.3}), 1e-10);
+    }
+
+    // Unary kernels only read their first input: n2 = sin(x0), whose second input n1 is inactive
+    kernel_set<double> unary_set({"sum", "sin"});
+    expression<double> ex3(1, 1, 1, 2, 2, 2, unary_set(), 0u);
+    ex3.set({0, 0, 0, 1, 0, 1, 2});
+    graph = active_graph(ex3);
+    CHECK_EQUAL_V(graph.nodes, std::vector<unsigned>({2}));
+    CHECK_EQUAL_V(graph.arities, std::vector<unsigned>({1}));
+    CHECK_EQUAL_V(graph.inputs, std::vector<unsigned>({0, 1}));
+
+    // gdual weights are exported via their constant coefficient
+    kernel_set<gdual_d> gdual_set({"sum", "mul"});
+    expression_weighted<gdual_d> gex(2, 1, 1, 3, 3, 2, gdual_set(), 0u);
+    gex.set({0, 0, 1, 1, 2, 2, 0, 0, 0, 3});
+    gex.set_weight(3, 1, gdual_d(0.5, "w", 1));
+    CHECK_EQUAL_V(active_graph(gex).weights, std::vector<double>({1., 1., 1., 0.5}));
+}
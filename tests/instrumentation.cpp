@@ -0,0 +1,82 @@
+#define DCGP_INSTRUMENTATION
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_instrumentation_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/instrumentation.hpp>
+#include <dcgp/kernel_set.hpp>
+
+using namespace dcgp;
+
+BOOST_AUTO_TEST_CASE(kernel_counters_test)
+{
+    BOOST_CHECK(instrumentation_enabled());
+    kernel_set<double> ks({"sum", "div"});
+    auto div = ks()[1];
+    BOOST_CHECK_EQUAL(div.get_counters().calls, 0u);
+    // Scalar calls
+    div({1., 2.});
+    div({1., 0.});
+    BOOST_CHECK_EQUAL(div.get_counters().calls, 2u);
+    BOOST_CHECK_EQUAL(div.get_counters().non_finite, 1u);
+    // Batch calls
+    std::vector<double> x = {1., 0., 2., 0.}, y = {0., 0., 1., 1.}, out(4u);
+    div({x.data(), y.data()}, out.data(), 4u);
+    BOOST_CHECK_EQUAL(div.get_counters().calls, 6u);
+    BOOST_CHECK_EQUAL(div.get_counters().non_finite, 3u);
+    // The counters are shared by the copies of the kernel
+    BOOST_CHECK_EQUAL(ks()[1].get_counters().calls, 6u);
+    BOOST_CHECK_EQUAL(ks()[0].get_counters().calls, 0u);
+    // But not by the kernels of other kernel sets
+    BOOST_CHECK_EQUAL(kernel_set<double>({"div"})()[0].get_counters().calls, 0u);
+    ks()[1].reset_counters();
+    BOOST_CHECK_EQUAL(div.get_counters().calls, 0u);
+    BOOST_CHECK_EQUAL(div.get_counters().nanoseconds, 0u);
+    BOOST_CHECK_EQUAL(div.get_counters().non_finite, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(expression_counters_test)
+{
+    kernel_set<double> ks({"sum", "mul"});
+    expression<double> ex(2, 1, 2, 3, 4, 2, ks(), 123u);
+    auto c = ex.get_counters();
+    BOOST_CHECK_EQUAL(c.evaluations, 0u);
+    BOOST_CHECK_EQUAL(c.mutations, 0u);
+    // The constructor updates the active nodes
+    BOOST_CHECK_EQUAL(c.update_active, 1u);
+    BOOST_CHECK_EQUAL(c.max_active_nodes, ex.get_active_nodes().size());
+    ex(std::vector<double>{1., 2.});
+    std::vector<double> x(10u, 1.), y(10u, 2.), out(10u);
+    ex(std::vector<const double *>{x.data(), y.data()}, std::vector<double *>{out.data()}, 10u);
+    // Symbolic evaluations are not counted
+    ex(std::vector<std::string>{"x", "y"});
+    BOOST_CHECK_EQUAL(ex.get_counters().evaluations, 11u);
+    // The kernels are called on the active nodes of all the points
+    unsigned kernel_calls = 0u, active_kernels = 0u;
+    for (const auto &f : ex.get_f()) {
+        kernel_calls += static_cast<unsigned>(f.get_counters().calls);
+    }
+    for (auto node : ex.get_active_nodes()) {
+        active_kernels += (node >= ex.get_n());
+    }
+    BOOST_CHECK_EQUAL(kernel_calls, 11u * active_kernels);
+    // Mutations
+    ex.mutate_active(3);
+    c = ex.get_counters();
+    BOOST_CHECK_EQUAL(c.mutations, 3u);
+    BOOST_CHECK_EQUAL(c.update_active, 4u);
+    BOOST_CHECK(c.active_nodes >= c.max_active_nodes);
+    BOOST_CHECK(c.max_active_nodes <= 2u * 3u + 2u);
+    // Copies share the counters
+    auto ex2 = ex;
+    ex2.mutate_active();
+    BOOST_CHECK_EQUAL(ex.get_counters().mutations, 4u);
+    ex.reset_counters();
+    c = ex2.get_counters();
+    BOOST_CHECK_EQUAL(c.evaluations, 0u);
+    BOOST_CHECK_EQUAL(c.mutations, 0u);
+    BOOST_CHECK_EQUAL(c.update_active, 0u);
+    BOOST_CHECK_EQUAL(c.active_nodes, 0u);
+    BOOST_CHECK_EQUAL(c.max_active_nodes, 0u);
+}
@@ -0,0 +1,183 @@
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_interval_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/bounds.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/interval.hpp>
+#include <dcgp/kernel_set.hpp>
+
+using namespace dcgp;
+
+const double inf = std::numeric_limits<double>::infinity();
+
+// Checks that [lower, upper] is contained in x and tight up to tol
+void check_bounds(const interval &x, double lower, double upper, double tol = 1e-12)
+{
+    BOOST_CHECK(x.lower() <= lower);
+    BOOST_CHECK(x.upper() >= upper);
+    BOOST_CHECK(x.lower() >= lower - tol * (1. + std::abs(lower)));
+    BOOST_CHECK(x.upper() <= upper + tol * (1. + std::abs(upper)));
+}
+
+BOOST_AUTO_TEST_CASE(arithmetic)
+{
+    interval a(1., 2.), b(-3., 4.), c(0.5);
+    BOOST_CHECK_THROW(interval(2., 1.), std::invalid_argument);
+    BOOST_CHECK(interval::empty().is_empty());
+    BOOST_CHECK(!a.is_empty());
+    BOOST_CHECK(a.is_finite());
+    BOOST_CHECK(a.contains(1.5));
+    BOOST_CHECK(!a.contains(2.5));
+    check_bounds(a + b, -2., 6.);
+    check_bounds(a - b, -3., 5.);
+    check_bounds(-b, -4., 3.);
+    check_bounds(a * b, -6., 8.);
+    check_bounds(b * b, -12., 16.);
+    check_bounds(a / interval(4., 8.), 0.125, 0.5);
+    check_bounds(b / interval(-2., -1.), -4., 3.);
+    check_bounds(a * c, 0.5, 1.);
+    check_bounds(1. + a, 2., 3.);
+    // Division by an interval containing zero
+    BOOST_CHECK_EQUAL((a / b).lower(), -inf);
+    BOOST_CHECK_EQUAL((a / b).upper(), inf);
+    BOOST_CHECK((a / interval(0.)).is_empty());
+    // 0 * inf is 0 for bounds
+    check_bounds(interval(0.) * interval(-inf, inf), 0., 0.);
+    // The empty interval propagates
+    BOOST_CHECK((a + interval::empty()).is_empty());
+    BOOST_CHECK((interval::empty() * a).is_empty());
+    auto d = a;
+    d += b;
+    d *= c;
+    check_bounds(d, -1., 3.);
+    check_bounds(hull(a, interval(5.)), 1., 5.);
+    // Infinite bounds are remembered, even when they disappear later
+    BOOST_CHECK(!interval(-inf, 1.).is_finite());
+    BOOST_CHECK(!interval::empty().is_finite());
+    auto e = sin(interval(1.) / b);
+    check_bounds(e, -1., 1.);
+    BOOST_CHECK(!e.is_finite());
+    BOOST_CHECK(sin(interval(1.) / a).is_finite());
+}
+
+BOOST_AUTO_TEST_CASE(functions)
+{
+    check_bounds(exp(interval(0., 1.)), 1., std::exp(1.));
+    check_bounds(log(interval(1., std::exp(2.))), 0., 2.);
+    BOOST_CHECK_EQUAL(log(interval(-1., 1.)).lower(), -inf);
+    BOOST_CHECK(log(interval(-2., -1.)).is_empty());
+    BOOST_CHECK_EQUAL(exp(interval(0., 1000.)).upper(), inf);
+    check_bounds(sin(interval(0., 1.)), 0., std::sin(1.));
+    check_bounds(sin(interval(0., 3.)), 0., 1.);
+    check_bounds(sin(interval(-10., 10.)), -1., 1.);
+    check_bounds(cos(interval(-1., 1.)), std::cos(1.), 1.);
+    check_bounds(cos(interval(3., 4.)), -1., std::max(std::cos(3.), std::cos(4.)));
+    check_bounds(cos(interval(4., 5.)), std::cos(4.), std::cos(5.));
+    check_bounds(cos(interval(-inf, 0.)), -1., 1.);
+    check_bounds(sig(interval(-1., 2.)), 1. / (1. + std::exp(1.)), 1. / (1. + std::exp(-2.)));
+    // The sigmoid is bounded even where the exponential overflows
+    check_bounds(sig(interval(-1000., 1000.)), 0., 1.);
+    BOOST_CHECK(sig(interval(-1000., 1000.)).is_finite());
+    BOOST_CHECK(!sig(interval(-inf, 0.)).is_finite());
+    // Random intervals contain the values of the function in random points
+    std::default_random_engine re(32);
+    for (auto trial = 0u; trial < 10000u; ++trial) {
+        auto x1 = std::uniform_real_distribution<double>(-10., 10.)(re);
+        auto x2 = std::uniform_real_distribution<double>(-10., 10.)(re);
+        interval x(std::min(x1, x2), std::max(x1, x2));
+        auto p = std::uniform_real_distribution<double>(x.lower(), x.upper())(re);
+        BOOST_CHECK(sin(x).contains(std::sin(p)));
+        BOOST_CHECK(cos(x).contains(std::cos(p)));
+        BOOST_CHECK(exp(x).contains(std::exp(p)));
+        BOOST_CHECK(sig(x).contains(1. / (1. + std::exp(-p))));
+        if (p > 0.) {
+            BOOST_CHECK(log(x).contains(std::log(p)));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kernels)
+{
+    kernel_set<interval> kernels({"sum", "diff", "mul", "div", "pdiv", "sig", "sin", "cos", "log", "exp"});
+    std::vector<interval> in{interval(1., 2.), interval(3., 4.)};
+    check_bounds(kernels[0](in), 4., 6.);
+    check_bounds(kernels[1](in), -3., -1.);
+    check_bounds(kernels[2](in), 3., 8.);
+    check_bounds(kernels[3](in), 0.25, 2. / 3.);
+    // pdiv is 1 only where the arguments can be equal
+    check_bounds(kernels[4](in), 0.25, 2. / 3.);
+    check_bounds(kernels[4]({interval(1., 3.), interval(2., 4.)}), 0.25, 1.5);
+    check_bounds(kernels[4]({interval(1., 3.), interval(-1., 4.)}), -inf, inf);
+    check_bounds(kernels[5](in), 1. / (1. + std::exp(-4.)), 1. / (1. + std::exp(-6.)));
+    check_bounds(kernels[9](in), std::exp(1.), std::exp(2.));
+    check_bounds(kernels[8](in), 0., std::log(2.));
+    // Batch versions
+    std::vector<interval> x{interval(1., 2.), interval(-1., 1.)}, y{interval(1., 2.), interval(2., 3.)}, out(2);
+    kernels[4]({x.data(), y.data()}, out.data(), 2u);
+    check_bounds(out[0], 0.5, 2.);
+    check_bounds(out[1], -0.5, 0.5);
+    kernels[5]({x.data(), y.data()}, out.data(), 2u);
+    check_bounds(out[1], 1. / (1. + std::exp(-1.)), 1. / (1. + std::exp(-4.)));
+    // Wide ranges do not make the sigmoid non finite
+    std::vector<interval> wide{interval(-1000., 1000.)};
+    BOOST_CHECK(kernels[5](wide).is_finite());
+    check_bounds(kernels[5](wide), 0., 1.);
+    kernels[5]({wide.data()}, out.data(), 1u);
+    BOOST_CHECK(out[0].is_finite());
+    check_bounds(out[0], 0., 1.);
+    kernels[8]({x.data()}, out.data(), 2u);
+    BOOST_CHECK_EQUAL(out[1].lower(), -inf);
+    kernels[9]({x.data()}, out.data(), 2u);
+    check_bounds(out[1], std::exp(-1.), std::exp(1.));
+}
+
+BOOST_AUTO_TEST_CASE(bounds)
+{
+    std::default_random_engine re(23);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "pdiv", "sig", "sin", "cos", "log", "exp"});
+    std::vector<interval> domain{interval(-1., 2.), interval(0.5, 1.)};
+    for (auto trial = 0u; trial < 100u; ++trial) {
+        expression<double> ex(2, 2, 3, 5, 6, 2, basic_set(), re());
+        expression_weighted<double> ex_w(2, 2, 3, 5, 6, 2, basic_set(), re());
+        std::vector<double> weights(ex_w.get_weights().size());
+        for (auto &w : weights) {
+            w = std::uniform_real_distribution<double>(-2., 2.)(re);
+        }
+        ex_w.set_weights(weights);
+        auto bounds = output_bounds(ex, domain);
+        auto bounds_w = output_bounds(ex_w, domain);
+        BOOST_CHECK_EQUAL(bounds.size(), 2u);
+        // The values in random points of the domain are within the bounds
+        for (auto k = 0u; k < 100u; ++k) {
+            std::vector<double> point{std::uniform_real_distribution<double>(-1., 2.)(re),
+                                      std::uniform_real_distribution<double>(0.5, 1.)(re)};
+            auto value = ex(point);
+            auto value_w = ex_w(point);
+            for (auto i = 0u; i < 2u; ++i) {
+                if (std::isfinite(value[i])) {
+                    BOOST_CHECK(bounds[i].contains(value[i]));
+                } else {
+                    BOOST_CHECK(!bounds[i].is_finite());
+                }
+                if (std::isfinite(value_w[i])) {
+                    BOOST_CHECK(bounds_w[i].contains(value_w[i]));
+                } else {
+                    BOOST_CHECK(!bounds_w[i].is_finite());
+                }
+            }
+        }
+    }
+    // A division by x, with x crossing zero, is detected
+    kernel_set<double> div_set({"div"});
+    expression<double> ex(1, 1, 1, 1, 1, 2, div_set(), 0u);
+    ex.set({0, 0, 0, 1});
+    BOOST_CHECK(output_bounds(ex, {interval(1., 2.)})[0].is_finite());
+    BOOST_CHECK(!output_bounds(ex, {interval(-1., 2.)})[0].is_finite());
+    BOOST_CHECK_THROW(output_bounds(ex, {interval(1., 2.), interval(1., 2.)}), std::invalid_argument);
+}
@@ -0,0 +1,132 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_jit_test
+#include <boost/test/unit_test.hpp>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/jit.hpp>
+#include <dcgp/kernel_set.hpp>
+
+#include "helpers.hpp"
+
+using namespace dcgp;
+
+// The shared objects of the tests are cached in a temporary directory, removed at the end
+struct temporary_cache {
+    temporary_cache()
+    {
+        char tmpl[] = "/tmp/dcgp_jit_test_XXXXXX";
+        BOOST_REQUIRE(::mkdtemp(tmpl));
+        dir = tmpl;
+        ::setenv("DCGP_JIT_CACHE_DIR", dir.c_str(), 1);
+    }
+    ~temporary_cache()
+    {
+        if (auto d = ::opendir(dir.c_str())) {
+            while (auto entry = ::readdir(d)) {
+                const std::string name(entry->d_name);
+                if (name != "." && name != "..") {
+                    std::remove((dir + "/" + name).c_str());
+                }
+            }
+            ::closedir(d);
+        }
+        ::rmdir(dir.c_str());
+        ::unsetenv("DCGP_JIT_CACHE_DIR");
+    }
+    std::string dir;
+};
+
+BOOST_FIXTURE_TEST_CASE(compiled_expression_evaluation, temporary_cache)
+{
+    std::default_random_engine re(123);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "pdiv", "sig", "sin", "cos", "exp"});
+    expression<double> ex(3, 2, 2, 20, 21, 2, basic_set(), 23u);
+    expression_weighted<double> exw(3, 2, 2, 20, 21, 2, basic_set(), 23u);
+    std::vector<double> weights(exw.get_weights().size());
+    for (auto &w : weights) {
+        w = std::uniform_real_distribution<double>(-1, 1)(re);
+    }
+    exw.set_weights(weights);
+
+    for (auto trial = 0u; trial < 5u; ++trial) {
+        ex.mutate_active(3);
+        exw.mutate_active(3);
+        compiled_expression cex(ex), cexw(exw);
+        BOOST_CHECK_EQUAL(cex.get_n(), 3u);
+        BOOST_CHECK_EQUAL(cex.get_m(), 2u);
+        // Compiling the same phenotype hits the cache
+        BOOST_CHECK_EQUAL(compiled_expression(ex).get_hash(), cex.get_hash());
+
+        std::vector<std::vector<double>> columns(3, std::vector<double>(10));
+        std::vector<std::vector<double>> out_columns(2, std::vector<double>(10));
+        for (auto i = 0u; i < 10u; ++i) {
+            std::vector<double> point(3);
+            for (auto j = 0u; j < 3u; ++j) {
+                point[j] = std::uniform_real_distribution<double>(-1, 1)(re);
+                columns[j][i] = point[j];
+            }
+            CHECK_CLOSE_V(cex(point), ex(point), 1e-10);
+            CHECK_CLOSE_V(cexw(point), exw(point), 1e-10);
+        }
+        cex({columns[0].data(), columns[1].data(), columns[2].data()}, {out_columns[0].data(), out_columns[1].data()},
+            10u);
+        for (auto i = 0u; i < 10u; ++i) {
+            CHECK_CLOSE_V(std::vector<double>{out_columns[0][i], out_columns[1][i]},
+                          ex({columns[0][i], columns[1][i], columns[2][i]}), 1e-10);
+        }
+    }
+    compiled_expression cex(ex);
+    BOOST_CHECK_THROW(cex({1., 2.}), std::invalid_argument);
+}
+
+BOOST_FIXTURE_TEST_CASE(quadratic_error_jit_threshold, temporary_cache)
+{
+    std::default_random_engine re(123);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    expression<double> ex(2, 1, 1, 15, 16, 2, basic_set(), 32u);
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 100u; ++i) {
+        auto x = std::uniform_real_distribution<double>(1, 2)(re);
+        auto y = std::uniform_real_distribution<double>(1, 2)(re);
+        in.push_back({x, y});
+        out.push_back({x * x - y});
+    }
+    auto interpreted = quadratic_error(ex, in, out);
+    // Below the threshold (interpreted) and above it (compiled)
+    BOOST_CHECK_CLOSE(quadratic_error_jit(ex, in, out), interpreted, 1e-10);
+    BOOST_CHECK_CLOSE(quadratic_error_jit(ex, in, out, 10u), interpreted, 1e-10);
+    BOOST_CHECK_THROW(quadratic_error_jit(ex, in, {}, 10u), std::invalid_argument);
+    // A non finite value gives NaN on both sides of the threshold
+    kernel_set<double> div_set({"div"});
+    expression<double> ex_div(1, 1, 1, 1, 1, 2, div_set(), 0u);
+    ex_div.set({0, 0, 0, 1});
+    BOOST_CHECK(std::isnan(quadratic_error_jit(ex_div, {{0.}, {1.}}, {{1.}, {1.}})));
+    BOOST_CHECK(std::isnan(quadratic_error_jit(ex_div, {{0.}, {1.}}, {{1.}, {1.}}, 1u)));
+}
+
+BOOST_FIXTURE_TEST_CASE(compiled_expression_untrusted_cache, temporary_cache)
+{
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    expression<double> ex(2, 1, 1, 15, 16, 2, basic_set(), 32u);
+    // A cache directory writable by others is never trusted
+    ::chmod(dir.c_str(), 0777);
+    BOOST_CHECK_THROW(compiled_expression{ex}, std::runtime_error);
+    ::chmod(dir.c_str(), 0700);
+    compiled_expression cex(ex);
+    // Neither is a shared object writable by others
+    const auto so_file = dir + "/dcgp_" + cex.get_hash() + ".so";
+    ::chmod(so_file.c_str(), 0766);
+    BOOST_CHECK_THROW(compiled_expression{ex}, std::runtime_error);
+}
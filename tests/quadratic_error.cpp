@@ -106,3 +106,59 @@ BOOST_AUTO_TEST_CASE(quadratic_error_obj_fun)
     BOOST_CHECK_EQUAL(test_qe2(3, 1, 1, 20, 21, 2, 20), audi::gdual_d(0));
     BOOST_CHECK_EQUAL(test_qe2(2, 2, 3, 10, 11, 2, 20), audi::gdual_d(0));
 }
+
+BOOST_AUTO_TEST_CASE(quadratic_error_cutoff)
+{
+    std::default_random_engine re(23);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 10000u; ++i) {
+        auto x = std::uniform_real_distribution<double>(-1., 1.)(re);
+        in.push_back({x});
+        out.push_back({x * x * x});
+    }
+    dataset data(in, out);
+    for (auto trial = 0u; trial < 50u; ++trial) {
+        expression<double> ex(1, 1, 1, 10, 11, 2, basic_set(), re());
+        const auto error = quadratic_error(ex, data);
+        if (!std::isfinite(error) || error == 0.) {
+            continue;
+        }
+        // Cutoffs above the error do not change anything
+        BOOST_CHECK_EQUAL(quadratic_error(ex, data, error), error);
+        BOOST_CHECK_EQUAL(quadratic_error(ex, data, 2. * error + 1.), error);
+        BOOST_CHECK_CLOSE(quadratic_error(ex, in, out, error), error, 1e-8);
+        // Cutoffs below flag the expression as worse
+        BOOST_CHECK(std::isinf(quadratic_error(ex, data, error * 0.999)));
+        BOOST_CHECK(std::isinf(quadratic_error(ex, in, out, error * 0.999)));
+    }
+    expression<double> ex(1, 1, 1, 10, 11, 2, basic_set(), re());
+    BOOST_CHECK_THROW(quadratic_error(ex, in, {{1.}}, 1.), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(quadratic_error_non_finite)
+{
+    kernel_set<double> basic_set({"sum", "div"});
+    std::vector<std::vector<double>> in, out;
+    for (auto i = 0u; i < 10000u; ++i) {
+        in.push_back({i - 5000.});
+        out.push_back({2. * (i - 5000.)});
+    }
+    dataset data(in, out);
+    // x / x + x is NaN in x = 0, x + x is finite everywhere
+    expression<double> ex(1, 1, 1, 2, 2, 2, basic_set(), 0u);
+    ex.set({1, 0, 0, 0, 1, 0, 2});
+    BOOST_CHECK(std::isnan(quadratic_error(ex, data)));
+    BOOST_CHECK(std::isnan(quadratic_error(ex, data, 1e300)));
+    ex.set({1, 0, 0, 0, 0, 0, 2});
+    BOOST_CHECK_EQUAL(quadratic_error(ex, data), 0.);
+    // The racing evaluation reports non finite candidates too
+    std::vector<expression<double>> candidates(2u, ex);
+    candidates[0].set({1, 0, 0, 0, 1, 0, 2});
+    racing_fitness racing(data, data.size(), 2., 23u);
+    auto fits = racing(candidates);
+    BOOST_CHECK(std::isnan(fits[0]));
+    BOOST_CHECK_EQUAL(fits[1], 0.);
+    // The points after the non finite value are counted as saved
+    BOOST_CHECK_EQUAL(racing.get_evaluations() + racing.get_saved_evaluations(), 2u * data.size());
+}
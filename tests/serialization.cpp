@@ -0,0 +1,152 @@
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_serialization_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/expression.hpp>
+#include <dcgp/expression_weighted.hpp>
+#include <dcgp/kernel_set.hpp>
+#include <dcgp/serialization.hpp>
+
+#include "helpers.hpp"
+
+using namespace dcgp;
+
+BOOST_AUTO_TEST_CASE(archive_expression)
+{
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div", "sig"});
+    std::vector<expression<double>> pop;
+    for (auto i = 0u; i < 10u; ++i) {
+        pop.emplace_back(3, 2, 2, 10, 11, 2, basic_set(), i);
+    }
+    auto buffer = to_archive(pop);
+    expression_archive archive(buffer.data(), buffer.size());
+    BOOST_CHECK_EQUAL(archive.size(), pop.size());
+    for (auto i = 0u; i < pop.size(); ++i) {
+        auto record = archive[i];
+        BOOST_CHECK(!record.weighted);
+        BOOST_CHECK_EQUAL(record.n, 3u);
+        BOOST_CHECK_EQUAL(record.m, 2u);
+        BOOST_CHECK_EQUAL(record.r, 2u);
+        BOOST_CHECK_EQUAL(record.c, 10u);
+        BOOST_CHECK_EQUAL(record.l, 11u);
+        BOOST_CHECK_EQUAL(record.arity, 2u);
+        CHECK_EQUAL_V(record.kernels, std::vector<std::string>({"sum", "diff", "mul", "div", "sig"}));
+        BOOST_CHECK_EQUAL(record.weights_size, 0u);
+        CHECK_EQUAL_V(std::vector<unsigned>(record.chromosome, record.chromosome + record.chromosome_size),
+                      pop[i].get());
+        auto ex = from_archive<expression<double>>(record);
+        CHECK_EQUAL_V(ex.get(), pop[i].get());
+        CHECK_EQUAL_V(ex({0.1, 0.2, 0.3}), pop[i]({0.1, 0.2, 0.3}));
+        // A weighted expression cannot be loaded from this record
+        BOOST_CHECK_THROW(from_archive<expression_weighted<double>>(record), std::invalid_argument);
+        // The kernels must match
+        BOOST_CHECK_THROW(from_archive<expression<double>>(record, kernel_set<double>({"sum", "diff"})()),
+                          std::invalid_argument);
+    }
+    BOOST_CHECK_THROW(archive[pop.size()], std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(archive_expression_weighted)
+{
+    std::default_random_engine re(123);
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<expression_weighted<double>> pop;
+    for (auto i = 0u; i < 5u; ++i) {
+        pop.emplace_back(2, 1, 3, 5, 6, 3, basic_set(), i);
+        std::vector<double> weights(pop.back().get_weights().size());
+        for (auto &w : weights) {
+            w = std::uniform_real_distribution<double>(-1, 1)(re);
+        }
+        pop.back().set_weights(weights);
+    }
+    const std::string filename = "dcgp_serialization_test.dcgp";
+    save_archive(filename, pop);
+    {
+        expression_archive archive(filename);
+        BOOST_CHECK_EQUAL(archive.size(), pop.size());
+        BOOST_CHECK(archive[0].weighted);
+        BOOST_CHECK_EQUAL(archive[0].weights_size, 5u * 3u * 3u);
+        // Weights are read in place, with no loss of precision
+        CHECK_EQUAL_V(std::vector<double>(archive[1].weights, archive[1].weights + archive[1].weights_size),
+                      pop[1].get_weights());
+    }
+    auto loaded = load_archive<expression_weighted<double>>(filename);
+    BOOST_CHECK_EQUAL(loaded.size(), pop.size());
+    for (auto i = 0u; i < pop.size(); ++i) {
+        CHECK_EQUAL_V(loaded[i].get(), pop[i].get());
+        CHECK_EQUAL_V(loaded[i].get_weights(), pop[i].get_weights());
+        CHECK_EQUAL_V(loaded[i]({0.3, -0.7}), pop[i]({0.3, -0.7}));
+    }
+    std::remove(filename.c_str());
+
+    // gdual weights are stored via their constant coefficient
+    kernel_set<gdual_d> gdual_set({"sum", "diff", "mul", "div"});
+    std::vector<expression_weighted<gdual_d>> gpop{expression_weighted<gdual_d>(2, 1, 3, 5, 6, 3, gdual_set(), 0u)};
+    gpop[0].set_weight(2, 0, gdual_d(0.5, "w", 1));
+    auto buffer = to_archive(gpop);
+    auto gex = from_archive<expression_weighted<gdual_d>>(expression_archive(buffer.data(), buffer.size())[0]);
+    BOOST_CHECK_EQUAL(gex.get_weight(2, 0).constant_cf(), 0.5);
+    CHECK_EQUAL_V(gex.get(), gpop[0].get());
+}
+
+BOOST_AUTO_TEST_CASE(archive_random_state)
+{
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<expression<double>> pop{expression<double>(2, 1, 3, 5, 6, 3, basic_set(), 42u)};
+    pop[0].mutate_active(3u);
+    auto buffer = to_archive(pop);
+    expression_archive archive(buffer.data(), buffer.size());
+    BOOST_CHECK(!archive[0].random_state.empty());
+    // The loaded expression mutates as the original one, whatever the seed
+    auto ex = from_archive<expression<double>>(archive[0], 123u);
+    for (auto i = 0u; i < 10u; ++i) {
+        pop[0].mutate_active(2u);
+        ex.mutate_active(2u);
+        CHECK_EQUAL_V(ex.get(), pop[0].get());
+    }
+    // Archives of version 1 store no random state: the seed is used
+    auto old = buffer;
+    old[12] = 1;
+    expression_archive old_archive(old.data(), old.size());
+    BOOST_CHECK(old_archive[0].random_state.empty());
+    auto ex1 = from_archive<expression<double>>(old_archive[0], 123u);
+    auto ex2 = from_archive<expression<double>>(old_archive[0], 123u);
+    ex1.mutate_active(5u);
+    ex2.mutate_active(5u);
+    CHECK_EQUAL_V(ex1.get(), ex2.get());
+    // A corrupted random state
+    auto wrong = buffer;
+    wrong.back() = 'x';
+    BOOST_CHECK_THROW(from_archive<expression<double>>(expression_archive(wrong.data(), wrong.size())[0]),
+                      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(archive_corrupted)
+{
+    kernel_set<double> basic_set({"sum", "diff", "mul", "div"});
+    std::vector<expression<double>> pop{expression<double>(2, 1, 3, 5, 6, 3, basic_set(), 0u)};
+    auto buffer = to_archive(pop);
+    // Truncated archives
+    for (auto size : {0u, 10u, 30u, 40u, static_cast<unsigned>(buffer.size() - 1u)}) {
+        BOOST_CHECK_THROW(expression_archive(buffer.data(), size)[0], std::invalid_argument);
+    }
+    // Wrong magic
+    auto wrong = buffer;
+    wrong[0] = 'X';
+    BOOST_CHECK_THROW(expression_archive(wrong.data(), wrong.size()), std::invalid_argument);
+    // Unsupported version
+    wrong = buffer;
+    wrong[12] = 100;
+    BOOST_CHECK_THROW(expression_archive(wrong.data(), wrong.size()), std::invalid_argument);
+    // Invalid chromosome
+    wrong = buffer;
+    expression_archive archive(wrong.data(), wrong.size());
+    const_cast<std::uint32_t *>(archive[0].chromosome)[0] = 100u;
+    BOOST_CHECK_THROW(from_archive<expression<double>>(archive[0]), std::invalid_argument);
+    // Missing files
+    BOOST_CHECK_THROW(expression_archive("not_a_file.dcgp"), std::runtime_error);
+}
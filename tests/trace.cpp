@@ -0,0 +1,90 @@
+#define DCGP_TRACE
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#define BOOST_TEST_MODULE dcgp_trace_test
+#include <boost/test/unit_test.hpp>
+
+#include <dcgp/dataset.hpp>
+#include <dcgp/expression.hpp>
+#include <dcgp/fitness_functions.hpp>
+#include <dcgp/kernel_set.hpp>
+#include <dcgp/trace.hpp>
+
+using namespace dcgp;
+
+// Number of occurrences of text in the trace
+std::size_t count(const std::string &trace, const std::string &text)
+{
+    std::size_t retval = 0u;
+    for (auto pos = trace.find(text); pos != std::string::npos; pos = trace.find(text, pos + 1u)) {
+        ++retval;
+    }
+    return retval;
+}
+
+std::string current_trace()
+{
+    std::ostringstream oss;
+    write_trace(oss);
+    return oss.str();
+}
+
+BOOST_AUTO_TEST_CASE(scopes)
+{
+    BOOST_CHECK(trace_enabled());
+    clear_trace();
+    {
+        trace_scope outer("outer", "test");
+        trace_scope inner("inner", "test");
+    }
+    auto trace = current_trace();
+    BOOST_CHECK_EQUAL(count(trace, "\"name\": \"outer\", \"cat\": \"test\", \"ph\": \"X\""), 1u);
+    BOOST_CHECK_EQUAL(count(trace, "\"name\": \"inner\", \"cat\": \"test\", \"ph\": \"X\""), 1u);
+    BOOST_CHECK_EQUAL(count(trace, "\"dropped_events\": 0"), 1u);
+    // The fitness functions are traced
+    kernel_set<double> ks({"sum", "mul"});
+    expression<double> ex(1, 1, 1, 10, 11, 2, ks(), 123u);
+    dataset data({{1.}, {2.}, {3.}}, {{1.}, {4.}, {9.}});
+    quadratic_error(ex, data);
+    BOOST_CHECK_EQUAL(count(current_trace(), "\"name\": \"quadratic_error\""), 1u);
+    clear_trace();
+    BOOST_CHECK_EQUAL(count(current_trace(), "\"ph\": \"X\""), 0u);
+    BOOST_CHECK_THROW(clear_trace(0u), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(threads)
+{
+    clear_trace();
+    std::vector<std::thread> threads;
+    for (auto t = 0u; t < 4u; ++t) {
+        threads.emplace_back([]() {
+            for (auto i = 0u; i < 10u; ++i) {
+                trace_scope scope("work", "test");
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    // The events of the threads are kept after they end, each on its own track
+    const auto trace = current_trace();
+    BOOST_CHECK_EQUAL(count(trace, "\"name\": \"work\""), 40u);
+    BOOST_CHECK(count(trace, "\"name\": \"thread_name\"") >= 5u);
+}
+
+BOOST_AUTO_TEST_CASE(ring_buffer)
+{
+    // When the buffer is full the oldest events are overwritten
+    clear_trace(3u);
+    for (auto i = 0u; i < 5u; ++i) {
+        trace_scope scope(i < 2u ? "old" : "new", "test");
+    }
+    const auto trace = current_trace();
+    BOOST_CHECK_EQUAL(count(trace, "\"name\": \"old\""), 0u);
+    BOOST_CHECK_EQUAL(count(trace, "\"name\": \"new\""), 3u);
+    BOOST_CHECK_EQUAL(count(trace, "\"dropped_events\": 2"), 1u);
+    clear_trace();
+}